@@ -21,6 +21,8 @@
 #include "SceneQueen.h"
 #include "SceneTurn.h"
 #include "SceneSandbox.h"
+#include "MessagePool.h"
+#include "PostOffice.h"
 
 GLFWwindow* m_window;
 const unsigned char FPS = 60; // FPS of this game
@@ -71,7 +73,7 @@ int Application::GetWindowHeight()
 }
 
 Application::Application()
-	: m_scene{}, m_timer{}
+	: m_scene{}, m_timer{}, m_headless(false), m_headlessSeed(1), m_headlessMatches(1), m_headlessMaxTime(240.f), m_headlessPoolReserve(24), m_headlessJobThreads(0), m_headlessBufferedAI(false), m_headlessDeferredMessages(false), m_mapSize(30)
 {
 }
 
@@ -106,6 +108,7 @@ bool Application::LoadScene()
 		std::cout << "14. Week 14. SceneReversi" << std::endl;
 		std::cout << "15. Week 16. SceneFlappyBird" << std::endl;
 		std::cout << "16. Assignment 1" << std::endl;
+		std::cout << "17. Assignment 1 (Headless)" << std::endl;
 		std::cout << "0. Exit" << std::endl;
 		std::cout << "Enter your choice: ";
 
@@ -187,6 +190,12 @@ bool Application::LoadScene()
 		case 16:
 			std::cout << "You selected SceneAssignment1.\n";
 			m_scene = new SceneSandbox();
+			static_cast<SceneSandbox*>(m_scene)->SetMap(m_mapSize, m_mapFile);
+			bContinue = false;
+			break;
+		case 17:
+			std::cout << "You selected SceneAssignment1 (Headless).\n";
+			m_headless = true;
 			bContinue = false;
 			break;
 		case 0:
@@ -207,6 +216,14 @@ bool Application::LoadScene()
 
 void Application::Init()
 {
+	// Headless runs never open a window, but the scene still reads the window size for its world width
+	if (m_headless)
+	{
+		m_width = 1000;
+		m_height = 600;
+		return;
+	}
+
 	//Set the error callback
 	glfwSetErrorCallback(error_callback);
 
@@ -265,6 +282,11 @@ void Application::Init()
 
 void Application::Run()
 {
+	if (m_headless)
+	{
+		RunHeadless();
+		return;
+	}
 	if (m_scene == NULL)
 		return;
 
@@ -275,6 +297,7 @@ void Application::Run()
 	while (!glfwWindowShouldClose(m_window) && !IsKeyPressed(VK_ESCAPE))
 	{
 		m_scene->Update(m_timer.getElapsedTime());
+		MessagePool::GetInstance()->Reset();
 		m_scene->Render();
 		//Swap buffers
 		glfwSwapBuffers(m_window);
@@ -289,15 +312,121 @@ void Application::Run()
 
 void Application::Exit()
 {
+	if (m_headless)
+		return;
 	//Close OpenGL window and terminate GLFW
 	glfwDestroyWindow(m_window);
 	//Finalize and clean up GLFW
 	glfwTerminate();
 }
 
+void Application::SetHeadless(unsigned seed, int matches, float maxTime, int poolReserve, int jobThreads, bool bufferedAI, bool deferredMessages)
+{
+	m_headless = true;
+	m_headlessSeed = seed;
+	m_headlessMatches = matches;
+	m_headlessMaxTime = maxTime;
+	m_headlessPoolReserve = poolReserve;
+	m_headlessJobThreads = jobThreads;
+	m_headlessBufferedAI = bufferedAI;
+	m_headlessDeferredMessages = deferredMessages;
+}
+
+void Application::SetMap(int gridSize, const std::string& file)
+{
+	m_mapSize = gridSize;
+	m_mapFile = file;
+}
+
+/**
+ *	Run Assignment 1 without a window: fixed dt, fixed seed per match, no frame limiter.
+ *	Each match runs until a queen dies or m_headlessMaxTime simulated seconds pass.
+ */
+void Application::RunHeadless()
+{
+	const double dt = 1.0 / FPS; // same step the windowed frame limiter aims for
+
+	for (int match = 0; match < m_headlessMatches; ++match)
+	{
+		unsigned seed = m_headlessSeed + match;
+		SceneSandbox* sandbox = new SceneSandbox();
+		sandbox->SetHeadless(true, seed);
+		sandbox->SetPoolReserve(m_headlessPoolReserve);
+		sandbox->SetJobThreads(m_headlessJobThreads);
+		sandbox->SetBufferedAI(m_headlessBufferedAI);
+		sandbox->SetDeferredMessages(m_headlessDeferredMessages);
+		sandbox->SetMap(m_mapSize, m_mapFile);
+		sandbox->Init();
+		MessagePool* messages = MessagePool::GetInstance();
+		messages->ResetStats();
+		MessageQueue::Stats queued = PostOffice::GetInstance()->GetDeferredQueue().GetStats();
+
+		StopWatch timer;
+		timer.startTimer();
+		long long ticks = 0;
+		while (!sandbox->IsSimulationEnded() && sandbox->GetSimulationTime() < m_headlessMaxTime)
+		{
+			sandbox->Update(dt);
+			messages->Reset();
+			++ticks;
+		}
+		double elapsed = timer.getElapsedTime();
+
+		int winner = sandbox->GetWinner();
+		std::cout << "Match " << match << " seed " << seed << ": ";
+		if (!sandbox->IsSimulationEnded())
+			std::cout << "TIMEOUT";
+		else
+			std::cout << "WINNER " << (winner == 0 ? "RED" : winner == 1 ? "BLUE" : "DRAW");
+		std::cout << " | sim " << sandbox->GetSimulationTime() << "s | " << ticks << " ticks in " << elapsed * 1000.0 << "ms | "
+			<< (elapsed > 0.0 ? ticks / elapsed : 0.0) << " ticks/s" << std::endl;
+		const GameObjectPool& pool = sandbox->GetPool();
+		std::cout << "  pool: peak " << pool.GetPeakTotal() << " active / " << pool.GetCapacityTotal() << " allocated, "
+			<< pool.GetGrowCount() << " mid-match allocations";
+		if (sandbox->GetInactiveAfterFlush() > 0)
+			std::cout << "  NOT RELEASED: up to " << sandbox->GetInactiveAfterFlush() << " inactive objects left in the active list after Flush";
+		std::cout << std::endl;
+		const PathRequestQueue::Stats& paths = sandbox->GetPathRequests().GetStats();
+		std::cout << "  paths: " << paths.completed << " searched, " << paths.merged << " merged, " << paths.dropped << " dropped, peak queue "
+			<< paths.peakDepth << ", latency avg " << (paths.completed > 0 ? paths.latencyFramesTotal / paths.completed : 0.0) << " frames / "
+			<< (paths.completed > 0 ? paths.latencyMsTotal / paths.completed : 0.0) << "ms, max " << paths.latencyFramesMax << " frames / "
+			<< paths.latencyMsMax << "ms" << std::endl;
+		const PathCache& cache = sandbox->GetPathCache();
+		const PathCache::Stats& cacheStats = cache.GetStats();
+		std::cout << "  path cache: " << cacheStats.hits << "/" << cacheStats.lookups << " hits ("
+			<< (cacheStats.lookups > 0 ? 100.0 * cacheStats.hits / cacheStats.lookups : 0.0) << "%, " << cacheStats.suffixHits << " from route tails), "
+			<< cacheStats.invalidations << " invalidations, " << cacheStats.evictions << " evictions, " << cache.GetEntryCount() << " routes / " << cache.GetCellCount() << " cells in "
+			<< cache.GetMemoryUsage() / 1024 << "KB" << std::endl;
+		const FlowFieldCache& fields = sandbox->GetFlowFields();
+		std::cout << "  flow fields: " << fields.GetBuildCount() << " builds (" << fields.GetBuildCells() << " cells), "
+			<< fields.GetRepairCount() << " repairs (" << fields.GetRepairCells() << " cells), " << fields.GetEvictionCount() << " evictions, "
+			<< fields.GetFieldCount() << " fields in " << fields.GetMemoryUsage() / 1024 << "KB" << std::endl;
+		std::cout << "  explored: red " << sandbox->GetExploredCells(0) << ", blue " << sandbox->GetExploredCells(1) << " of "
+			<< sandbox->GetOpenCells() << " open cells" << std::endl;
+		std::cout << "  messages: " << messages->GetTotal() << " sent, peak " << messages->GetPeakFrameCount() << " in a frame, "
+			<< messages->GetBlockCount() << " x " << MessagePool::BLOCK_SIZE / 1024 << "KB blocks |";
+		for (int i = 0; i < Message::NUM_MESSAGE_TYPES; ++i)
+		{
+			Message::MESSAGE_TYPE type = static_cast<Message::MESSAGE_TYPE>(i);
+			if (messages->GetTotalCount(type) > 0) std::cout << " " << Message::GetTypeName(type) << " " << messages->GetTotalCount(type);
+		}
+		std::cout << std::endl;
+		if (m_headlessDeferredMessages)
+		{
+			const MessageQueue::Stats& deferred = PostOffice::GetInstance()->GetDeferredQueue().GetStats();
+			std::cout << "  deferred: " << deferred.queued - queued.queued << " queued, " << deferred.coalesced - queued.coalesced << " coalesced, "
+				<< deferred.delivered - queued.delivered << " delivered in " << deferred.batches - queued.batches << " batches" << std::endl;
+		}
+
+		sandbox->Exit();
+		delete sandbox;
+	}
+}
+
 void Application::Iterate()
 {
 	m_scene->Update(0);
+	MessagePool::GetInstance()->Reset();
 	m_scene->Render();
 	glfwSwapBuffers(m_window);
 	glfwPollEvents();
@@ -2,6 +2,7 @@
 #define APPLICATION_H
 
 #include "timer.h"
+#include <string>
 
 class Scene;
 class Application
@@ -25,6 +26,11 @@ public:
 
 	void Iterate();
 
+	// Headless batch runs of Assignment 1 (no window, fixed dt, no frame limiter)
+	void SetHeadless(unsigned seed, int matches, float maxTime, int poolReserve = 24, int jobThreads = 0, bool bufferedAI = false, bool deferredMessages = false);
+	void RunHeadless();
+	void SetMap(int gridSize, const std::string& file = ""); // sandbox layout, see SceneSandbox::SetMap
+
 private:
 	Application();
 	~Application();
@@ -32,6 +38,17 @@ private:
 	//Declare a window object
 	StopWatch m_timer;
 	Scene* m_scene;
+
+	bool m_headless;
+	unsigned m_headlessSeed;
+	int m_headlessMatches;
+	float m_headlessMaxTime;
+	int m_headlessPoolReserve;
+	int m_headlessJobThreads;
+	bool m_headlessBufferedAI;
+	bool m_headlessDeferredMessages;
+	int m_mapSize;
+	std::string m_mapFile;
 };
 
 #endif
\ No newline at end of file
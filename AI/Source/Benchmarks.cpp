@@ -0,0 +1,985 @@
+#include "Benchmarks.h"
+#include "GridPathfinder.h"
+#include "HierarchicalPathfinder.h"
+#include "FlowField.h"
+#include "SandboxMap.h"
+#include "GameObject.h"
+#include "SpatialGrid.h"
+#include "UnitStore.h"
+#include "GameObjectPool.h"
+#include "JobSystem.h"
+#include "ConcreteMessages.h"
+#include "MessageDispatcher.h"
+#include "MessagePool.h"
+#include "PostOffice.h"
+#include "SceneData.h"
+#include "MyMath.h"
+#include "timer.h"
+#include <iostream>
+#include <iomanip>
+#include <queue>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	struct BenchMap
+	{
+		const char* name;
+		int size;
+		BitGrid wallGrid;
+		BitGrid foodGrid;
+		BitGrid blocked; //walls and food, what the pathfinders see
+		std::vector<MazePt> starts;
+		std::vector<MazePt> ends;
+	};
+
+	bool IsOccupied(const BenchMap& map, int x, int y)
+	{
+		if (x < 0 || x >= map.size || y < 0 || y >= map.size) return true;
+		return map.blocked.Get(x, y);
+	}
+
+	//SceneSandbox::FindPath as it was before GridPathfinder: fresh visited/parent/queue every call
+	std::vector<MazePt> LegacyFindPath(const BenchMap& map, MazePt start, MazePt end)
+	{
+		std::vector<MazePt> path;
+		if (start.x == end.x && start.y == end.y) return path;
+		if (IsOccupied(map, end.x, end.y)) return path;
+
+		std::vector<bool> visited(map.size * map.size, false);
+		std::vector<int> parent(map.size * map.size, -1);
+		std::queue<MazePt> q;
+
+		q.push(start);
+		visited[start.y * map.size + start.x] = true;
+
+		bool found = false;
+		int dx[] = { 0, 0, -1, 1 }; int dy[] = { 1, -1, 0, 0 };
+
+		while (!q.empty())
+		{
+			MazePt curr = q.front(); q.pop();
+			if (curr.x == end.x && curr.y == end.y) { found = true; break; }
+			for (int i = 0; i < 4; ++i)
+			{
+				int nx = curr.x + dx[i]; int ny = curr.y + dy[i];
+				if (!IsOccupied(map, nx, ny))
+				{
+					int nIdx = ny * map.size + nx;
+					if (!visited[nIdx]) { visited[nIdx] = true; parent[nIdx] = curr.y * map.size + curr.x; q.push(MazePt(nx, ny)); }
+				}
+			}
+		}
+		if (found) { int currIdx = end.y * map.size + end.x; int startIdx = start.y * map.size + start.x; while (currIdx != startIdx) { path.push_back(MazePt(currIdx % map.size, currIdx / map.size)); currIdx = parent[currIdx]; } std::reverse(path.begin(), path.end()); }
+		return path;
+	}
+
+	MazePt RandomFreeCell(const BenchMap& map)
+	{
+		while (true)
+		{
+			MazePt pt(Math::RandIntMinMax(0, map.size - 1), Math::RandIntMinMax(0, map.size - 1));
+			if (!IsOccupied(map, pt.x, pt.y))
+				return pt;
+		}
+	}
+
+	//only connected pairs: an unreachable goal floods the whole map whatever the algorithm,
+	//and units in the sandbox only ever path to cells they can reach
+	void AddQueries(BenchMap& map, int count)
+	{
+		map.blocked = map.wallGrid;
+		map.blocked.Or(map.foodGrid);
+		GridPathfinder pathfinder;
+		pathfinder.Init(&map.blocked);
+		pathfinder.SetAlgorithm(GridPathfinder::ALGO_BFS);
+		while (static_cast<int>(map.starts.size()) < count)
+		{
+			MazePt start = RandomFreeCell(map);
+			MazePt end = RandomFreeCell(map);
+			if (pathfinder.FindPath(start, end).empty())
+				continue;
+			map.starts.push_back(start);
+			map.ends.push_back(end);
+		}
+	}
+
+	//SceneSandbox's built-in layout, plus a scatter of food tiles
+	void BuildSandboxMap(BenchMap& map)
+	{
+		SandboxMap layout;
+		layout.CreateDefault(30);
+		map.name = "sandbox 30x30";
+		map.size = layout.GetSize();
+		map.wallGrid = layout.GetWalls();
+		map.foodGrid.Init(map.size, map.size, true);
+		for (int i = 0; i < 20; ++i)
+		{
+			int x = Math::RandIntMinMax(2, map.size - 3); int y = Math::RandIntMinMax(2, map.size - 3);
+			if (layout.IsNearColony(x, y, 1)) continue;
+			if (!map.wallGrid.Get(x, y)) map.foodGrid.Set(x, y, true);
+		}
+		AddQueries(map, 2000);
+	}
+
+	//open field with random obstacles and a few long walls, so paths have to detour
+	void BuildRandomMap(BenchMap& map, const char* name, int size, int queries)
+	{
+		map.name = name;
+		map.size = size;
+		map.wallGrid.Init(size, size, true);
+		map.foodGrid.Init(size, size, true);
+		for (int i = 0; i < size * size / 5; ++i)
+			map.wallGrid.Set(Math::RandIntMinMax(0, size - 1), Math::RandIntMinMax(0, size - 1), true);
+		for (int i = 0; i < size / 16; ++i)
+		{
+			int fixed = Math::RandIntMinMax(0, size - 1);
+			int from = Math::RandIntMinMax(0, size / 2);
+			int to = from + size / 2;
+			for (int k = from; k < to; ++k)
+			{
+				if (i % 2 == 0) map.wallGrid.Set(k, fixed, true);
+				else map.wallGrid.Set(fixed, k, true);
+			}
+		}
+		AddQueries(map, queries);
+	}
+
+	//a step at a time from start to end through open cells
+	bool IsValidPath(const BenchMap& map, MazePt start, MazePt end, const std::vector<MazePt>& path)
+	{
+		MazePt prev = start;
+		for (size_t i = 0; i < path.size(); ++i)
+		{
+			int dist = std::abs(path[i].x - prev.x) + std::abs(path[i].y - prev.y);
+			if (dist != 1 || IsOccupied(map, path[i].x, path[i].y))
+				return false;
+			prev = path[i];
+		}
+		return prev.x == end.x && prev.y == end.y;
+	}
+
+	//HPA* is not exact, so instead of length mismatches it reports how much longer its paths are
+	void BenchmarkHierarchical(const BenchMap& map, const std::vector<size_t>& shortest)
+	{
+		StopWatch timer;
+		timer.startTimer();
+		ClusterGraph graph;
+		graph.Init(&map.blocked);
+		double buildTime = timer.getElapsedTime();
+		HierarchicalPathfinder pathfinder;
+		pathfinder.Init(&graph);
+
+		long long nodes = 0;
+		size_t length = 0, optimal = 0;
+		int invalid = 0;
+		timer.startTimer();
+		for (size_t q = 0; q < map.starts.size(); ++q)
+		{
+			std::vector<MazePt> path = pathfinder.FindPath(map.starts[q], map.ends[q]);
+			nodes += pathfinder.GetNodesExpanded();
+			if (!IsValidPath(map, map.starts[q], map.ends[q], path)) ++invalid;
+			length += path.size();
+			optimal += shortest[q];
+		}
+		double elapsed = timer.getElapsedTime();
+		std::cout << "  " << std::left << std::setw(12) << "HPA*" << std::right
+			<< std::setw(10) << std::fixed << std::setprecision(2) << elapsed * 1000000.0 / map.starts.size() << " us/query"
+			<< std::setw(10) << nodes / static_cast<long long>(map.starts.size()) << " nodes/query, "
+			<< (optimal ? 100.0 * length / optimal - 100.0 : 0.0) << "% longer, " << graph.GetNodeCount() << " entrances built in "
+			<< buildTime * 1000.0 << "ms" << (invalid ? "  INVALID PATHS: " : "") << (invalid ? std::to_string(invalid) : "") << std::endl;
+
+		//a food tile depleting: the cell opens and its cluster is repaired
+		BitGrid foodGrid = map.foodGrid;
+		BitGrid blocked = map.blocked;
+		graph.Init(&blocked);
+		const int REPAIRS = 200;
+		timer.startTimer();
+		for (int i = 0; i < REPAIRS; ++i)
+		{
+			int x = Math::RandIntMinMax(0, map.size - 1), y = Math::RandIntMinMax(0, map.size - 1);
+			foodGrid.Set(x, y, !foodGrid.Get(x, y));
+			blocked.Set(x, y, foodGrid.Get(x, y) || map.wallGrid.Get(x, y));
+			graph.RepairCell(x, y);
+		}
+		std::cout << "  " << std::left << std::setw(12) << "HPA* repair" << std::right << std::setw(10)
+			<< timer.getElapsedTime() * 1000000.0 / REPAIRS << " us/cell changed" << std::endl;
+	}
+
+	//walls going up and down one at a time under a flow field: repair in place vs rebuilding it,
+	//then every query start's distance, and every cell's step, is checked against a field built from scratch
+	void BenchmarkFlowFieldRepair(const BenchMap& map)
+	{
+		BitGrid wallGrid = map.wallGrid;
+		BitGrid blocked = map.blocked;
+		int goal = map.ends[0].y * map.size + map.ends[0].x;
+		FlowFieldCache repaired;
+		repaired.Init(&blocked);
+		repaired.GetDistance(goal, map.starts[0]);
+
+		const int CHANGES = 200;
+		StopWatch timer;
+		timer.startTimer();
+		for (int i = 0; i < CHANGES; ++i)
+		{
+			int cell = Math::RandIntMinMax(0, map.size * map.size - 1);
+			if (cell == goal) continue;
+			int x = cell % map.size, y = cell / map.size;
+			wallGrid.Set(x, y, !wallGrid.Get(x, y));
+			blocked.Set(x, y, wallGrid.Get(x, y) || map.foodGrid.Get(x, y));
+			repaired.UpdateCell(cell);
+		}
+		double repairTime = timer.getElapsedTime();
+
+		FlowFieldCache rebuilt;
+		rebuilt.Init(&blocked);
+		timer.startTimer();
+		rebuilt.GetDistance(goal, map.starts[0]);
+		double buildTime = timer.getElapsedTime();
+
+		int mismatches = 0;
+		for (size_t q = 0; q < map.starts.size(); ++q)
+		{
+			if (repaired.GetDistance(goal, map.starts[q]) != rebuilt.GetDistance(goal, map.starts[q]))
+				++mismatches;
+		}
+		int stepMismatches = 0;
+		for (int y = 0; y < map.size; ++y)
+		{
+			for (int x = 0; x < map.size; ++x)
+			{
+				MazePt repairedStep(-1, -1), rebuiltStep(-1, -1);
+				bool repairedFound = repaired.GetNextCell(goal, MazePt(x, y), repairedStep);
+				bool rebuiltFound = rebuilt.GetNextCell(goal, MazePt(x, y), rebuiltStep);
+				if (repairedFound != rebuiltFound || repairedStep.x != rebuiltStep.x || repairedStep.y != rebuiltStep.y)
+					++stepMismatches;
+			}
+		}
+		std::cout << "  " << std::left << std::setw(12) << "field repair" << std::right << std::setw(10)
+			<< repairTime * 1000000.0 / CHANGES << " us/cell changed, " << repaired.GetRepairCells() / CHANGES << " cells/repair vs "
+			<< buildTime * 1000000.0 << " us, " << rebuilt.GetBuildCells() << " cells to rebuild"
+			<< (mismatches ? "  DISTANCE MISMATCHES: " : "") << (mismatches ? std::to_string(mismatches) : "")
+			<< (stepMismatches ? "  STEP MISMATCHES: " : "") << (stepMismatches ? std::to_string(stepMismatches) : "") << std::endl;
+	}
+
+	//every open cell reachable from the first query's start: a cell at a time with a BFS queue
+	//vs BitGrid::Flood growing 64 cells per word operation, both counted the same way
+	void BenchmarkReachability(const BenchMap& map)
+	{
+		const int RUNS = 20;
+		MazePt start = map.starts[0];
+		StopWatch timer;
+		timer.startTimer();
+		int bfsCount = 0;
+		for (int run = 0; run < RUNS; ++run)
+		{
+			std::vector<bool> visited(map.size * map.size, false);
+			std::queue<MazePt> q;
+			q.push(start);
+			visited[start.y * map.size + start.x] = true;
+			bfsCount = 1;
+			int dx[] = { 0, 0, -1, 1 }; int dy[] = { 1, -1, 0, 0 };
+			while (!q.empty())
+			{
+				MazePt curr = q.front(); q.pop();
+				for (int i = 0; i < 4; ++i)
+				{
+					int nx = curr.x + dx[i]; int ny = curr.y + dy[i];
+					if (map.blocked.Get(nx, ny) || visited[ny * map.size + nx]) continue;
+					visited[ny * map.size + nx] = true;
+					++bfsCount;
+					q.push(MazePt(nx, ny));
+				}
+			}
+		}
+		double bfsTime = timer.getElapsedTime() / RUNS;
+
+		BitGrid reached;
+		timer.startTimer();
+		for (int run = 0; run < RUNS; ++run)
+		{
+			reached.Init(map.size, map.size, false);
+			reached.Set(start.x, start.y, true);
+			reached.Flood(map.blocked);
+		}
+		double floodTime = timer.getElapsedTime() / RUNS;
+		int floodCount = reached.Count();
+		std::cout << "  " << std::left << std::setw(12) << "reachable" << std::right << std::setw(10)
+			<< bfsTime * 1000000.0 << " us BFS vs " << floodTime * 1000000.0 << " us bit flood, " << floodCount << " cells"
+			<< (floodCount != bfsCount ? "  COUNT MISMATCH: " : "") << (floodCount != bfsCount ? std::to_string(bfsCount) : "") << std::endl;
+	}
+
+	void BenchmarkMap(const BenchMap& map)
+	{
+		const int NUM_ALGORITHMS = 3;
+		const char* names[NUM_ALGORITHMS] = { "legacy BFS", "BFS", "A*" };
+		GridPathfinder pathfinder;
+		pathfinder.Init(&map.blocked);
+
+		std::vector<size_t> expected(map.starts.size(), 0);
+		std::cout << map.name << " (" << map.starts.size() << " queries)" << std::endl;
+		for (int algo = 0; algo < NUM_ALGORITHMS; ++algo)
+		{
+			if (algo > 0)
+				pathfinder.SetAlgorithm(static_cast<GridPathfinder::ALGORITHM>(algo - 1));
+			long long nodes = 0;
+			int mismatches = 0;
+			StopWatch timer;
+			timer.startTimer();
+			for (size_t q = 0; q < map.starts.size(); ++q)
+			{
+				size_t length;
+				if (algo == 0)
+				{
+					length = LegacyFindPath(map, map.starts[q], map.ends[q]).size();
+					expected[q] = length;
+				}
+				else
+				{
+					length = pathfinder.FindPath(map.starts[q], map.ends[q]).size();
+					nodes += pathfinder.GetNodesExpanded();
+					if (length != expected[q])
+						++mismatches;
+				}
+			}
+			double elapsed = timer.getElapsedTime();
+
+			std::cout << "  " << std::left << std::setw(12) << names[algo] << std::right
+				<< std::setw(10) << std::fixed << std::setprecision(2) << elapsed * 1000000.0 / map.starts.size() << " us/query";
+			if (algo > 0)
+				std::cout << std::setw(10) << nodes / static_cast<long long>(map.starts.size()) << " nodes/query"
+				<< (mismatches ? "  LENGTH MISMATCHES: " : "") << (mismatches ? std::to_string(mismatches) : "");
+			std::cout << std::endl;
+		}
+		BenchmarkHierarchical(map, expected);
+		BenchmarkFlowFieldRepair(map);
+		BenchmarkReachability(map);
+	}
+
+	struct UnitWorld
+	{
+		int noGrid;
+		std::vector<GameObject*> units;
+		std::vector<Vector3> startPos;
+		std::vector<MazePt> startWaypoint;
+	};
+
+	//count units on a square map with about one unit per cell, each heading for a cell up to 3 away
+	void BuildUnitWorld(UnitWorld& world, int count)
+	{
+		world.noGrid = static_cast<int>(std::sqrt(static_cast<float>(count)));
+		for (int i = 0; i < count; ++i)
+		{
+			GameObject* go = new GameObject(GameObject::GO_WORKER);
+			go->active = true;
+			go->teamID = i % 2;
+			go->isCarryingResource = true;
+			go->detectionRange = 2.f;
+			go->moveSpeed = 1.f;
+			go->pos.Set(Math::RandFloatMinMax(0.f, world.noGrid - 0.01f), Math::RandFloatMinMax(0.f, world.noGrid - 0.01f), 0.f);
+			MazePt waypoint(Math::Clamp(static_cast<int>(go->pos.x) + Math::RandIntMinMax(-3, 3), 0, world.noGrid - 1), Math::Clamp(static_cast<int>(go->pos.y) + Math::RandIntMinMax(-3, 3), 0, world.noGrid - 1));
+			world.units.push_back(go);
+			world.startPos.push_back(go->pos);
+			world.startWaypoint.push_back(waypoint);
+		}
+	}
+
+	void ResetUnitWorld(UnitWorld& world)
+	{
+		for (size_t i = 0; i < world.units.size(); ++i)
+		{
+			GameObject* go = world.units[i];
+			go->pos = world.startPos[i];
+			go->prevPos = go->pos;
+			go->idleTimer = 0.f;
+			go->path.assign(1, world.startWaypoint[i]);
+		}
+	}
+
+	//send the unit for its path point at the cursor, or the centre of its cell
+	void QueueMove(UnitStore& store, GameObject* go)
+	{
+		int unit = UnitStore::GetSlot(go);
+		if (store.HasPath(go)) { MazePt nextPt = go->path[store.pathNext[unit]]; store.Queue(unit, nextPt.x + 0.5f, nextPt.y + 0.5f, true); }
+		else store.Queue(unit, static_cast<int>(store.posX[unit]) + 0.5f, static_cast<int>(store.posY[unit]) + 0.5f, false);
+	}
+
+	//the same start in a store: the units' entries, as SceneSandbox's pool keeps them, each queued once
+	void ResetUnitStore(UnitStore& store, const UnitWorld& world)
+	{
+		store.Clear();
+		for (size_t i = 0; i < world.units.size(); ++i)
+		{
+			GameObject* go = world.units[i];
+			store.Add(go);
+			int unit = UnitStore::GetSlot(go);
+			store.SetPos(go, world.startPos[i]);
+			store.prevX[unit] = world.startPos[i].x; store.prevY[unit] = world.startPos[i].y;
+			store.idle[unit] = 0.f;
+			store.SetSpeed(go, go->moveSpeed);
+			store.StartPath(go);
+			QueueMove(store, go);
+		}
+	}
+
+	//the movement step of SceneSandbox::Update before UnitStore, one GameObject at a time
+	void LegacyMove(GameObject* go, float step)
+	{
+		if ((go->pos - go->prevPos).LengthSquared() < 0.001f) {
+			go->idleTimer += step;
+			if (go->idleTimer > 3.0f) { go->idleTimer = 0.f; go->path.clear(); }
+		}
+		else go->idleTimer = 0.f;
+		go->prevPos = go->pos;
+
+		int gridX = static_cast<int>(go->pos.x); int gridY = static_cast<int>(go->pos.y);
+		Vector3 moveVec(0, 0, 0);
+		if (!go->path.empty()) {
+			MazePt nextPt = go->path.front();
+			Vector3 nextPos(nextPt.x + 0.5f, nextPt.y + 0.5f, go->pos.z);
+			Vector3 dir = nextPos - go->pos; float dist = dir.Length(); moveVec = dir;
+			if (dist <= step) { go->pos = nextPos; go->path.erase(go->path.begin()); }
+			else { go->pos += dir.Normalized() * step; }
+		}
+		else { Vector3 center = Vector3(gridX + 0.5f, gridY + 0.5f, go->pos.z); if ((go->pos - center).LengthSquared() > 0.001f) { Vector3 dir = center - go->pos; moveVec = dir; float dist = dir.Length(); if (dist <= step) go->pos = center; else go->pos += dir.Normalized() * step; } }
+		if (moveVec.LengthSquared() > 0.001f) go->viewDir = moveVec.Normalized();
+	}
+
+	//the same step with the store: the stuck timers and the stepping run over the packed arrays, and in between
+	//only the units that reached their waypoint or got stuck read their path again
+	void PackedMove(UnitStore& store, float step)
+	{
+		store.UpdateIdle(step, 3.0f);
+		const GameObjectRegistry* registry = GameObjectRegistry::GetInstance();
+		const unsigned char wanted = UnitStore::FLAG_ARRIVED | UnitStore::FLAG_STUCK;
+		const unsigned long long wantedBytes = 0x0101010101010101ull * wanted;
+		const int count = store.GetCount();
+		for (int unit = 0; unit < count; ++unit)
+		{
+			//most entries have neither flag: skip them eight at a time
+			unsigned long long word;
+			if ((unit & 7) == 0 && unit + 8 <= count && (std::memcpy(&word, &store.flags[unit], sizeof(word)), (word & wantedBytes) == 0))
+			{
+				unit += 7;
+				continue;
+			}
+			if (!(store.flags[unit] & wanted))
+				continue;
+			GameObject* go = registry->GetObject(unit);
+			if (store.flags[unit] & UnitStore::FLAG_STUCK) { go->path.clear(); store.StartPath(go); }
+			QueueMove(store, go);
+		}
+		store.Integrate(step, 1.f);
+	}
+
+	//SceneSandbox::DetectNearbyEntities before the packed entry arrays
+	GameObject* LegacyNearestEnemy(const SpatialGrid& grid, int noGrid, GameObject* go)
+	{
+		GameObject* nearest = nullptr;
+		float nearestEnemyDistSq = FLT_MAX;
+		int gridX = static_cast<int>(go->pos.x); int gridY = static_cast<int>(go->pos.y);
+		for (int dy = -2; dy <= 2; ++dy)
+		{
+			for (int dx = -2; dx <= 2; ++dx)
+			{
+				int checkX = gridX + dx; int checkY = gridY + dy;
+				if (checkX < 0 || checkX >= noGrid || checkY < 0 || checkY >= noGrid)
+					continue;
+				int cellKey = checkY * noGrid + checkX;
+				for (GameObject* const* it = grid.CellBegin(cellKey); it != grid.CellEnd(cellKey); ++it)
+				{
+					GameObject* other = *it;
+					if (!other->active || other == go)
+						continue;
+					if (other->teamID != go->teamID && other->teamID >= 0 && go->teamID >= 0)
+					{
+						if (other->type == GameObject::GO_FOOD)
+							continue;
+						float distSq = (go->pos - other->pos).LengthSquared();
+						if (distSq < go->detectionRange * go->detectionRange && distSq < nearestEnemyDistSq)
+						{
+							nearestEnemyDistSq = distSq;
+							nearest = other;
+						}
+					}
+				}
+			}
+		}
+		return nearest;
+	}
+
+	void BenchmarkUnitLayout(int count, JobSystem& jobs)
+	{
+		const int TICKS = 20;
+		const float STEP = 0.05f;
+		UnitWorld world;
+		BuildUnitWorld(world, count);
+		std::cout << count << " units on " << world.noGrid << "x" << world.noGrid << std::endl;
+		StopWatch timer;
+
+		//movement: both layouts start from the same positions and must end in the same place
+		ResetUnitWorld(world);
+		UnitStore store;
+		ResetUnitStore(store, world);
+		timer.startTimer();
+		for (int t = 0; t < TICKS; ++t)
+			PackedMove(store, STEP);
+		double packedMove = timer.getElapsedTime();
+
+		timer.startTimer();
+		for (int t = 0; t < TICKS; ++t)
+			for (size_t i = 0; i < world.units.size(); ++i)
+				LegacyMove(world.units[i], STEP);
+		double legacyMove = timer.getElapsedTime();
+		int moveMismatches = 0;
+		for (size_t i = 0; i < world.units.size(); ++i)
+			if (!(world.units[i]->pos == store.GetPos(world.units[i])))
+				++moveMismatches;
+
+		//the kernels on their own, each pass on a copy of the store with every unit queued:
+		//scalar references vs SSE, and Integrate split across the threads. a short stuck limit so some timers trip
+		for (size_t i = 0; i < world.units.size(); ++i)
+			world.units[i]->path.assign(1, world.startWaypoint[i]); //the store's cursors are into the paths LegacyMove used up
+		UnitStore queued = store;
+		for (size_t i = 0; i < world.units.size(); ++i)
+			QueueMove(queued, world.units[i]);
+		const float STUCK_LIMIT = STEP * TICKS * 0.5f;
+		double idleScalar = 0.0, idle = 0.0, integrateScalar = 0.0, integrate = 0.0, integrateParallel = 0.0;
+		bool kernelMatches = true;
+		for (int t = 0; t < TICKS; ++t)
+		{
+			UnitStore scalarStore = queued, kernelStore = queued, parallelStore = queued;
+			timer.startTimer();
+			scalarStore.UpdateIdleScalar(STEP, STUCK_LIMIT);
+			idleScalar += timer.getElapsedTime();
+			timer.startTimer();
+			kernelStore.UpdateIdle(STEP, STUCK_LIMIT);
+			idle += timer.getElapsedTime();
+			timer.startTimer();
+			scalarStore.IntegrateScalar(STEP, 1.f);
+			integrateScalar += timer.getElapsedTime();
+			timer.startTimer();
+			kernelStore.Integrate(STEP, 1.f);
+			integrate += timer.getElapsedTime();
+			parallelStore.UpdateIdle(STEP, STUCK_LIMIT);
+			timer.startTimer();
+			jobs.ParallelFor(parallelStore.GetCount(), 4096, [&parallelStore, STEP](int begin, int end) { parallelStore.Integrate(begin, end, STEP, 1.f); });
+			integrateParallel += timer.getElapsedTime();
+			if (scalarStore.posX != kernelStore.posX || scalarStore.posY != kernelStore.posY || scalarStore.viewX != kernelStore.viewX || scalarStore.viewY != kernelStore.viewY
+				|| scalarStore.idle != kernelStore.idle || scalarStore.prevX != kernelStore.prevX || scalarStore.pathNext != kernelStore.pathNext || scalarStore.flags != kernelStore.flags)
+				kernelMatches = false;
+			if (parallelStore.posX != kernelStore.posX || parallelStore.posY != kernelStore.posY || parallelStore.pathNext != kernelStore.pathNext || parallelStore.flags != kernelStore.flags)
+				kernelMatches = false;
+		}
+
+		//sensing: every unit looks for the nearest enemy within 2 cells
+		SpatialGrid grid;
+		grid.Init(world.noGrid, 1.f, &store);
+		grid.Update(world.units);
+		std::vector<GameObject*> expectedEnemy(world.units.size(), nullptr);
+		timer.startTimer();
+		for (size_t i = 0; i < world.units.size(); ++i)
+			expectedEnemy[i] = LegacyNearestEnemy(grid, world.noGrid, world.units[i]);
+		double legacySense = timer.getElapsedTime();
+		int senseMismatches = 0;
+		timer.startTimer();
+		grid.SyncEntries();
+		for (size_t i = 0; i < world.units.size(); ++i)
+			if (grid.FindNearestEnemy(world.units[i], 4.f, 2) != expectedEnemy[i])
+				++senseMismatches;
+		double packedSense = timer.getElapsedTime();
+		std::vector<GameObject*> found(world.units.size(), nullptr);
+		timer.startTimer();
+		grid.SyncEntries();
+		jobs.ParallelFor(count, 256, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i)
+				found[i] = grid.FindNearestEnemy(world.units[i], 4.f, 2);
+		});
+		double parallelSense = timer.getElapsedTime();
+		if (found != expectedEnemy)
+			senseMismatches = -1;
+
+		std::cout << std::fixed << std::setprecision(3)
+			<< "  move    GameObject loop " << std::setw(8) << legacyMove * 1000.0 / TICKS << " ms/tick"
+			<< "   UnitStore " << std::setw(8) << packedMove * 1000.0 / TICKS << " ms/tick"
+			<< (moveMismatches ? "  POSITION MISMATCHES: " : "") << (moveMismatches ? std::to_string(moveMismatches) : "") << std::endl
+			<< "  idle             scalar " << std::setw(8) << idleScalar * 1000.0 / TICKS << " ms/tick"
+			<< "   UpdateIdle" << std::setw(8) << idle * 1000.0 / TICKS << " ms/tick" << std::endl
+			<< "  integrate        scalar " << std::setw(8) << integrateScalar * 1000.0 / TICKS << " ms/tick"
+			<< "   Integrate " << std::setw(8) << integrate * 1000.0 / TICKS << " ms/tick"
+			<< "   " << jobs.GetThreadCount() << " threads " << std::setw(8) << integrateParallel * 1000.0 / TICKS << " ms/tick"
+			<< (kernelMatches ? "" : "  KERNEL MISMATCH") << std::endl
+			<< "  sense   GameObject loop " << std::setw(8) << legacySense * 1000.0 << " ms/pass"
+			<< "   packed    " << std::setw(8) << packedSense * 1000.0 << " ms/pass"
+			<< "   " << jobs.GetThreadCount() << " threads " << std::setw(8) << parallelSense * 1000.0 << " ms/pass"
+			<< (senseMismatches ? "  TARGET MISMATCHES" : "") << std::endl;
+
+		for (size_t i = 0; i < world.units.size(); ++i)
+			delete world.units[i];
+	}
+
+	//SceneSandbox's handler set, reached through the dynamic_cast chain Handle used to be and through a MessageDispatcher
+	class BenchReceiver
+	{
+	public:
+		BenchReceiver() : handled(0)
+		{
+			dispatcher.Register<MessageSpawnUnit, &BenchReceiver::OnSpawnUnit>();
+			dispatcher.Register<MessageResourceDepleted, &BenchReceiver::OnResourceDepleted>();
+			dispatcher.Register<MessageUnitDied, &BenchReceiver::OnUnitDied>();
+			dispatcher.Register<MessageResourceDelivered, &BenchReceiver::OnResourceDelivered>();
+			dispatcher.Register<MessageEnemySpotted, &BenchReceiver::OnEnemySpotted>();
+			dispatcher.Register<MessageRequestHelp, &BenchReceiver::OnRequestHelp>();
+		}
+
+		bool HandleChain(Message* message)
+		{
+			MessageSpawnUnit* msgSpawn = dynamic_cast<MessageSpawnUnit*>(message); if (msgSpawn) return OnSpawnUnit(msgSpawn);
+			MessageResourceDepleted* msgDepleted = dynamic_cast<MessageResourceDepleted*>(message); if (msgDepleted) return OnResourceDepleted(msgDepleted);
+			MessageUnitDied* msgDied = dynamic_cast<MessageUnitDied*>(message); if (msgDied) return OnUnitDied(msgDied);
+			MessageResourceDelivered* msgRes = dynamic_cast<MessageResourceDelivered*>(message); if (msgRes) return OnResourceDelivered(msgRes);
+			MessageEnemySpotted* msgEnemy = dynamic_cast<MessageEnemySpotted*>(message); if (msgEnemy) return OnEnemySpotted(msgEnemy);
+			MessageRequestHelp* msgHelp = dynamic_cast<MessageRequestHelp*>(message); if (msgHelp) return OnRequestHelp(msgHelp);
+			return true;
+		}
+		bool HandleTable(Message* message) { return dispatcher.Dispatch(this, message, true); }
+
+		bool OnSpawnUnit(MessageSpawnUnit* message) { handled += message->type; return true; }
+		bool OnResourceDepleted(MessageResourceDepleted*) { handled += 1; return true; }
+		bool OnUnitDied(MessageUnitDied* message) { handled += message->teamID; return true; }
+		bool OnResourceDelivered(MessageResourceDelivered* message) { handled += message->resourceAmount; return true; }
+		bool OnEnemySpotted(MessageEnemySpotted* message) { handled += message->teamID + 2; return true; }
+		bool OnRequestHelp(MessageRequestHelp* message) { handled += message->teamID + 3; return true; }
+
+		long long handled;
+		MessageDispatcher<BenchReceiver> dispatcher;
+	};
+
+	//SceneSandbox's enemy alert: every soldier of the team near the enemy is pointed at it
+	class AlertReceiver : public ObjectBase
+	{
+	public:
+		AlertReceiver(const std::vector<GameObject*>& units) : tested(0), m_units(units) {}
+		bool Handle(Message* message)
+		{
+			MessageEnemySpotted* msgEnemy = MessageCast<MessageEnemySpotted>(message);
+			if (!msgEnemy) return false;
+			for (GameObject* go : m_units) {
+				++tested;
+				if (go->teamID == msgEnemy->teamID && (go->pos - msgEnemy->enemy->pos).LengthSquared() < 16.f) go->targetEnemy = msgEnemy->enemy;
+			}
+			return true;
+		}
+
+		long long tested;
+
+	private:
+		const std::vector<GameObject*>& m_units;
+	};
+
+	//SceneSandbox::FindReceivers over a bare grid
+	class BenchLocator : public ReceiverLocator
+	{
+	public:
+		BenchLocator(const SpatialGrid& grid, float gridSize) : found(0), m_grid(grid), m_gridSize(gridSize) {}
+		void FindReceivers(const RadiusAddress& area, std::vector<ObjectBase*>& receivers)
+		{
+			int radius = static_cast<int>(std::ceil(area.radius / m_gridSize)) + 1;
+			m_hits.clear();
+			m_grid.FindInRadius(area.centre, area.radius * area.radius, radius, m_hits);
+			for (GameObject* go : m_hits)
+			{
+				if (area.teamID >= 0 && go->teamID != area.teamID) continue;
+				if (area.typeMask && !(area.typeMask & (1u << go->type))) continue;
+				receivers.push_back(go);
+				++found;
+			}
+		}
+
+		long long found;
+
+	private:
+		const SpatialGrid& m_grid;
+		float m_gridSize;
+		std::vector<GameObject*> m_hits;
+	};
+
+	//GameObject::Handle's object counting as it was, four dynamic_casts deep for a shark
+	bool LegacyCountHandle(const GameObject* go, Message* message)
+	{
+		if (dynamic_cast<MessageCheckActive*>(message) != nullptr)
+			return go->active;
+		else if (dynamic_cast<MessageCheckFish*>(message) != nullptr)
+			return go->active && go->type == GameObject::GO_FISH;
+		else if (dynamic_cast<MessageCheckFood*>(message) != nullptr)
+			return go->active && go->type == GameObject::GO_FISHFOOD;
+		else if (dynamic_cast<MessageCheckShark*>(message) != nullptr)
+			return go->active && go->type == GameObject::GO_SHARK;
+		return false;
+	}
+}
+
+void RunPathfinderBenchmark()
+{
+	Math::InitRNG(1220);
+	BenchMap maps[4];
+	BuildSandboxMap(maps[0]);
+	BuildRandomMap(maps[1], "random 256x256", 256, 200);
+	BuildRandomMap(maps[2], "random 1024x1024", 1024, 20);
+	BuildRandomMap(maps[3], "random 2048x2048", 2048, 10);
+	for (int i = 0; i < 4; ++i)
+		BenchmarkMap(maps[i]);
+}
+
+void RunMessageBenchmark()
+{
+	Math::InitRNG(1220);
+	const int COUNT = 1000000;
+
+	//the six types SceneSandbox handles plus two it ignores, which fall through every cast in the chain
+	MessageSpawnUnit spawn(nullptr, MessageSpawnUnit::UNIT_SCOUT, Vector3());
+	MessageResourceDepleted depleted(nullptr);
+	MessageUnitDied died(nullptr, 1, GameObject::GO_WORKER);
+	MessageResourceDelivered delivered(nullptr, 2, 0);
+	MessageEnemySpotted spotted(nullptr, nullptr, 1);
+	MessageRequestHelp help(nullptr, Vector3(), 0);
+	MessageQueenThreat threat(nullptr, 0);
+	MessageTerritoryClaimed claimed(1, Vector3());
+	Message* kinds[] = { &spawn, &depleted, &died, &delivered, &spotted, &help, &threat, &claimed };
+	std::vector<Message*> stream(COUNT);
+	for (int i = 0; i < COUNT; ++i)
+		stream[i] = kinds[Math::RandIntMinMax(0, 7)];
+
+	BenchReceiver receiver;
+	StopWatch timer;
+	timer.startTimer();
+	for (int i = 0; i < COUNT; ++i)
+		receiver.HandleChain(stream[i]);
+	double chainTime = timer.getElapsedTime();
+	long long chainHandled = receiver.handled;
+	receiver.handled = 0;
+	timer.startTimer();
+	for (int i = 0; i < COUNT; ++i)
+		receiver.HandleTable(stream[i]);
+	double tableTime = timer.getElapsedTime();
+
+	std::cout << "scene messages (" << COUNT << ", 8 types)" << std::endl << std::fixed << std::setprecision(2)
+		<< "  dynamic_cast chain " << std::setw(8) << chainTime * 1e9 / COUNT << " ns/message" << std::endl
+		<< "  dispatch table     " << std::setw(8) << tableTime * 1e9 / COUNT << " ns/message"
+		<< (receiver.handled != chainHandled ? "  HANDLER MISMATCH" : "") << std::endl;
+
+	//the Week04/05 scenes' per-frame count: four check messages to every object
+	const int OBJECTS = 250000;
+	std::vector<GameObject*> objects(OBJECTS);
+	for (int i = 0; i < OBJECTS; ++i)
+	{
+		objects[i] = new GameObject(static_cast<GameObject::GAMEOBJECT_TYPE>(Math::RandIntMinMax(GameObject::GO_FISH, GameObject::GO_FISHFOOD)));
+		objects[i]->active = Math::RandIntMinMax(0, 3) != 0;
+	}
+	MessageCheckActive checkActive;
+	MessageCheckFish checkFish;
+	MessageCheckFood checkFood;
+	MessageCheckShark checkShark;
+	Message* checks[] = { &checkActive, &checkFish, &checkFood, &checkShark };
+	int legacyCounts[4] = {}, counts[4] = {};
+	timer.startTimer();
+	for (int i = 0; i < OBJECTS; ++i)
+		for (int c = 0; c < 4; ++c)
+			legacyCounts[c] += LegacyCountHandle(objects[i], checks[c]);
+	double legacyTime = timer.getElapsedTime();
+	timer.startTimer();
+	for (int i = 0; i < OBJECTS; ++i)
+		for (int c = 0; c < 4; ++c)
+			counts[c] += objects[i]->Handle(checks[c]);
+	double switchTime = timer.getElapsedTime();
+	bool countsMatch = std::equal(counts, counts + 4, legacyCounts);
+
+	std::cout << "object counts (" << OBJECTS << " objects x 4 checks)" << std::endl
+		<< "  dynamic_cast chain " << std::setw(8) << legacyTime * 1e9 / OBJECTS << " ns/object" << std::endl
+		<< "  type switch        " << std::setw(8) << switchTime * 1e9 / OBJECTS << " ns/object"
+		<< (countsMatch ? "" : "  COUNT MISMATCH") << std::endl;
+
+	for (int i = 0; i < OBJECTS; ++i)
+		delete objects[i];
+
+	//a fight seen by a crowd: every frame 30 scouts report one of 2 enemies to a receiver scanning 2000 units,
+	//delivered as sent vs queued and coalesced down to one alert per enemy
+	const int UNITS = 2000, FRAMES = 200, ALERTS = 30;
+	std::vector<GameObject*> units(UNITS);
+	for (int i = 0; i < UNITS; ++i)
+	{
+		units[i] = new GameObject(GameObject::GO_SOLDIER);
+		units[i]->teamID = i % 2;
+		units[i]->pos.Set(Math::RandFloatMinMax(0.f, 20.f), Math::RandFloatMinMax(0.f, 20.f), 0.f);
+	}
+	GameObject* enemies[2] = { units[0], units[1] };
+	AlertReceiver alerts(units);
+	PostOffice* postOffice = PostOffice::GetInstance();
+	MessagePool* pool = MessagePool::GetInstance();
+	postOffice->Register("Bench", &alerts);
+	double alertTime[2];
+	long long alertTested[2];
+	for (int deferred = 0; deferred < 2; ++deferred)
+	{
+		postOffice->SetDeferred(Message::MSG_ENEMY_SPOTTED, deferred == 1);
+		alerts.tested = 0;
+		timer.startTimer();
+		for (int frame = 0; frame < FRAMES; ++frame)
+		{
+			for (int a = 0; a < ALERTS; ++a)
+				postOffice->Send("Bench", pool->Create<MessageEnemySpotted>(units[a], enemies[a % 2], 1 - a % 2));
+			postOffice->DeliverDeferred();
+			pool->Reset();
+		}
+		alertTime[deferred] = timer.getElapsedTime();
+		alertTested[deferred] = alerts.tested;
+	}
+	postOffice->ClearDeferred();
+	std::cout << "enemy alerts (" << ALERTS << " a frame about 2 enemies, " << UNITS << " units)" << std::endl
+		<< "  delivered on send  " << std::setw(8) << alertTime[0] * 1e6 / FRAMES << " us/frame, " << alertTested[0] / FRAMES << " units tested" << std::endl
+		<< "  deferred+coalesced " << std::setw(8) << alertTime[1] * 1e6 / FRAMES << " us/frame, " << alertTested[1] / FRAMES << " units tested" << std::endl;
+
+	//the same sends by name (a map lookup each) and by interned handle
+	MessageCheckActive ping;
+	AddressHandle bench = postOffice->GetAddress("Bench");
+	timer.startTimer();
+	for (int i = 0; i < COUNT; ++i)
+		postOffice->Send("Bench", &ping);
+	double byName = timer.getElapsedTime();
+	timer.startTimer();
+	for (int i = 0; i < COUNT; ++i)
+		postOffice->Send(bench, &ping);
+	double byHandle = timer.getElapsedTime();
+	postOffice->Unregister(bench);
+	std::cout << "addressing (" << COUNT << " sends)" << std::endl
+		<< "  by name            " << std::setw(8) << byName * 1e9 / COUNT << " ns/send" << std::endl
+		<< "  by handle          " << std::setw(8) << byHandle * 1e9 / COUNT << " ns/send" << std::endl;
+
+	//a queen alarm: each of team 0's soldiers (1 unit in 20) subscribed to the team channel vs picking them out of every unit
+	AddressHandle alarm = postOffice->GetAddress("BenchAlarm");
+	GameObject* queen = new GameObject(GameObject::GO_QUEEN);
+	queen->teamID = 0;
+	queen->active = true;
+	queen->targetEnemy = units[1];
+	int defenders = 0;
+	for (int i = 0; i < UNITS; ++i)
+	{
+		units[i]->active = true;
+		if (i % 20 == 0)
+		{
+			postOffice->Subscribe(alarm, units[i]);
+			++defenders;
+		}
+		else
+			units[i]->type = GameObject::GO_WORKER;
+	}
+	MessageQueenThreat alarmMessage(queen, 0);
+	int scanned = 0, reached = 0;
+	timer.startTimer();
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+		for (int i = 0; i < UNITS; ++i)
+		{
+			GameObject* go = units[i];
+			if (!go->active || go->teamID != 0 || go->type != GameObject::GO_SOLDIER) continue;
+			go->targetEnemy = nullptr;
+			scanned += go->Handle(&alarmMessage);
+		}
+	}
+	double scanTime = timer.getElapsedTime();
+	timer.startTimer();
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+		for (int i = 0; i < UNITS; i += 20)
+			units[i]->targetEnemy = nullptr; //so every defender takes the target again, as in the scan
+		reached += postOffice->Send(alarm, &alarmMessage);
+	}
+	double channelTime = timer.getElapsedTime();
+	postOffice->Unregister(alarm);
+	delete queen;
+	for (int i = 0; i < UNITS; ++i)
+		delete units[i];
+	std::cout << "queen alarm (" << defenders << " defenders of " << UNITS << " units)" << std::endl
+		<< "  scan every unit    " << std::setw(8) << scanTime * 1e6 / FRAMES << " us/alarm, " << scanned / FRAMES << " defenders alerted" << std::endl
+		<< "  team channel       " << std::setw(8) << (channelTime * 1e6) / FRAMES << " us/alarm" << (reached == FRAMES ? "" : "  NOT DELIVERED") << std::endl;
+
+	//help requests 4 cells out on a 100x100 map, each unit picked out of the world vs the spatial grid's neighbourhood,
+	//at twice and ten times the population. the units come from a pool sized for 100k, as SetPoolReserve allows,
+	//and the last 1% are spawned after the grid's update
+	const int NO_GRID = 100, REQUESTS = 1000, RESERVE = 100000;
+	const float GRID_SIZE = 1.f, HELP_RADIUS = 4.f * GRID_SIZE;
+	const unsigned soldiers = (1u << GameObject::GO_SOLDIER) | (1u << GameObject::GO_STRONG_ANT_SOLDIER);
+	const GameObject::GAMEOBJECT_TYPE crowdTypes[] = { GameObject::GO_WORKER, GameObject::GO_SOLDIER, GameObject::GO_STRONG_ANT_SOLDIER };
+	std::cout << "help requests (" << REQUESTS << ", radius 4 cells, pool of " << RESERVE << ")" << std::endl;
+	for (int population = UNITS; population <= UNITS * 10; population *= 5)
+	{
+		std::vector<GameObject*> pooled;
+		UnitStore store;
+		GameObjectPool unitPool;
+		SpatialGrid grid;
+		unitPool.Init(&pooled);
+		unitPool.SetUnitStore(&store);
+		SceneData::GetInstance()->SetUnits(&store); //GameObject::Handle points the soldiers there
+		grid.Init(NO_GRID, GRID_SIZE, &store);
+		unitPool.SetSpatialGrid(&grid);
+		for (int t = 0; t < 3; ++t)
+			unitPool.Reserve(crowdTypes[t], RESERVE / 3);
+		const int lateSpawns = population / 100;
+		for (int i = 0; i < population; ++i)
+		{
+			if (i == population - lateSpawns)
+				grid.Update(pooled);
+			GameObject* go = unitPool.Acquire(crowdTypes[i % 3]);
+			go->teamID = i % 2;
+			store.SetPos(go, Vector3(Math::RandFloatMinMax(0.f, NO_GRID * GRID_SIZE), Math::RandFloatMinMax(0.f, NO_GRID * GRID_SIZE), 0.f));
+		}
+		const std::vector<GameObject*>& crowd = unitPool.GetActive();
+		BenchLocator locator(grid, GRID_SIZE);
+		postOffice->SetLocator(&locator);
+		std::vector<MessageRequestHelp*> requests(REQUESTS);
+		for (int r = 0; r < REQUESTS; ++r)
+			requests[r] = new MessageRequestHelp(nullptr, Vector3(Math::RandFloatMinMax(0.f, NO_GRID * GRID_SIZE), Math::RandFloatMinMax(0.f, NO_GRID * GRID_SIZE), 0.f), r % 2);
+
+		long long scanReached = 0, areaReached = 0;
+		timer.startTimer();
+		for (int r = 0; r < REQUESTS; ++r)
+		{
+			const MessageRequestHelp* help = requests[r];
+			for (GameObject* go : crowd)
+			{
+				if (!go->active || go->teamID != help->teamID) continue;
+				if ((go->type == GameObject::GO_SOLDIER || go->type == GameObject::GO_STRONG_ANT_SOLDIER) && (store.GetPos(go) - help->position).LengthSquared() < HELP_RADIUS * HELP_RADIUS) { store.SetTarget(go, help->position); ++scanReached; }
+			}
+		}
+		double helpScanTime = timer.getElapsedTime();
+		timer.startTimer();
+		for (int r = 0; r < REQUESTS; ++r)
+		{
+			RadiusAddress area = { requests[r]->position, HELP_RADIUS, requests[r]->teamID, soldiers };
+			postOffice->SendRadius(area, requests[r]);
+		}
+		double helpAreaTime = timer.getElapsedTime();
+		areaReached = locator.found;
+		postOffice->SetLocator(nullptr);
+
+		std::cout << "  " << std::setw(5) << population << " units, scan     " << std::setw(8) << helpScanTime * 1e6 / REQUESTS << " us/request, " << std::setprecision(1) << static_cast<double>(scanReached) / REQUESTS << " soldiers reached" << std::setprecision(2) << std::endl
+			<< "  " << std::setw(5) << population << " units, by area  " << std::setw(8) << helpAreaTime * 1e6 / REQUESTS << " us/request" << (areaReached == scanReached ? "" : "  RECEIVER MISMATCH") << std::endl;
+		for (int r = 0; r < REQUESTS; ++r)
+			delete requests[r];
+		unitPool.Clear();
+		SceneData::GetInstance()->SetUnits(nullptr);
+		for (size_t i = 0; i < pooled.size(); ++i)
+			delete pooled[i];
+	}
+}
+
+void RunUnitLayoutBenchmark(int threads)
+{
+	Math::InitRNG(1220);
+	JobSystem jobs;
+	jobs.Init(threads);
+	BenchmarkUnitLayout(10000, jobs);
+	BenchmarkUnitLayout(100000, jobs);
+}
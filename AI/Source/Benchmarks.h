@@ -0,0 +1,25 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+//console micro-benchmarks, run with AI.exe -bench <name>
+//each prints its own table and needs no window or GL context
+
+//original per-call BFS vs GridPathfinder (BFS, A*) on the 30x30 sandbox map
+//and random 256x256 / 1024x1024 / 2048x2048 maps, checking every algorithm finds the same path length,
+//then HPA* (HierarchicalPathfinder) with how much longer its paths are and what a cluster repair costs,
+//a FlowFieldCache field repaired after single wall changes vs rebuilt,
+//and the cells reachable from one start found by BFS vs a word-parallel BitGrid flood
+void RunPathfinderBenchmark();
+
+//SceneSandbox's movement step and enemy sensing at 10k and 100k units:
+//per-GameObject loops (as they were) vs the packed UnitStore / SpatialGrid entry arrays,
+//and UnitStore::UpdateIdle / Integrate vs their scalar references; the packed versions also run on a JobSystem of threads (0 = one per core)
+void RunUnitLayoutBenchmark(int threads = 0);
+
+//message dispatch: SceneSandbox's handlers reached by the old dynamic_cast chain vs a MessageDispatcher table,
+//GameObject::Handle's per-object count checks as a dynamic_cast chain vs a switch on the type id,
+//repeated enemy alerts delivered as they are sent vs deferred and coalesced by MessageQueue,
+//PostOffice sends by address name vs interned handle, and a queen alarm sent to a team channel vs a scan of every unit
+void RunMessageBenchmark();
+
+#endif
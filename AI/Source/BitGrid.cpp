@@ -0,0 +1,219 @@
+#include "BitGrid.h"
+
+namespace
+{
+	int PopCount(BitGrid::Word w)
+	{
+		w = w - ((w >> 1) & 0x5555555555555555ULL);
+		w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+		w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		return static_cast<int>((w * 0x0101010101010101ULL) >> 56);
+	}
+
+	//spread the set bits of gen along runs of open bits, towards the high end (Kogge-Stone, 6 steps per word)
+	//a set bit spreads into the open bits next to it whether or not it is open itself
+	BitGrid::Word FillUp(BitGrid::Word gen, BitGrid::Word open)
+	{
+		gen |= open & (gen << 1); open &= open << 1;
+		gen |= open & (gen << 2); open &= open << 2;
+		gen |= open & (gen << 4); open &= open << 4;
+		gen |= open & (gen << 8); open &= open << 8;
+		gen |= open & (gen << 16); open &= open << 16;
+		gen |= open & (gen << 32);
+		return gen;
+	}
+
+	BitGrid::Word FillDown(BitGrid::Word gen, BitGrid::Word open)
+	{
+		gen |= open & (gen >> 1); open &= open >> 1;
+		gen |= open & (gen >> 2); open &= open >> 2;
+		gen |= open & (gen >> 4); open &= open >> 4;
+		gen |= open & (gen >> 8); open &= open >> 8;
+		gen |= open & (gen >> 16); open &= open >> 16;
+		gen |= open & (gen >> 32);
+		return gen;
+	}
+}
+
+BitGrid::BitGrid()
+	: m_width(0), m_height(0), m_wordsPerRow(0), m_border(false)
+{
+}
+
+BitGrid::~BitGrid()
+{
+}
+
+void BitGrid::Init(int width, int height, bool border)
+{
+	m_width = width;
+	m_height = height;
+	m_wordsPerRow = (width + 2 + 63) / 64;
+	m_border = border;
+	m_words.assign((height + 2) * m_wordsPerRow, border ? ~0ULL : 0ULL);
+	m_mapMask.assign(m_wordsPerRow, 0ULL);
+	for (int x = 0; x < width; ++x)
+		m_mapMask[(x + 1) >> 6] |= 1ULL << ((x + 1) & 63);
+	Clear();
+}
+
+void BitGrid::Clear()
+{
+	for (int y = 0; y < m_height; ++y)
+	{
+		Word* row = Row(y);
+		for (int w = 0; w < m_wordsPerRow; ++w)
+			row[w] &= ~m_mapMask[w];
+	}
+}
+
+int BitGrid::GetWidth() const
+{
+	return m_width;
+}
+
+int BitGrid::GetHeight() const
+{
+	return m_height;
+}
+
+int BitGrid::GetWordsPerRow() const
+{
+	return m_wordsPerRow;
+}
+
+void BitGrid::Set(int x, int y, bool value)
+{
+	int bit = x + 1;
+	Word& word = Row(y)[bit >> 6];
+	if (value) word |= 1ULL << (bit & 63);
+	else word &= ~(1ULL << (bit & 63));
+}
+
+const BitGrid::Word* BitGrid::GetRow(int y) const
+{
+	return &m_words[(y + 1) * m_wordsPerRow];
+}
+
+BitGrid::Word* BitGrid::Row(int y)
+{
+	return &m_words[(y + 1) * m_wordsPerRow];
+}
+
+void BitGrid::Or(const BitGrid& other)
+{
+	for (int y = 0; y < m_height; ++y)
+	{
+		Word* row = Row(y);
+		const Word* src = other.GetRow(y);
+		for (int w = 0; w < m_wordsPerRow; ++w)
+			row[w] |= src[w] & m_mapMask[w];
+	}
+}
+
+void BitGrid::AndNot(const BitGrid& other)
+{
+	for (int y = 0; y < m_height; ++y)
+	{
+		Word* row = Row(y);
+		const Word* src = other.GetRow(y);
+		for (int w = 0; w < m_wordsPerRow; ++w)
+			row[w] &= ~(src[w] & m_mapMask[w]);
+	}
+}
+
+void BitGrid::Dilate(BitGrid& out) const
+{
+	if (out.m_width != m_width || out.m_height != m_height)
+		out.Init(m_width, m_height, m_border);
+	const Word* mask = &m_mapMask[0];
+	for (int y = 0; y < m_height; ++y)
+	{
+		const Word* row = GetRow(y);
+		const Word* below = y > 0 ? GetRow(y - 1) : nullptr;
+		const Word* above = y + 1 < m_height ? GetRow(y + 1) : nullptr;
+		Word* dst = out.Row(y);
+		for (int w = 0; w < m_wordsPerRow; ++w)
+		{
+			Word centre = row[w] & mask[w];
+			Word grown = centre | (centre << 1) | (centre >> 1);
+			if (w > 0) grown |= (row[w - 1] & mask[w - 1]) >> 63;
+			if (w + 1 < m_wordsPerRow) grown |= (row[w + 1] & mask[w + 1]) << 63;
+			if (below) grown |= below[w] & mask[w];
+			if (above) grown |= above[w] & mask[w];
+			dst[w] = (grown & mask[w]) | (dst[w] & ~mask[w]);
+		}
+	}
+}
+
+bool BitGrid::Flood(const BitGrid& blocked)
+{
+	//sweep up then down the rows: each row takes in the open cells next to the rows either side of it,
+	//then fills sideways along its open runs a word at a time. repeat until a pair of sweeps adds nothing.
+	//after the first pair of sweeps a row is only redone when a row next to it changed since it was last done
+	std::vector<Word> open(m_wordsPerRow);
+	std::vector<char> dirty(m_height, 1);
+	bool grewAny = false;
+	bool grew = true;
+	for (bool first = true; grew; first = false)
+	{
+		grew = false;
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (int i = 0; i < m_height; ++i)
+			{
+				int y = pass == 0 ? i : m_height - 1 - i;
+				if (!dirty[y])
+					continue;
+				dirty[y] = 0;
+				Word* row = Row(y);
+				const Word* blockedRow = blocked.GetRow(y);
+				const Word* below = y > 0 ? GetRow(y - 1) : nullptr;
+				const Word* above = y + 1 < m_height ? GetRow(y + 1) : nullptr;
+				Word changed = 0;
+				Word carry = 0;
+				for (int w = 0; w < m_wordsPerRow; ++w)
+				{
+					open[w] = ~blockedRow[w] & m_mapMask[w];
+					Word cells = row[w] & m_mapMask[w];
+					if (below) cells |= below[w] & open[w];
+					if (above) cells |= above[w] & open[w];
+					cells = FillUp(cells | (carry & open[w]), open[w]);
+					carry = cells >> 63;
+					changed |= cells ^ (row[w] & m_mapMask[w]);
+					row[w] = (row[w] & ~m_mapMask[w]) | cells;
+				}
+				carry = 0;
+				for (int w = m_wordsPerRow - 1; w >= 0; --w)
+				{
+					Word cells = row[w] & m_mapMask[w];
+					Word filled = FillDown(cells | (carry & open[w]), open[w]);
+					carry = filled << 63;
+					changed |= filled ^ cells;
+					row[w] = (row[w] & ~m_mapMask[w]) | filled;
+				}
+				if (changed)
+					grew = true;
+				if (changed || first)
+				{
+					if (y > 0) dirty[y - 1] = 1;
+					if (y + 1 < m_height) dirty[y + 1] = 1;
+				}
+			}
+		}
+		grewAny = grewAny || grew;
+	}
+	return grewAny;
+}
+
+int BitGrid::Count() const
+{
+	int count = 0;
+	for (int y = 0; y < m_height; ++y)
+	{
+		const Word* row = GetRow(y);
+		for (int w = 0; w < m_wordsPerRow; ++w)
+			count += PopCount(row[w] & m_mapMask[w]);
+	}
+	return count;
+}
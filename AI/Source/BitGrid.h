@@ -0,0 +1,54 @@
+#ifndef BIT_GRID_H
+#define BIT_GRID_H
+
+#include <vector>
+
+//one bit per grid cell, packed into 64-bit words a row at a time
+//the map is surrounded by a one cell border whose bits are fixed at Init (set for obstacle grids),
+//so a neighbour test from any cell on the map needs no bounds check.
+//whole-word operations work on 64 cells at once: unions, 4-neighbour expansion by shifts and popcounts
+class BitGrid
+{
+public:
+	typedef unsigned long long Word;
+
+	BitGrid();
+	~BitGrid();
+
+	void Init(int width, int height, bool border); //every map cell clear
+	void Clear(); //map cells only, the border keeps its value
+
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetWordsPerRow() const;
+
+	bool Get(int x, int y) const; //-1..width, -1..height, i.e. the map and its border
+	void Set(int x, int y, bool value); //map cells only
+	const Word* GetRow(int y) const; //-1..height, cell x is bit x + 1
+
+	//same size grids only, the border is left alone
+	void Or(const BitGrid& other);
+	void AndNot(const BitGrid& other);
+
+	void Dilate(BitGrid& out) const; //out = these cells plus their 4 neighbours on the map, sized like this grid
+	bool Flood(const BitGrid& blocked); //grow into every open cell 4-connected to a set one, false if nothing was added
+	int Count() const; //set cells on the map
+
+private:
+	Word* Row(int y);
+
+	int m_width;
+	int m_height;
+	int m_wordsPerRow;
+	bool m_border;
+	std::vector<Word> m_words; //height + 2 rows of m_wordsPerRow words, border rows included
+	std::vector<Word> m_mapMask; //per word of a row, the bits that are map cells
+};
+
+inline bool BitGrid::Get(int x, int y) const
+{
+	int bit = x + 1;
+	return (m_words[(y + 1) * m_wordsPerRow + (bit >> 6)] >> (bit & 63)) & 1;
+}
+
+#endif
@@ -0,0 +1,200 @@
+#include "CommandBuffer.h"
+#include "GameObject.h"
+#include "PostOffice.h"
+#include "ConcreteMessages.h"
+#include "MessagePool.h"
+#include "MyMath.h"
+
+namespace
+{
+	thread_local CommandBuffer* t_bound = nullptr;
+}
+
+CommandBuffer::CommandBuffer()
+	: m_randState(1)
+{
+}
+
+CommandBuffer::~CommandBuffer()
+{
+	Clear();
+}
+
+void CommandBuffer::Bind(CommandBuffer* buffer)
+{
+	t_bound = buffer;
+}
+
+CommandBuffer* CommandBuffer::GetBound()
+{
+	return t_bound;
+}
+
+void CommandBuffer::BeginUnit(const GameObject* go, unsigned seed)
+{
+	//mix seed and id so neighbouring units and ticks get unrelated streams (xorshift needs a non-zero state)
+	unsigned state = seed ^ (static_cast<unsigned>(go->id) * 0x9E3779B1u);
+	state ^= state >> 16; state *= 0x85EBCA6Bu;
+	state ^= state >> 13; state *= 0xC2B2AE35u;
+	state ^= state >> 16;
+	m_randState = state ? state : 1;
+}
+
+void CommandBuffer::Clear()
+{
+	m_commands.clear(); //any messages left over belong to MessagePool
+}
+
+void CommandBuffer::Resolve()
+{
+	for (size_t i = 0; i < m_commands.size(); ++i)
+	{
+		Command& command = m_commands[i];
+		GameObject* target = command.target;
+		switch (command.type)
+		{
+		case CMD_DAMAGE:
+			//a target killed earlier in the resolve takes no more hits (and dies only once)
+			if (target && target->active) ApplyDamage(target, command.amount);
+			break;
+		case CMD_HEALTH:
+			if (target) target->health = Math::Min(command.cap, target->health + command.amount);
+			break;
+		case CMD_TAKE_FOOD:
+			//if an earlier harvest emptied it this unit is lost, the worker has already picked it up
+			if (target && target->active) ApplyTakeFood(target);
+			break;
+		case CMD_HARVESTERS:
+			if (target) target->harvesterCount += command.a;
+			break;
+		case CMD_MARK_FOOD:
+			if (target) target->isMarked = true;
+			break;
+		case CMD_CALL:
+			command.func(command.a, command.b);
+			break;
+		case CMD_MESSAGE:
+			PostOffice::GetInstance()->Send(command.address, command.message);
+			command.message = nullptr;
+			break;
+		}
+	}
+	m_commands.clear();
+}
+
+CommandBuffer::Command& CommandBuffer::Record(COMMAND_TYPE type, GameObject* target)
+{
+	m_commands.push_back(Command());
+	Command& command = m_commands.back();
+	command.type = type;
+	command.target = target;
+	command.amount = 0.f;
+	command.cap = FLT_MAX;
+	command.func = nullptr;
+	command.a = command.b = 0;
+	command.message = nullptr;
+	command.address = -1;
+	return command;
+}
+
+bool CommandBuffer::ApplyDamage(GameObject* target, float amount)
+{
+	target->health -= amount;
+	if (target->health > 0.f)
+		return false;
+	static const AddressHandle scene = PostOffice::GetInstance()->GetAddress("Scene");
+	PostOffice::GetInstance()->Send(scene, MessagePool::GetInstance()->Create<MessageUnitDied>(target, target->teamID, target->type));
+	target->active = false;
+	return true;
+}
+
+void CommandBuffer::ApplyTakeFood(GameObject* food)
+{
+	food->resourceCount--;
+	if (food->resourceCount <= 0)
+	{
+		static const AddressHandle scene = PostOffice::GetInstance()->GetAddress("Scene");
+		PostOffice::GetInstance()->Send(scene, MessagePool::GetInstance()->Create<MessageResourceDepleted>(food));
+		food->active = false;
+	}
+}
+
+bool CommandBuffer::Damage(GameObject* target, float amount)
+{
+	if (!t_bound)
+		return ApplyDamage(target, amount);
+	t_bound->Record(CMD_DAMAGE, target).amount = amount;
+	return false;
+}
+
+void CommandBuffer::AdjustHealth(GameObject* target, float amount, float cap)
+{
+	if (!t_bound)
+	{
+		target->health = Math::Min(cap, target->health + amount);
+		return;
+	}
+	Command& command = t_bound->Record(CMD_HEALTH, target);
+	command.amount = amount;
+	command.cap = cap;
+}
+
+void CommandBuffer::TakeFood(GameObject* food)
+{
+	if (!t_bound)
+		ApplyTakeFood(food);
+	else
+		t_bound->Record(CMD_TAKE_FOOD, food);
+}
+
+void CommandBuffer::AddHarvesters(GameObject* food, int count)
+{
+	if (!t_bound)
+		food->harvesterCount += count;
+	else
+		t_bound->Record(CMD_HARVESTERS, food).a = count;
+}
+
+void CommandBuffer::MarkFood(GameObject* food)
+{
+	if (!t_bound)
+		food->isMarked = true;
+	else
+		t_bound->Record(CMD_MARK_FOOD, food);
+}
+
+void CommandBuffer::Call(void (*func)(int, int), int a, int b)
+{
+	if (!t_bound)
+	{
+		func(a, b);
+		return;
+	}
+	Command& command = t_bound->Record(CMD_CALL, nullptr);
+	command.func = func;
+	command.a = a;
+	command.b = b;
+}
+
+void CommandBuffer::QueueMessage(AddressHandle address, Message* message)
+{
+	if (!t_bound)
+	{
+		PostOffice::GetInstance()->Send(address, message);
+		return;
+	}
+	Command& command = t_bound->Record(CMD_MESSAGE, nullptr);
+	command.address = address;
+	command.message = message;
+}
+
+int CommandBuffer::RandInt(int min, int max)
+{
+	if (!t_bound)
+		return Math::RandIntMinMax(min, max);
+	unsigned& state = t_bound->m_randState;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return min + static_cast<int>(state % static_cast<unsigned>(max - min + 1));
+}
@@ -0,0 +1,71 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <vector>
+#include <cfloat>
+#include "GameObjectHandle.h"
+#include "Message.h"
+
+struct GameObject;
+
+//writes a unit's AI makes outside the unit itself: damage and healing, harvesting food, messages, shared maps.
+//normally they apply straight away. while a CommandBuffer is bound to the calling thread (SceneSandbox's
+//buffered AI mode) they are recorded instead, so every unit reads the world as it was when the phase began,
+//and Resolve applies them once the phase is over. resolving the buffers in a fixed order gives the same
+//result whichever thread updated which units
+class CommandBuffer
+{
+public:
+	CommandBuffer();
+	~CommandBuffer();
+
+	static void Bind(CommandBuffer* buffer); //for the calling thread, nullptr unbinds
+	static CommandBuffer* GetBound();
+
+	void BeginUnit(const GameObject* go, unsigned seed); //restarts RandInt's stream for go
+	void Resolve(); //apply everything in recording order, then clear
+	void Clear();
+
+	//health -= amount, and the target dies at 0. true if it died, which can only be known when not deferred
+	static bool Damage(GameObject* target, float amount);
+	static void AdjustHealth(GameObject* target, float amount, float cap = FLT_MAX); //health = min(cap, health + amount)
+	static void TakeFood(GameObject* food); //one unit harvested, the food depletes at 0
+	static void AddHarvesters(GameObject* food, int count);
+	static void MarkFood(GameObject* food);
+	static void Call(void (*func)(int, int), int a, int b); //any other shared write
+	static void QueueMessage(AddressHandle address, Message* message); //for PostOffice::Send while bound
+	static int RandInt(int min, int max); //Math::RandIntMinMax, or the unit's own stream while bound
+
+private:
+	enum COMMAND_TYPE
+	{
+		CMD_DAMAGE,
+		CMD_HEALTH,
+		CMD_TAKE_FOOD,
+		CMD_HARVESTERS,
+		CMD_MARK_FOOD,
+		CMD_CALL,
+		CMD_MESSAGE,
+	};
+	struct Command
+	{
+		COMMAND_TYPE type;
+		GameObjectRef target;
+		float amount;
+		float cap;
+		void (*func)(int, int);
+		int a;
+		int b;
+		Message* message;
+		AddressHandle address;
+	};
+
+	static bool ApplyDamage(GameObject* target, float amount);
+	static void ApplyTakeFood(GameObject* food);
+	Command& Record(COMMAND_TYPE type, GameObject* target);
+
+	std::vector<Command> m_commands;
+	unsigned m_randState;
+};
+
+#endif
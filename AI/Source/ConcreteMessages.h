@@ -6,6 +6,8 @@
 
 struct MessageWRU : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_WRU;
+
 	enum SEARCH_TYPE
 	{
 		SEARCH_NONE = 0,
@@ -14,7 +16,7 @@ struct MessageWRU : public Message
 		NEAREST_FULLFISH,
 		HIGHEST_ENERGYFISH,
 	};
-	MessageWRU(GameObject *goValue, SEARCH_TYPE typeValue, float thresholdValue) : go(goValue), type(typeValue), threshold(thresholdValue) {}
+	MessageWRU(GameObject *goValue, SEARCH_TYPE typeValue, float thresholdValue) : Message(TYPE), go(goValue), type(typeValue), threshold(thresholdValue) {}
 	virtual ~MessageWRU() {}
 
 	GameObject *go;
@@ -24,32 +26,42 @@ struct MessageWRU : public Message
 
 struct MessageCheckActive : public Message
 {
-	MessageCheckActive() {}
+	static const MESSAGE_TYPE TYPE = MSG_CHECK_ACTIVE;
+
+	MessageCheckActive() : Message(TYPE) {}
 };
 
 struct MessageCheckFish : public Message
 {
-	MessageCheckFish() {}
+	static const MESSAGE_TYPE TYPE = MSG_CHECK_FISH;
+
+	MessageCheckFish() : Message(TYPE) {}
 };
 
 struct MessageCheckFood : public Message
 {
-	MessageCheckFood() {}
+	static const MESSAGE_TYPE TYPE = MSG_CHECK_FOOD;
+
+	MessageCheckFood() : Message(TYPE) {}
 };
 
 struct MessageCheckShark : public Message
 {
-	MessageCheckShark() {}
+	static const MESSAGE_TYPE TYPE = MSG_CHECK_SHARK;
+
+	MessageCheckShark() : Message(TYPE) {}
 };
 
 //week 5
 //this message asks the scene to spawn an object
 struct MessageSpawn : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_SPAWN;
+
 	// owner of msg, what to spawn, # to spawn, # tiles(x & y) from owner
 	// passing range array by reference to avoid array decay (to int*) - that way we can force users to only pass an array of size 2(no other sizes will be accepted)
 	// alternatively, look into std::array(c++11 onwards)?
-	MessageSpawn(GameObject* goVal, int typeVal, int countVal, int (&range)[2]) : go(goVal), type(typeVal), count(countVal)
+	MessageSpawn(GameObject* goVal, int typeVal, int countVal, int (&range)[2]) : Message(TYPE), go(goVal), type(typeVal), count(countVal)
 	{
 		distRange[0] = range[0];
 		distRange[1] = range[1];
@@ -63,10 +75,12 @@ struct MessageSpawn : public Message
 
 struct MessageSpawnFood : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_SPAWN_FOOD;
+
 	// owner of msg, what to spawn, # to spawn, # tiles(x & y) from owner
 	// passing range array by reference to avoid array decay (to int*) - that way we can force users to only pass an array of size 2(no other sizes will be accepted)
 	// alternatively, look into std::array(c++11 onwards)?
-	MessageSpawnFood(GameObject* goVal, int typeVal, int countVal, int(&range)[2]) : go(goVal), type(typeVal), count(countVal)
+	MessageSpawnFood(GameObject* goVal, int typeVal, int countVal, int(&range)[2]) : Message(TYPE), go(goVal), type(typeVal), count(countVal)
 	{
 		distRange[0] = range[0];
 		distRange[1] = range[1];
@@ -80,13 +94,17 @@ struct MessageSpawnFood : public Message
 
 struct MessageStop : public Message
 {
-	MessageStop() {}
+	static const MESSAGE_TYPE TYPE = MSG_STOP;
+
+	MessageStop() : Message(TYPE) {}
 };
 
 //this message is meant to turn food into fish
 struct MessageEvolve : public Message
 {
-	MessageEvolve(GameObject* goVal) : go(goVal) {}
+	static const MESSAGE_TYPE TYPE = MSG_EVOLVE;
+
+	MessageEvolve(GameObject* goVal) : Message(TYPE), go(goVal) {}
 
 	GameObject* go;
 };
@@ -95,6 +113,8 @@ struct MessageEvolve : public Message
 
 struct MessageSpawnUnit : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_SPAWN_UNIT;
+
 	enum UNIT_TYPE
 	{
 		UNIT_SPEEDY_ANT_WORKER,
@@ -107,79 +127,106 @@ struct MessageSpawnUnit : public Message
 		UNIT_PHEROMONE
 	};
 	MessageSpawnUnit(GameObject* goValue, UNIT_TYPE unitType, Vector3 spawnPos)
-		: spawner(goValue), type(unitType), position(spawnPos) {
+		: Message(TYPE), spawner(goValue), type(unitType), position(spawnPos) {
 	}
 	virtual ~MessageSpawnUnit() {}
 
-	GameObject* spawner;
+	GameObjectRef spawner;
 	UNIT_TYPE type;
 	Vector3 position;
 };
 
 struct MessageResourceFound : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_RESOURCE_FOUND;
+
 	MessageResourceFound(GameObject* finder, Vector3 resourcePos, int team)
-		: discoverer(finder), position(resourcePos), teamID(team) {
+		: Message(TYPE), discoverer(finder), position(resourcePos), teamID(team) {
 	}
 	virtual ~MessageResourceFound() {}
 
-	GameObject* discoverer;
+	GameObjectRef discoverer;
 	Vector3 position;
 	int teamID;
 };
 
+//sent when a food source runs out so the scene can drop it from its indices
+struct MessageResourceDepleted : public Message
+{
+	static const MESSAGE_TYPE TYPE = MSG_RESOURCE_DEPLETED;
+
+	MessageResourceDepleted(GameObject* foodItem)
+		: Message(TYPE), food(foodItem) {
+	}
+	virtual ~MessageResourceDepleted() {}
+
+	GameObjectRef food;
+};
+
 struct MessageEnemySpotted : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_ENEMY_SPOTTED;
+
 	MessageEnemySpotted(GameObject* spotter, GameObject* target, int team)
-		: scout(spotter), enemy(target), teamID(team) {
+		: Message(TYPE), scout(spotter), enemy(target), teamID(team) {
 	}
 	virtual ~MessageEnemySpotted() {}
+	//which scout saw it makes no difference to the team's soldiers
+	virtual unsigned long long GetCoalesceKey() const { return (static_cast<unsigned long long>(teamID + 1) << 32) | enemy.GetHandle(); }
 
-	GameObject* scout;
-	GameObject* enemy;
+	GameObjectRef scout;
+	GameObjectRef enemy;
 	int teamID;
 };
 
 struct MessageRequestHelp : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_REQUEST_HELP;
+
 	MessageRequestHelp(GameObject* caller, Vector3 pos, int team)
-		: requester(caller), position(pos), teamID(team) {
+		: Message(TYPE), requester(caller), position(pos), teamID(team) {
 	}
 	virtual ~MessageRequestHelp() {}
 
-	GameObject* requester;
+	GameObjectRef requester;
 	Vector3 position;
 	int teamID;
 };
 
 struct MessageResourceDelivered : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_RESOURCE_DELIVERED;
+
 	MessageResourceDelivered(GameObject* deliverer, int amount, int team)
-		: worker(deliverer), resourceAmount(amount), teamID(team) {
+		: Message(TYPE), worker(deliverer), resourceAmount(amount), teamID(team) {
 	}
 	virtual ~MessageResourceDelivered() {}
 
-	GameObject* worker;
+	GameObjectRef worker;
 	int resourceAmount;
 	int teamID;
 };
 
 struct MessageUnitDied : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_UNIT_DIED;
+
 	MessageUnitDied(GameObject* deceased, int team, GameObject::GAMEOBJECT_TYPE unitType)
-		: unit(deceased), teamID(team), type(unitType) {
+		: Message(TYPE), unit(deceased), teamID(team), type(unitType) {
 	}
 	virtual ~MessageUnitDied() {}
 
-	GameObject* unit;
+	GameObjectRef unit;
 	int teamID;
 	GameObject::GAMEOBJECT_TYPE type;
 };
 
 struct MessageTerritoryClaimed : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_TERRITORY_CLAIMED;
+
 	MessageTerritoryClaimed(int team, Vector3 pos)
-		: teamID(team), position(pos) {
+		: Message(TYPE), teamID(team), position(pos) {
 	}
 	virtual ~MessageTerritoryClaimed() {}
 
@@ -189,12 +236,14 @@ struct MessageTerritoryClaimed : public Message
 
 struct MessageQueenThreat : public Message
 {
+	static const MESSAGE_TYPE TYPE = MSG_QUEEN_THREAT;
+
 	MessageQueenThreat(GameObject* queenUnit, int team)
-		: queen(queenUnit), teamID(team) {
+		: Message(TYPE), queen(queenUnit), teamID(team) {
 	}
 	virtual ~MessageQueenThreat() {}
 
-	GameObject* queen;
+	GameObjectRef queen;
 	int teamID;
 };
 
@@ -0,0 +1,353 @@
+#include "FlowField.h"
+#include <algorithm>
+
+namespace
+{
+	const int STEP_X[] = { 0, 0, -1, 1 };
+	const int STEP_Y[] = { 1, -1, 0, 0 };
+}
+
+FlowFieldCache::FlowFieldCache()
+	: m_width(0), m_height(0), m_blocked(nullptr), m_version(0), m_budget(DEFAULT_BUDGET), m_useClock(0), m_overflow(false),
+	m_buildCount(0), m_buildCells(0), m_repairCount(0), m_repairCells(0), m_evictions(0)
+{
+}
+
+FlowFieldCache::~FlowFieldCache()
+{
+}
+
+void FlowFieldCache::Init(const BitGrid* blocked, size_t budget)
+{
+	m_width = blocked->GetWidth();
+	m_height = blocked->GetHeight();
+	m_blocked = blocked;
+	m_budget = budget;
+	m_affected.assign(m_width * m_height, false);
+	Clear();
+}
+
+void FlowFieldCache::Clear()
+{
+	m_fields.clear();
+	m_queue.clear();
+	m_open.clear();
+	m_version = 0;
+	m_buildCount = m_repairCount = 0;
+	m_buildCells = m_repairCells = 0;
+	m_useClock = 0;
+	m_evictions = 0;
+}
+
+void FlowFieldCache::SetObstacleVersion(unsigned version)
+{
+	m_version = version;
+}
+
+void FlowFieldCache::Remove(int goalIndex)
+{
+	m_fields.erase(goalIndex);
+}
+
+void FlowFieldCache::UpdateCell(int index)
+{
+	for (std::unordered_map<int, FlowField>::iterator it = m_fields.begin(); it != m_fields.end(); ++it)
+	{
+		if (it->second.version != m_version)
+			continue; //rebuilt on next use anyway
+		++m_repairCount;
+		if (!Repair(it->second, it->first, index))
+			Build(it->second, it->first);
+	}
+}
+
+int FlowFieldCache::GetBuildCount() const
+{
+	return m_buildCount;
+}
+
+long long FlowFieldCache::GetBuildCells() const
+{
+	return m_buildCells;
+}
+
+int FlowFieldCache::GetRepairCount() const
+{
+	return m_repairCount;
+}
+
+long long FlowFieldCache::GetRepairCells() const
+{
+	return m_repairCells;
+}
+
+int FlowFieldCache::GetEvictionCount() const
+{
+	return m_evictions;
+}
+
+int FlowFieldCache::GetFieldCount() const
+{
+	return static_cast<int>(m_fields.size());
+}
+
+size_t FlowFieldCache::GetMemoryUsage() const
+{
+	return m_fields.size() * static_cast<size_t>(m_width) * m_height * (sizeof(unsigned char) + sizeof(unsigned short));
+}
+
+bool FlowFieldCache::GetNextCell(int goalIndex, MazePt from, MazePt& next)
+{
+	if (goalIndex < 0 || goalIndex >= m_width * m_height)
+		return false;
+	if (from.x < 0 || from.x >= m_width || from.y < 0 || from.y >= m_height)
+		return false;
+	unsigned char dir = GetField(goalIndex).direction[from.y * m_width + from.x];
+	if (dir == DIR_NONE)
+		return false;
+	next = from;
+	if (dir != DIR_GOAL)
+		next.Set(from.x + STEP_X[dir], from.y + STEP_Y[dir]);
+	return true;
+}
+
+int FlowFieldCache::GetDistance(int goalIndex, MazePt from)
+{
+	if (goalIndex < 0 || goalIndex >= m_width * m_height)
+		return -1;
+	if (from.x < 0 || from.x >= m_width || from.y < 0 || from.y >= m_height)
+		return -1;
+	int distance = GetField(goalIndex).distance[from.y * m_width + from.x];
+	return distance == UNREACHABLE ? -1 : distance;
+}
+
+const FlowFieldCache::FlowField& FlowFieldCache::GetField(int goalIndex)
+{
+	std::unordered_map<int, FlowField>::iterator it = m_fields.find(goalIndex);
+	if (it == m_fields.end())
+	{
+		size_t fieldBytes = static_cast<size_t>(m_width) * m_height * (sizeof(unsigned char) + sizeof(unsigned short));
+		while (!m_fields.empty() && (m_fields.size() + 1) * fieldBytes > m_budget)
+			Evict();
+		it = m_fields.insert(std::pair<int, FlowField>(goalIndex, FlowField())).first;
+		Build(it->second, goalIndex);
+	}
+	else if (it->second.version != m_version)
+	{
+		Build(it->second, goalIndex);
+	}
+	it->second.lastUse = ++m_useClock;
+	return it->second;
+}
+
+void FlowFieldCache::Evict()
+{
+	//a linear scan: the budget keeps the count down on the big maps, and on small ones it is never reached
+	std::unordered_map<int, FlowField>::iterator oldest = m_fields.begin();
+	for (std::unordered_map<int, FlowField>::iterator it = m_fields.begin(); it != m_fields.end(); ++it)
+	{
+		if (it->second.lastUse < oldest->second.lastUse)
+			oldest = it;
+	}
+	m_fields.erase(oldest);
+	++m_evictions;
+}
+
+void FlowFieldCache::Build(FlowField& field, int goalIndex)
+{
+	field.version = m_version;
+	field.saturated = false;
+	field.direction.assign(m_width * m_height, DIR_NONE);
+	field.distance.assign(m_width * m_height, UNREACHABLE);
+	m_queue.clear();
+
+	//seed with the goal, or with its open neighbours when the goal itself is solid
+	int goalX = goalIndex % m_width, goalY = goalIndex / m_width;
+	if (!IsBlocked(goalX, goalY))
+	{
+		field.direction[goalIndex] = DIR_GOAL;
+		field.distance[goalIndex] = 0;
+		m_queue.push_back(goalIndex);
+	}
+	else
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = goalX + STEP_X[i]; int ny = goalY + STEP_Y[i];
+			if (IsBlocked(nx, ny))
+				continue;
+			field.direction[ny * m_width + nx] = DIR_GOAL;
+			field.distance[ny * m_width + nx] = 0;
+			m_queue.push_back(ny * m_width + nx);
+		}
+	}
+
+	//grow outwards; each newly reached cell points back at the cell it was reached from,
+	//or at a later one of the same distance that comes first in step order
+	//(beyond MAX_DISTANCE distances all read the same, so there it keeps the first)
+	for (size_t head = 0; head < m_queue.size(); ++head)
+	{
+		int curr = m_queue[head];
+		int x = curr % m_width, y = curr / m_width;
+		int distance = field.distance[curr] + 1;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = x + STEP_X[i]; int ny = y + STEP_Y[i];
+			if (IsBlocked(nx, ny))
+				continue;
+			int next = ny * m_width + nx;
+			if (field.direction[next] != DIR_NONE)
+			{
+				if (field.distance[next] == distance && (i ^ 1) < field.direction[next])
+					field.direction[next] = static_cast<unsigned char>(i ^ 1);
+				continue;
+			}
+			field.direction[next] = static_cast<unsigned char>(i ^ 1); //opposite step: 0<->1, 2<->3
+			if (distance >= MAX_DISTANCE)
+				field.saturated = true;
+			field.distance[next] = static_cast<unsigned short>(distance < MAX_DISTANCE ? distance : MAX_DISTANCE);
+			m_queue.push_back(next);
+		}
+	}
+	++m_buildCount;
+	m_buildCells += m_queue.size();
+}
+
+bool FlowFieldCache::IsSeed(int goalIndex, int index) const
+{
+	if (index == goalIndex)
+		return true;
+	int goalX = goalIndex % m_width, goalY = goalIndex / m_width;
+	int dx = index % m_width - goalX, dy = index / m_width - goalY;
+	return IsBlocked(goalX, goalY) && (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy) == 1;
+}
+
+bool FlowFieldCache::Relax(FlowField& field, int index)
+{
+	int x = index % m_width, y = index / m_width;
+	int best = INT_MAX;
+	for (int i = 0; i < 4; ++i)
+	{
+		int nx = x + STEP_X[i]; int ny = y + STEP_Y[i];
+		if (IsBlocked(nx, ny))
+			continue;
+		int distance = field.distance[ny * m_width + nx];
+		if (distance == UNREACHABLE || distance + 1 >= best)
+			continue;
+		best = distance + 1;
+		field.direction[index] = static_cast<unsigned char>(i);
+	}
+	if (best == INT_MAX)
+		return false;
+	if (best >= MAX_DISTANCE)
+	{
+		m_overflow = true;
+		best = MAX_DISTANCE;
+	}
+	field.distance[index] = static_cast<unsigned short>(best);
+	return true;
+}
+
+void FlowFieldCache::Propagate(FlowField& field)
+{
+	while (!m_open.empty())
+	{
+		std::pop_heap(m_open.begin(), m_open.end(), OpenCellCompare());
+		OpenCell curr = m_open.back();
+		m_open.pop_back();
+		if (curr.distance != field.distance[curr.index])
+			continue; //improved since it was queued
+		++m_repairCells;
+		//settled, and so is every neighbour one step closer: pick the first of them, as Build would
+		Relax(field, curr.index);
+		int x = curr.index % m_width, y = curr.index / m_width;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = x + STEP_X[i]; int ny = y + STEP_Y[i];
+			if (IsBlocked(nx, ny))
+				continue;
+			int next = ny * m_width + nx;
+			if (field.distance[next] == curr.distance + 1 && (i ^ 1) < field.direction[next])
+				field.direction[next] = static_cast<unsigned char>(i ^ 1); //curr is a closer step than the one it had
+			if (field.distance[next] <= curr.distance + 1)
+				continue;
+			if (curr.distance + 1 >= MAX_DISTANCE)
+			{
+				m_overflow = true; //Repair gives up and the field is built instead
+				m_open.clear();
+				return;
+			}
+			field.distance[next] = static_cast<unsigned short>(curr.distance + 1);
+			field.direction[next] = static_cast<unsigned char>(i ^ 1);
+			OpenCell open = { curr.distance + 1, next };
+			m_open.push_back(open);
+			std::push_heap(m_open.begin(), m_open.end(), OpenCellCompare());
+		}
+	}
+}
+
+bool FlowFieldCache::Repair(FlowField& field, int goalIndex, int index)
+{
+	//the goal and the cells the field starts from are rare enough to just rebuild,
+	//and so are fields too long for their distances to be kept exactly
+	if (IsSeed(goalIndex, index) || field.saturated)
+		return false;
+	m_open.clear();
+	m_overflow = false;
+
+	int x = index % m_width, y = index / m_width;
+	if (!IsBlocked(x, y))
+	{
+		//opened: it may be a shortcut, lower every distance it improves
+		if (Relax(field, index))
+		{
+			OpenCell open = { field.distance[index], index };
+			m_open.push_back(open);
+			Propagate(field);
+		}
+		return !m_overflow;
+	}
+
+	//closed: the cells whose route ran through it (its subtree) lose their distance...
+	if (field.distance[index] == UNREACHABLE)
+		return true;
+	m_queue.clear();
+	m_queue.push_back(index);
+	m_affected[index] = true;
+	for (size_t head = 0; head < m_queue.size(); ++head)
+	{
+		int curr = m_queue[head];
+		int cx = curr % m_width, cy = curr / m_width;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = cx + STEP_X[i]; int ny = cy + STEP_Y[i];
+			if (nx < 0 || nx >= m_width || ny < 0 || ny >= m_height)
+				continue;
+			int next = ny * m_width + nx;
+			if (m_affected[next] || field.direction[next] != (i ^ 1))
+				continue; //not pointing back at curr
+			m_affected[next] = true;
+			m_queue.push_back(next);
+		}
+	}
+	for (size_t i = 0; i < m_queue.size(); ++i)
+	{
+		field.distance[m_queue[i]] = UNREACHABLE;
+		field.direction[m_queue[i]] = DIR_NONE;
+	}
+
+	//...then take the best route in from the rest of the field and settle outwards
+	for (size_t i = 1; i < m_queue.size(); ++i)
+	{
+		if (!Relax(field, m_queue[i]))
+			continue;
+		OpenCell open = { field.distance[m_queue[i]], m_queue[i] };
+		m_open.push_back(open);
+	}
+	std::make_heap(m_open.begin(), m_open.end(), OpenCellCompare());
+	Propagate(field);
+	for (size_t i = 0; i < m_queue.size(); ++i)
+		m_affected[m_queue[i]] = false;
+	m_repairCells += m_queue.size();
+	return !m_overflow;
+}
@@ -0,0 +1,108 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <vector>
+#include <unordered_map>
+#include <climits>
+#include "Maze.h"
+#include "BitGrid.h"
+
+//shared 4-way flow fields for destinations many units head to at once (queens, food sources)
+//one BFS from the goal gives every cell the step to take towards it, so following
+//the field costs a table lookup per cell instead of a search per unit.
+//fields are built on first use and rebuilt lazily once the obstacle version moves on.
+//a single cell changing is repaired in place instead (LPA* style): only the cells whose distance to the goal
+//goes up or down are touched, so the cost follows how much of the field the change affects, not the map size.
+//of several equally short steps a cell always takes the first in step order, a rule that depends only on the
+//neighbours' distances, so a repaired field is the same as one built from scratch.
+//a field costs 3 bytes a cell; past the memory budget the least recently used one is dropped (and rebuilt if asked for again)
+class FlowFieldCache
+{
+public:
+	FlowFieldCache();
+	~FlowFieldCache();
+
+	static const size_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+	//the obstacle grid (walls and food, border set) is read when a field is (re)built, keep it alive while in use
+	//budget in bytes, at least one field is kept whatever it costs
+	void Init(const BitGrid* blocked, size_t budget = DEFAULT_BUDGET);
+	void Clear();
+
+	void SetObstacleVersion(unsigned version); //the owner's count of wall/food grid changes
+	void Remove(int goalIndex); //drop a destination that is gone for good
+	void UpdateCell(int index); //after one cell opened or closed, keeps up-to-date fields up to date
+
+	int GetBuildCount() const;    //full builds so far
+	long long GetBuildCells() const;  //cells those builds reached
+	int GetRepairCount() const;   //fields repaired by UpdateCell
+	long long GetRepairCells() const; //cells those repairs changed
+	int GetEvictionCount() const; //fields dropped to stay in budget
+	int GetFieldCount() const;
+	size_t GetMemoryUsage() const; //bytes held by the fields
+
+	//next cell from 'from' towards goalIndex, or 'from' itself once there
+	//a blocked goal (e.g. a food tile) is reached by standing on any open neighbour
+	//returns false if the goal cannot be reached from 'from'
+	bool GetNextCell(int goalIndex, MazePt from, MazePt& next);
+	int GetDistance(int goalIndex, MazePt from); //steps to the goal (at most MAX_DISTANCE), -1 if it cannot be reached
+
+private:
+	enum
+	{
+		DIR_GOAL = 4,
+		DIR_NONE = 0xff,
+		MAX_DISTANCE = 0xfffe, //further cells are stored as this
+		UNREACHABLE = 0xffff,
+	};
+	struct FlowField
+	{
+		unsigned version;
+		unsigned long long lastUse; //for the LRU
+		bool saturated; //some cell is MAX_DISTANCE or more away: rebuilt rather than repaired
+		std::vector<unsigned char> direction; //index into the step tables, DIR_GOAL or DIR_NONE
+		std::vector<unsigned short> distance; //steps to the goal, UNREACHABLE where it can't be reached
+	};
+	struct OpenCell
+	{
+		int distance;
+		int index;
+	};
+	struct OpenCellCompare
+	{
+		bool operator()(const OpenCell& lhs, const OpenCell& rhs) const { return lhs.distance > rhs.distance; }
+	};
+
+	bool IsBlocked(int x, int y) const;
+	bool IsSeed(int goalIndex, int index) const; //where Build starts the field
+	const FlowField& GetField(int goalIndex);
+	void Build(FlowField& field, int goalIndex);
+	bool Repair(FlowField& field, int goalIndex, int index); //false if it needs a full build
+	bool Relax(FlowField& field, int index); //first of the closest open neighbours for index, false if none is reachable
+	void Propagate(FlowField& field); //settle m_open outwards
+	void Evict(); //the least recently used field
+
+	int m_width;
+	int m_height;
+	const BitGrid* m_blocked;
+	unsigned m_version;
+	std::unordered_map<int, FlowField> m_fields;
+	size_t m_budget;
+	unsigned long long m_useClock;
+	bool m_overflow; //a repair went past MAX_DISTANCE
+	std::vector<int> m_queue; //BFS scratch
+	std::vector<OpenCell> m_open; //repair scratch, min-heap on distance
+	std::vector<bool> m_affected;
+	int m_buildCount;
+	long long m_buildCells;
+	int m_repairCount;
+	long long m_repairCells;
+	int m_evictions;
+};
+
+inline bool FlowFieldCache::IsBlocked(int x, int y) const
+{
+	return m_blocked->Get(x, y);
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "GameObject.h"
 #include "ConcreteMessages.h"
+#include "SceneData.h"
+#include "UnitStore.h"
 
 GameObject::GameObject(GAMEOBJECT_TYPE typeValue) 
 	: type(typeValue),
@@ -36,8 +38,12 @@ GameObject::GameObject(GAMEOBJECT_TYPE typeValue)
 	harvesterCount(0),
 	isMarked(false),
 	prevPos(0, 0, 0),
-	idleTimer(0.f)
+	idleTimer(0.f),
+	poolSlot(-1),
+	poolReleased(false),
+	gridSlot(-1)
 {
+	handle = GameObjectRegistry::GetInstance()->Register(this);
 	static int count = 0;
 	id = ++count;
 	moveLeft = moveRight = moveUp = moveDown = true;
@@ -45,31 +51,62 @@ GameObject::GameObject(GAMEOBJECT_TYPE typeValue)
 
 GameObject::~GameObject()
 {
+	GameObjectRegistry::GetInstance()->Unregister(handle);
 }
 
 //week 4
 bool GameObject::Handle(Message* message)
 {
-	//let's check if message is MessageCheckActive
-	if (dynamic_cast<MessageCheckActive*>(message) != nullptr)
+	//called once per object per frame for the counts, so a switch on the type id rather than dynamic_casts
+	switch (message->GetType())
+	{
+	case Message::MSG_CHECK_ACTIVE:
 		return active;
-	else if (dynamic_cast<MessageCheckFish*>(message) != nullptr)
+	case Message::MSG_CHECK_FISH:
 		return active && type == GameObject::GO_FISH;
-	else if (dynamic_cast<MessageCheckFood*>(message) != nullptr)
+	case Message::MSG_CHECK_FOOD:
 		return active && type == GameObject::GO_FISHFOOD;
-	else if (dynamic_cast<MessageCheckShark*>(message) != nullptr)
+	case Message::MSG_CHECK_SHARK:
 		return active && type == GameObject::GO_SHARK;
 	//week 5
 	//set speed to 0 upon receiving stop message
-	else if (dynamic_cast<MessageStop*>(message) != nullptr)
-	{
+	case Message::MSG_STOP:
 		moveSpeed = 0;
 		return true;
-	}
-	else if (dynamic_cast<MessageEvolve*>(message) != nullptr)
-	{
+	case Message::MSG_EVOLVE:
 		// Exercise Week 05
 		type = GameObject::GO_FISH;
+		break;
+	//Assignment 1
+	//defenders subscribed to their team's alert channel: one with nothing to fight goes for whatever is at the queen
+	case Message::MSG_QUEEN_THREAT:
+	{
+		MessageQueenThreat* threat = static_cast<MessageQueenThreat*>(message);
+		GameObject* queen = threat->queen;
+		if (!active || !queen || teamID != threat->teamID || (targetEnemy && targetEnemy->active))
+			return false;
+		targetEnemy = queen->targetEnemy;
+		return targetEnemy != nullptr;
+	}
+	//radius broadcasts from the scene (PostOffice::SendRadius), which has already picked out who is close enough
+	case Message::MSG_ENEMY_SPOTTED:
+	{
+		MessageEnemySpotted* spotted = static_cast<MessageEnemySpotted*>(message);
+		if (!active || teamID != spotted->teamID)
+			return false;
+		targetEnemy = spotted->enemy;
+		return true;
+	}
+	case Message::MSG_REQUEST_HELP:
+	{
+		MessageRequestHelp* help = static_cast<MessageRequestHelp*>(message);
+		if (!active || teamID != help->teamID)
+			return false;
+		SceneData::GetInstance()->GetUnits()->SetTarget(this, help->position); //a sandbox unit
+		return true;
+	}
+	default:
+		break;
 	}
 
 	//note: pardon the inconsistency(when compared to SceneMovement's Handle)
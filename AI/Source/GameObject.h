@@ -8,6 +8,7 @@
 #include "StateMachine.h"
 #include "ObjectBase.h"
 #include "NNode.h"
+#include "GameObjectHandle.h"
 
 struct GameObject : public ObjectBase
 {
@@ -54,6 +55,7 @@ struct GameObject : public ObjectBase
 
 	};
 	GAMEOBJECT_TYPE type;
+	//SceneSandbox keeps pos, target, moveSpeed, viewDir, prevPos and idleTimer in its UnitStore instead
 	Vector3 pos;
 	Vector3 vel;
 	Vector3 scale;
@@ -67,7 +69,7 @@ struct GameObject : public ObjectBase
 	float baseSpeed;
 	float countDown;
 	STATE currState;
-	GameObject *nearest;
+	GameObjectRef nearest;
 	bool moveLeft;
 	bool moveRight;
 	bool moveUp;
@@ -114,18 +116,27 @@ struct GameObject : public ObjectBase
 	int carriedResources;
 	Vector3 homeBase;
 	Vector3 targetResource;
-	GameObject* targetEnemy;
+	GameObjectRef targetEnemy;
 	bool isCarryingResource;
 	float spawnCooldown;
 	int unitsSpawned;
 	Vector3 viewDir;
-	GameObject* targetAlly;
-	GameObject* targetFoodItem;
+	GameObjectRef targetAlly;
+	GameObjectRef targetFoodItem;
 	int resourceCount;
 	int harvesterCount;
 	bool isMarked;
 	Vector3 prevPos;
 	float idleTimer;
+	int poolSlot; // index in the owning GameObjectPool's active list, -1 if not in one
+	bool poolReleased; // handed back to the pool, leaves its active list at the next Flush (set by the pool only, unlike active)
+	int gridSlot; // index in the scene's SpatialGrid entries, -1 if not in it
+	GOHandle handle; // this object's current handle, changes when the pool recycles it
+
+private:
+	//the registry slot belongs to this instance, copies would share it
+	GameObject(const GameObject&);
+	GameObject& operator=(const GameObject&);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "GameObjectHandle.h"
+#include "GameObject.h"
+
+GameObjectRegistry::GameObjectRegistry()
+{
+}
+
+GameObjectRegistry::~GameObjectRegistry()
+{
+}
+
+GOHandle GameObjectRegistry::Register(GameObject* go)
+{
+	unsigned index;
+	if (!m_freeSlots.empty())
+	{
+		index = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		if (m_slots.size() >= INDEX_MASK)
+			return INVALID_HANDLE;
+		index = static_cast<unsigned>(m_slots.size());
+		Slot slot = { nullptr, 0 };
+		m_slots.push_back(slot);
+	}
+	m_slots[index].object = go;
+	return (m_slots[index].generation << INDEX_BITS) | index;
+}
+
+void GameObjectRegistry::Unregister(GOHandle handle)
+{
+	if (!Resolve(handle))
+		return;
+	unsigned index = handle & INDEX_MASK;
+	m_slots[index].object = nullptr;
+	m_slots[index].generation = (m_slots[index].generation + 1) & GENERATION_MASK;
+	m_freeSlots.push_back(index);
+}
+
+GOHandle GameObjectRegistry::Retire(GOHandle handle)
+{
+	if (!Resolve(handle))
+		return handle;
+	unsigned index = handle & INDEX_MASK;
+	m_slots[index].generation = (m_slots[index].generation + 1) & GENERATION_MASK;
+	return (m_slots[index].generation << INDEX_BITS) | index;
+}
+
+GameObjectRef::GameObjectRef(GameObject* go)
+	: m_handle(go ? go->handle : GameObjectRegistry::INVALID_HANDLE)
+{
+}
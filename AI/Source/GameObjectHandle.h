@@ -0,0 +1,69 @@
+#ifndef GAME_OBJECT_HANDLE_H
+#define GAME_OBJECT_HANDLE_H
+
+#include <vector>
+#include "SingletonTemplate.h"
+
+struct GameObject;
+
+//32-bit reference to a GameObject: the low INDEX_BITS pick a registry slot, the high bits are that slot's generation
+//the generation is bumped when the object is recycled (GameObjectPool::Flush) or deleted,
+//so a handle kept past that resolves to null instead of to whatever lives in the slot now
+typedef unsigned GOHandle;
+
+class GameObjectRegistry : public Singleton<GameObjectRegistry>
+{
+	friend Singleton<GameObjectRegistry>;
+
+public:
+	static const unsigned INDEX_BITS = 20; //a million objects, 4096 generations per slot before it wraps
+	static const unsigned INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned GENERATION_MASK = 0xffffffffu >> INDEX_BITS;
+	static const GOHandle INVALID_HANDLE = 0xffffffffu; //slot INDEX_MASK is never handed out
+
+	GOHandle Register(GameObject* go);
+	void Unregister(GOHandle handle);
+	GOHandle Retire(GOHandle handle); //outstanding handles go stale, returns the object's new handle
+
+	//O(1), null if the handle is stale or invalid. read-only, so safe from any thread while nothing registers or retires
+	GameObject* Resolve(GOHandle handle) const
+	{
+		unsigned index = handle & INDEX_MASK;
+		if (index >= m_slots.size())
+			return nullptr;
+		const Slot& slot = m_slots[index];
+		return slot.generation == (handle >> INDEX_BITS) ? slot.object : nullptr;
+	}
+	//the object registered in slot index whatever its generation, null if the slot is free
+	GameObject* GetObject(unsigned index) const { return index < m_slots.size() ? m_slots[index].object : nullptr; }
+
+private:
+	GameObjectRegistry();
+	~GameObjectRegistry();
+
+	struct Slot
+	{
+		GameObject* object;
+		unsigned generation;
+	};
+	std::vector<Slot> m_slots;
+	std::vector<unsigned> m_freeSlots;
+};
+
+//a GOHandle that reads like a GameObject*: assigning a pointer stores that object's current handle,
+//and every use resolves it again, so a reference to a recycled object reads as null
+class GameObjectRef
+{
+public:
+	GameObjectRef(GameObject* go = nullptr);
+
+	GameObject* Get() const { return GameObjectRegistry::GetInstance()->Resolve(m_handle); }
+	operator GameObject*() const { return Get(); }
+	GameObject* operator->() const { return Get(); }
+	GOHandle GetHandle() const { return m_handle; }
+
+private:
+	GOHandle m_handle;
+};
+
+#endif
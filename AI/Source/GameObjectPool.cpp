@@ -0,0 +1,171 @@
+#include "GameObjectPool.h"
+#include "SpatialGrid.h"
+#include "UnitStore.h"
+
+GameObjectPool::GameObjectPool()
+	: m_goList(nullptr), m_grid(nullptr), m_units(nullptr), m_growBy(10)
+{
+	Clear();
+}
+
+GameObjectPool::~GameObjectPool()
+{
+}
+
+void GameObjectPool::Init(std::vector<GameObject*>* goList, int growBy)
+{
+	m_goList = goList;
+	m_growBy = growBy > 0 ? growBy : 1;
+	Clear();
+}
+
+void GameObjectPool::Clear()
+{
+	m_activeList.clear();
+	m_released.clear();
+	for (int i = 0; i < GameObject::GO_TOTAL; ++i)
+	{
+		m_free[i].clear();
+		m_active[i] = 0;
+		m_peak[i] = 0;
+		m_capacity[i] = 0;
+	}
+	m_activeTotal = 0;
+	m_peakTotal = 0;
+	m_growCount = 0;
+}
+
+void GameObjectPool::SetSpatialGrid(SpatialGrid* grid)
+{
+	m_grid = grid;
+}
+
+void GameObjectPool::SetUnitStore(UnitStore* units)
+{
+	m_units = units;
+}
+
+void GameObjectPool::Grow(GameObject::GAMEOBJECT_TYPE type, int count)
+{
+	m_goList->reserve(m_goList->size() + count);
+	m_activeList.reserve(m_goList->size() + count);
+	m_free[type].reserve(m_free[type].size() + count);
+	for (int i = 0; i < count; ++i)
+	{
+		GameObject* go = new GameObject(type);
+		m_goList->push_back(go);
+		m_free[type].push_back(go);
+	}
+	m_capacity[type] += count;
+}
+
+void GameObjectPool::Reserve(GameObject::GAMEOBJECT_TYPE type, int count)
+{
+	if (m_goList && count > m_capacity[type])
+		Grow(type, count - m_capacity[type]);
+}
+
+GameObject* GameObjectPool::Acquire(GameObject::GAMEOBJECT_TYPE type)
+{
+	if (!m_goList)
+		return nullptr;
+	std::vector<GameObject*>& freeList = m_free[type];
+	if (freeList.empty())
+	{
+		Grow(type, m_growBy);
+		++m_growCount;
+	}
+	GameObject* go = freeList.back();
+	freeList.pop_back();
+	go->active = true;
+	go->poolReleased = false;
+	go->poolSlot = static_cast<int>(m_activeList.size());
+	m_activeList.push_back(go);
+	if (m_grid)
+		m_grid->Add(go);
+	if (m_units)
+		m_units->Add(go);
+
+	++m_active[type];
+	if (m_active[type] > m_peak[type])
+		m_peak[type] = m_active[type];
+	if (++m_activeTotal > m_peakTotal)
+		m_peakTotal = m_activeTotal;
+	return go;
+}
+
+void GameObjectPool::Release(GameObject* go)
+{
+	//not in the active list (never acquired, or flushed already) or released before
+	if (!go || go->poolSlot < 0 || go->poolReleased || go->type < 0 || go->type >= GameObject::GO_TOTAL)
+		return;
+	go->active = false;
+	go->poolReleased = true;
+	m_released.push_back(go);
+	if (m_grid)
+		m_grid->Remove(go);
+	if (m_units)
+		m_units->Remove(go);
+	--m_active[go->type];
+	--m_activeTotal;
+}
+
+void GameObjectPool::Flush()
+{
+	for (size_t i = 0; i < m_released.size(); ++i)
+	{
+		GameObject* go = m_released[i];
+		GameObject* last = m_activeList.back();
+		m_activeList[go->poolSlot] = last;
+		last->poolSlot = go->poolSlot;
+		m_activeList.pop_back();
+		go->poolSlot = -1;
+		go->handle = GameObjectRegistry::GetInstance()->Retire(go->handle);
+		m_free[go->type].push_back(go);
+	}
+	m_released.clear();
+}
+
+const std::vector<GameObject*>& GameObjectPool::GetActive() const
+{
+	return m_activeList;
+}
+
+int GameObjectPool::GetActiveCount(GameObject::GAMEOBJECT_TYPE type) const
+{
+	return m_active[type];
+}
+
+int GameObjectPool::GetPeakCount(GameObject::GAMEOBJECT_TYPE type) const
+{
+	return m_peak[type];
+}
+
+int GameObjectPool::GetCapacity(GameObject::GAMEOBJECT_TYPE type) const
+{
+	return m_capacity[type];
+}
+
+int GameObjectPool::GetPeakTotal() const
+{
+	return m_peakTotal;
+}
+
+int GameObjectPool::GetCapacityTotal() const
+{
+	return m_goList ? static_cast<int>(m_goList->size()) : 0;
+}
+
+int GameObjectPool::GetGrowCount() const
+{
+	return m_growCount;
+}
+
+int GameObjectPool::CountInactive() const
+{
+	int count = 0;
+	for (size_t i = 0; i < m_activeList.size(); ++i)
+		if (!m_activeList[i]->active)
+			++count;
+	return count;
+}
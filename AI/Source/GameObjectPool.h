@@ -0,0 +1,62 @@
+#ifndef GAME_OBJECT_POOL_H
+#define GAME_OBJECT_POOL_H
+
+#include <vector>
+#include "GameObject.h"
+
+class SpatialGrid;
+struct UnitStore;
+
+//per-type free lists over a scene's m_goList, plus a dense list of the objects currently in use
+//every object the pool creates is appended to the scene's list (which still owns and deletes it).
+//Acquire/Release are O(1). Release only switches the object off, it stays in GetActive() (so loops over it are not
+//disturbed) and out of the free lists (so nothing still pointing at it sees it reused) until the next Flush.
+//whether an object is the pool's to take back is the pool's own state (poolSlot, poolReleased), not active:
+//a caller may switch an object off first and Release it later, as the deferred death and depletion messages do
+class GameObjectPool
+{
+public:
+	GameObjectPool();
+	~GameObjectPool();
+
+	void Init(std::vector<GameObject*>* goList, int growBy = 10);
+	void Clear(); //forget all bookkeeping, call before the scene deletes its objects
+	void SetSpatialGrid(SpatialGrid* grid); //told about every Acquire and Release, see SpatialGrid::Add/Remove
+	void SetUnitStore(UnitStore* units);    //likewise, see UnitStore::Add/Remove
+
+	void Reserve(GameObject::GAMEOBJECT_TYPE type, int count); //make sure count objects of this type exist
+	GameObject* Acquire(GameObject::GAMEOBJECT_TYPE type);     //active object, allocates growBy more if none are free
+	void Release(GameObject* go);                              //deactivates go, recycled at the next Flush; once per Acquire, repeats are ignored
+	void Flush();                                              //swap-remove released objects from the active list
+
+	//objects handed out and not yet flushed, in no particular order
+	//Acquire appends to it, so index it (not iterators) in loops that can spawn
+	const std::vector<GameObject*>& GetActive() const;
+
+	int GetActiveCount(GameObject::GAMEOBJECT_TYPE type) const;
+	int GetPeakCount(GameObject::GAMEOBJECT_TYPE type) const;
+	int GetCapacity(GameObject::GAMEOBJECT_TYPE type) const;
+	int GetPeakTotal() const;     //most objects (all types) active at once
+	int GetCapacityTotal() const; //objects created so far
+	int GetGrowCount() const;     //allocations after Reserve, ideally 0
+	int CountInactive() const;    //switched-off objects in GetActive(), 0 straight after Flush unless one was never released
+
+private:
+	void Grow(GameObject::GAMEOBJECT_TYPE type, int count);
+
+	std::vector<GameObject*>* m_goList;
+	SpatialGrid* m_grid;
+	UnitStore* m_units;
+	int m_growBy;
+	std::vector<GameObject*> m_free[GameObject::GO_TOTAL];
+	std::vector<GameObject*> m_activeList;
+	std::vector<GameObject*> m_released;
+	int m_active[GameObject::GO_TOTAL];
+	int m_peak[GameObject::GO_TOTAL];
+	int m_capacity[GameObject::GO_TOTAL];
+	int m_activeTotal;
+	int m_peakTotal;
+	int m_growCount;
+};
+
+#endif
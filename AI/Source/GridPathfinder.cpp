@@ -0,0 +1,183 @@
+#include "GridPathfinder.h"
+#include <algorithm>
+#include <climits>
+
+GridPathfinder::GridPathfinder()
+	: m_width(0), m_height(0), m_blocked(nullptr),
+	m_algorithm(ALGO_ASTAR), m_nodesExpanded(0), m_goalX(0), m_goalY(0), m_generation(0),
+	m_bucketMin(INT_MAX), m_bucketMax(-1)
+{
+}
+
+GridPathfinder::~GridPathfinder()
+{
+}
+
+void GridPathfinder::Init(const BitGrid* blocked)
+{
+	m_width = blocked->GetWidth();
+	m_height = blocked->GetHeight();
+	m_blocked = blocked;
+
+	int size = m_width * m_height;
+	m_generation = 0;
+	Node blank = { 0, 0, 0, -1 };
+	m_nodes.assign(size, blank);
+	m_buckets.clear();
+	m_bucketMin = INT_MAX;
+	m_bucketMax = -1;
+	m_queue.clear();
+	m_queue.reserve(size / 4 + 16);
+}
+
+void GridPathfinder::SetAlgorithm(ALGORITHM algorithm)
+{
+	m_algorithm = algorithm;
+}
+
+GridPathfinder::ALGORITHM GridPathfinder::GetAlgorithm() const
+{
+	return m_algorithm;
+}
+
+int GridPathfinder::GetNodesExpanded() const
+{
+	return m_nodesExpanded;
+}
+
+void GridPathfinder::BeginQuery()
+{
+	//stamps from older queries stay below the new generation, so nothing needs clearing
+	//...until the counter wraps, once every 4 billion queries
+	if (++m_generation == 0)
+	{
+		for (size_t i = 0; i < m_nodes.size(); ++i)
+			m_nodes[i].seen = m_nodes[i].closed = 0;
+		m_generation = 1;
+	}
+	//a query that found its goal leaves nodes behind, only in the buckets it used
+	for (int f = m_bucketMin; f <= m_bucketMax; ++f)
+		m_buckets[f].clear();
+	m_bucketMin = INT_MAX;
+	m_bucketMax = -1;
+	m_queue.clear();
+	m_nodesExpanded = 0;
+}
+
+void GridPathfinder::PushOpen(int index, int g, int parent, int h)
+{
+	if (m_nodes[index].closed == m_generation)
+		return;
+	if (m_nodes[index].seen == m_generation && m_nodes[index].g <= g)
+		return;
+	m_nodes[index].seen = m_generation;
+	m_nodes[index].g = g;
+	m_nodes[index].parent = parent;
+
+	int f = g + h;
+	if (f >= static_cast<int>(m_buckets.size()))
+		m_buckets.resize(f + 1);
+	m_buckets[f].push_back(index);
+	m_bucketMin = std::min(m_bucketMin, f);
+	m_bucketMax = std::max(m_bucketMax, f);
+}
+
+int GridPathfinder::PopOpen()
+{
+	while (m_bucketMin <= m_bucketMax)
+	{
+		std::vector<int>& bucket = m_buckets[m_bucketMin];
+		if (bucket.empty())
+		{
+			++m_bucketMin;
+			continue;
+		}
+		int index = bucket.back();
+		bucket.pop_back();
+		return index;
+	}
+	return -1;
+}
+
+std::vector<MazePt> GridPathfinder::FindPath(MazePt start, MazePt end)
+{
+	std::vector<MazePt> path;
+	if (start.x == end.x && start.y == end.y) return path;
+	if (end.x < 0 || end.x >= m_width || end.y < 0 || end.y >= m_height) return path;
+	if (IsBlocked(end.x, end.y)) return path; // Cannot path TO a solid object (must path to neighbor)
+	if (start.x < 0 || start.x >= m_width || start.y < 0 || start.y >= m_height) return path;
+
+	int startIdx = start.y * m_width + start.x;
+	int goalIdx = end.y * m_width + end.x;
+	m_goalX = end.x;
+	m_goalY = end.y;
+	BeginQuery();
+
+	bool found = false;
+	switch (m_algorithm)
+	{
+	case ALGO_BFS: found = SearchBFS(startIdx, goalIdx); break;
+	case ALGO_ASTAR: found = SearchAStar(startIdx, goalIdx); break;
+	}
+	if (!found)
+		return path;
+
+	//walk the parent links back to the start
+	for (int curr = goalIdx; curr != startIdx; curr = m_nodes[curr].parent)
+		path.push_back(MazePt(curr % m_width, curr / m_width));
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+bool GridPathfinder::SearchBFS(int start, int goal)
+{
+	const int dx[] = { 0, 0, -1, 1 }; const int dy[] = { 1, -1, 0, 0 };
+	m_nodes[start].seen = m_generation;
+	m_nodes[start].parent = -1;
+	m_queue.push_back(start);
+	for (size_t head = 0; head < m_queue.size(); ++head)
+	{
+		int curr = m_queue[head];
+		++m_nodesExpanded;
+		if (curr == goal)
+			return true;
+		int x = curr % m_width, y = curr / m_width;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = x + dx[i]; int ny = y + dy[i];
+			if (IsBlocked(nx, ny))
+				continue;
+			int next = ny * m_width + nx;
+			if (m_nodes[next].seen == m_generation)
+				continue;
+			m_nodes[next].seen = m_generation;
+			m_nodes[next].parent = curr;
+			m_queue.push_back(next);
+		}
+	}
+	return false;
+}
+
+bool GridPathfinder::SearchAStar(int start, int goal)
+{
+	const int dx[] = { 0, 0, -1, 1 }; const int dy[] = { 1, -1, 0, 0 };
+	PushOpen(start, 0, -1, Heuristic(start % m_width, start / m_width));
+	for (int curr = PopOpen(); curr >= 0; curr = PopOpen())
+	{
+		if (m_nodes[curr].closed == m_generation)
+			continue; //stale duplicate
+		m_nodes[curr].closed = m_generation;
+		++m_nodesExpanded;
+		if (curr == goal)
+			return true;
+
+		int x = curr % m_width, y = curr / m_width;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = x + dx[i]; int ny = y + dy[i];
+			if (!IsBlocked(nx, ny))
+				PushOpen(ny * m_width + nx, m_nodes[curr].g + 1, curr, Heuristic(nx, ny));
+		}
+	}
+	return false;
+}
@@ -0,0 +1,85 @@
+#ifndef GRID_PATHFINDER_H
+#define GRID_PATHFINDER_H
+
+#include <vector>
+#include "Maze.h"
+#include "BitGrid.h"
+
+//4-way shortest paths on the sandbox grid
+//a cell is blocked if it is off the map, a wall or a food tile (same rule as SceneSandbox::IsGridOccupied),
+//read straight from a BitGrid whose set border stands in for "off the map"
+//all scratch data is sized once in Init and tagged with a per-query generation number,
+//so a query never clears or allocates anything proportional to the grid size
+class GridPathfinder
+{
+public:
+	enum ALGORITHM
+	{
+		ALGO_BFS,   //uninformed breadth-first search (the original SceneSandbox::FindPath)
+		ALGO_ASTAR, //A* with the manhattan heuristic
+	};
+
+	GridPathfinder();
+	~GridPathfinder();
+
+	//the obstacle grid (walls and food, border set) is read on every query, keep it alive while in use
+	void Init(const BitGrid* blocked);
+	void SetAlgorithm(ALGORITHM algorithm);
+	ALGORITHM GetAlgorithm() const;
+
+	//cells from start (exclusive) to end (inclusive), empty if start == end, end is blocked or unreachable
+	std::vector<MazePt> FindPath(MazePt start, MazePt end);
+	int GetNodesExpanded() const; //for the last query
+
+	bool IsBlocked(int x, int y) const; //at most one cell off the map
+
+private:
+	//everything a search keeps per cell, side by side so a visit touches one cache line
+	struct Node
+	{
+		unsigned seen;   //== m_generation once g/parent are valid this query
+		unsigned closed; //== m_generation once expanded this query
+		int g;
+		int parent;
+	};
+
+	void BeginQuery();
+	int Heuristic(int x, int y) const;
+	void PushOpen(int index, int g, int parent, int h);
+	int PopOpen(); //-1 once the open list is empty
+
+	bool SearchBFS(int start, int goal);
+	bool SearchAStar(int start, int goal);
+
+	int m_width;
+	int m_height;
+	const BitGrid* m_blocked;
+	ALGORITHM m_algorithm;
+	int m_nodesExpanded;
+	int m_goalX;
+	int m_goalY;
+
+	unsigned m_generation;
+	std::vector<Node> m_nodes;
+	//open list (A*): costs are whole cells and the heuristic is consistent, so f never drops below
+	//the last f popped and a bucket per f value (Dial's algorithm) replaces the heap.
+	//last in first out within a bucket, which favours the deepest node of equal f, the one nearer the goal
+	std::vector<std::vector<int> > m_buckets;
+	int m_bucketMin; //no open node has a lower f
+	int m_bucketMax; //highest f pushed this query
+	std::vector<int> m_queue;       //FIFO (BFS)
+};
+
+inline bool GridPathfinder::IsBlocked(int x, int y) const
+{
+	return m_blocked->Get(x, y);
+}
+
+inline int GridPathfinder::Heuristic(int x, int y) const
+{
+	int dx = x - m_goalX;
+	int dy = y - m_goalY;
+	return (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+}
+
+#endif
@@ -0,0 +1,492 @@
+#include "HierarchicalPathfinder.h"
+#include <algorithm>
+#include "MyMath.h"
+
+namespace
+{
+	const int STEP_X[] = { 0, 0, -1, 1 };
+	const int STEP_Y[] = { 1, -1, 0, 0 };
+	const int LONG_ENTRANCE = 6; //runs of open border cells at least this long get an entrance at each end
+}
+
+ClusterGraph::ClusterGraph()
+	: m_width(0), m_height(0), m_blocked(nullptr),
+	m_clusterSize(0), m_clustersX(0), m_clustersY(0), m_nodeCount(0)
+{
+}
+
+ClusterGraph::~ClusterGraph()
+{
+}
+
+void ClusterGraph::Init(const BitGrid* blocked, int clusterSize)
+{
+	m_width = blocked->GetWidth();
+	m_height = blocked->GetHeight();
+	m_blocked = blocked;
+	m_clusterSize = clusterSize < 2 ? 2 : clusterSize;
+	m_clustersX = (m_width + m_clusterSize - 1) / m_clusterSize;
+	m_clustersY = (m_height + m_clusterSize - 1) / m_clusterSize;
+
+	int clusters = m_clustersX * m_clustersY;
+	m_nodes.clear();
+	m_freeNodes.clear();
+	m_nodeCount = 0;
+	m_clusterNodes.assign(clusters, std::vector<int>());
+	m_eastBorder.assign(clusters, std::vector<int>());
+	m_northBorder.assign(clusters, std::vector<int>());
+	m_dist.assign(m_clusterSize * m_clusterSize, -1);
+	m_queue.clear();
+	m_queue.reserve(m_clusterSize * m_clusterSize);
+
+	for (int c = 0; c < clusters; ++c)
+	{
+		BuildBorder(c, true);
+		BuildBorder(c, false);
+	}
+	for (int c = 0; c < clusters; ++c)
+		BuildIntraEdges(c);
+}
+
+void ClusterGraph::Clear()
+{
+	m_nodes.clear();
+	m_freeNodes.clear();
+	m_nodeCount = 0;
+	m_clusterNodes.clear();
+	m_eastBorder.clear();
+	m_northBorder.clear();
+	m_clusterSize = m_clustersX = m_clustersY = 0;
+}
+
+void ClusterGraph::RepairCell(int x, int y)
+{
+	if (m_clusterSize == 0 || x < 0 || x >= m_width || y < 0 || y >= m_height)
+		return;
+	int c = GetCluster(x, y);
+	int cx = c % m_clustersX, cy = c / m_clustersX;
+	int x0, y0, x1, y1;
+	GetClusterBounds(c, x0, y0, x1, y1);
+
+	//entrances only change on a border the cell lies on, and then so do the intra edges across it
+	bool east = x == x1 - 1 && cx + 1 < m_clustersX;
+	bool west = x == x0 && cx > 0;
+	bool north = y == y1 - 1 && cy + 1 < m_clustersY;
+	bool south = y == y0 && cy > 0;
+	if (east) { ClearBorder(m_eastBorder[c]); BuildBorder(c, true); }
+	if (north) { ClearBorder(m_northBorder[c]); BuildBorder(c, false); }
+	if (west) { ClearBorder(m_eastBorder[c - 1]); BuildBorder(c - 1, true); }
+	if (south) { ClearBorder(m_northBorder[c - m_clustersX]); BuildBorder(c - m_clustersX, false); }
+
+	BuildIntraEdges(c);
+	if (east) BuildIntraEdges(c + 1);
+	if (north) BuildIntraEdges(c + m_clustersX);
+	if (west) BuildIntraEdges(c - 1);
+	if (south) BuildIntraEdges(c - m_clustersX);
+}
+
+int ClusterGraph::GetWidth() const
+{
+	return m_width;
+}
+
+int ClusterGraph::GetHeight() const
+{
+	return m_height;
+}
+
+int ClusterGraph::GetClusterSize() const
+{
+	return m_clusterSize;
+}
+
+int ClusterGraph::GetCluster(int x, int y) const
+{
+	return (y / m_clusterSize) * m_clustersX + x / m_clusterSize;
+}
+
+void ClusterGraph::GetClusterBounds(int cluster, int& x0, int& y0, int& x1, int& y1) const
+{
+	x0 = (cluster % m_clustersX) * m_clusterSize;
+	y0 = (cluster / m_clustersX) * m_clusterSize;
+	x1 = Math::Min(x0 + m_clusterSize, m_width);
+	y1 = Math::Min(y0 + m_clusterSize, m_height);
+}
+
+const std::vector<int>& ClusterGraph::GetClusterNodes(int cluster) const
+{
+	return m_clusterNodes[cluster];
+}
+
+const ClusterGraph::Node& ClusterGraph::GetNode(int id) const
+{
+	return m_nodes[id];
+}
+
+int ClusterGraph::GetNodeCapacity() const
+{
+	return static_cast<int>(m_nodes.size());
+}
+
+int ClusterGraph::GetNodeCount() const
+{
+	return m_nodeCount;
+}
+
+int ClusterGraph::AddNode(int cell, int cluster)
+{
+	int id;
+	if (!m_freeNodes.empty()) { id = m_freeNodes.back(); m_freeNodes.pop_back(); }
+	else { id = static_cast<int>(m_nodes.size()); m_nodes.push_back(Node()); }
+	m_nodes[id].cell = cell;
+	m_nodes[id].cluster = cluster;
+	m_nodes[id].edges.clear();
+	m_clusterNodes[cluster].push_back(id);
+	++m_nodeCount;
+	return id;
+}
+
+void ClusterGraph::ClearBorder(std::vector<int>& border)
+{
+	//edges into these nodes come from their partner across the border (also in here) or from their own
+	//cluster, whose intra edges the caller rebuilds
+	for (size_t i = 0; i < border.size(); ++i)
+	{
+		Node& node = m_nodes[border[i]];
+		std::vector<int>& nodes = m_clusterNodes[node.cluster];
+		nodes.erase(std::find(nodes.begin(), nodes.end(), border[i]));
+		node.cluster = -1;
+		node.edges.clear();
+		m_freeNodes.push_back(border[i]);
+		--m_nodeCount;
+	}
+	border.clear();
+}
+
+void ClusterGraph::BuildBorder(int cluster, bool east)
+{
+	int cx = cluster % m_clustersX, cy = cluster / m_clustersX;
+	if (east ? cx + 1 >= m_clustersX : cy + 1 >= m_clustersY)
+		return;
+	int x0, y0, x1, y1;
+	GetClusterBounds(cluster, x0, y0, x1, y1);
+	int other = east ? cluster + 1 : cluster + m_clustersX;
+	int dx = east ? 1 : 0, dy = east ? 0 : 1;
+	std::vector<int>& border = east ? m_eastBorder[cluster] : m_northBorder[cluster];
+
+	int length = east ? y1 - y0 : x1 - x0;
+	int runStart = -1;
+	for (int i = 0; i <= length; ++i)
+	{
+		int x = east ? x1 - 1 : x0 + i;
+		int y = east ? y0 + i : y1 - 1;
+		if (i < length && !IsBlocked(x, y) && !IsBlocked(x + dx, y + dy))
+		{
+			if (runStart < 0) runStart = i;
+			continue;
+		}
+		if (runStart < 0)
+			continue;
+
+		//one entrance in the middle of a short run, one at each end of a long one
+		int runEnd = i - 1;
+		int picks[2] = { (runStart + runEnd) / 2, -1 };
+		if (runEnd - runStart + 1 >= LONG_ENTRANCE) { picks[0] = runStart; picks[1] = runEnd; }
+		for (int p = 0; p < 2 && picks[p] >= 0; ++p)
+		{
+			int px = east ? x1 - 1 : x0 + picks[p];
+			int py = east ? y0 + picks[p] : y1 - 1;
+			int inside = AddNode(py * m_width + px, cluster);
+			int outside = AddNode((py + dy) * m_width + px + dx, other);
+			Edge toOutside = { outside, 1 };
+			Edge toInside = { inside, 1 };
+			m_nodes[inside].edges.push_back(toOutside);
+			m_nodes[outside].edges.push_back(toInside);
+			border.push_back(inside);
+			border.push_back(outside);
+		}
+		runStart = -1;
+	}
+}
+
+void ClusterGraph::BuildIntraEdges(int cluster)
+{
+	const std::vector<int>& nodes = m_clusterNodes[cluster];
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		std::vector<Edge>& edges = m_nodes[nodes[i]].edges;
+		edges.erase(std::remove_if(edges.begin(), edges.end(), [this, cluster](const Edge& edge) { return m_nodes[edge.to].cluster == cluster; }), edges.end());
+	}
+
+	int x0, y0, x1, y1;
+	GetClusterBounds(cluster, x0, y0, x1, y1);
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		Flood(cluster, m_nodes[nodes[i]].cell);
+		for (size_t j = i + 1; j < nodes.size(); ++j)
+		{
+			int cell = m_nodes[nodes[j]].cell;
+			int dist = m_dist[(cell / m_width - y0) * m_clusterSize + cell % m_width - x0];
+			if (dist < 0)
+				continue;
+			Edge forward = { nodes[j], dist };
+			Edge backward = { nodes[i], dist };
+			m_nodes[nodes[i]].edges.push_back(forward);
+			m_nodes[nodes[j]].edges.push_back(backward);
+		}
+	}
+}
+
+void ClusterGraph::Flood(int cluster, int from)
+{
+	int x0, y0, x1, y1;
+	GetClusterBounds(cluster, x0, y0, x1, y1);
+	std::fill(m_dist.begin(), m_dist.end(), -1);
+	m_queue.clear();
+	int local = (from / m_width - y0) * m_clusterSize + from % m_width - x0;
+	m_dist[local] = 0;
+	m_queue.push_back(local);
+	for (size_t head = 0; head < m_queue.size(); ++head)
+	{
+		int curr = m_queue[head];
+		int x = x0 + curr % m_clusterSize, y = y0 + curr / m_clusterSize;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = x + STEP_X[i], ny = y + STEP_Y[i];
+			if (nx < x0 || nx >= x1 || ny < y0 || ny >= y1 || IsBlocked(nx, ny))
+				continue;
+			int next = (ny - y0) * m_clusterSize + nx - x0;
+			if (m_dist[next] >= 0)
+				continue;
+			m_dist[next] = m_dist[curr] + 1;
+			m_queue.push_back(next);
+		}
+	}
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder()
+	: m_graph(nullptr), m_nodesExpanded(0), m_generation(0), m_goalNode(0)
+{
+}
+
+HierarchicalPathfinder::~HierarchicalPathfinder()
+{
+}
+
+void HierarchicalPathfinder::Init(const ClusterGraph* graph)
+{
+	m_graph = graph;
+	int area = graph->GetClusterSize() * graph->GetClusterSize();
+	m_dist.assign(area, -1);
+	m_parent.assign(area, -1);
+	m_queue.clear();
+	m_queue.reserve(area);
+	m_generation = 0;
+	m_seen.clear();
+	m_closed.clear();
+	m_goalSeen.clear();
+}
+
+int HierarchicalPathfinder::GetNodesExpanded() const
+{
+	return m_nodesExpanded;
+}
+
+std::vector<MazePt> HierarchicalPathfinder::FindPath(MazePt start, MazePt end)
+{
+	std::vector<MazePt> path;
+	m_nodesExpanded = 0;
+	if (!m_graph || m_graph->GetClusterSize() == 0) return path;
+	if (start.x == end.x && start.y == end.y) return path;
+	int width = m_graph->GetWidth();
+	int height = m_graph->GetHeight();
+	if (end.x < 0 || end.x >= width || end.y < 0 || end.y >= height) return path;
+	if (m_graph->IsBlocked(end.x, end.y)) return path;
+	if (start.x < 0 || start.x >= width || start.y < 0 || start.y >= height) return path;
+
+	int startCell = start.y * width + start.x;
+	int goalCell = end.y * width + end.x;
+	int startCluster = m_graph->GetCluster(start.x, start.y);
+	int goalCluster = m_graph->GetCluster(end.x, end.y);
+
+	//close enough to stay inside one cluster
+	if (startCluster == goalCluster && Flood(startCluster, startCell, goalCell))
+	{
+		AppendRoute(startCluster, goalCell, path);
+		return path;
+	}
+	if (!SearchAbstract(startCell, goalCell, startCluster, goalCluster))
+		return path;
+
+	//an entrance in another cluster is one step across a border, one in the same cluster a search inside it
+	int from = startCell, fromCluster = startCluster;
+	for (size_t i = 0; i < m_route.size(); ++i)
+	{
+		const ClusterGraph::Node& node = m_graph->GetNode(m_route[i]);
+		if (node.cluster != fromCluster)
+			path.push_back(MazePt(node.cell % width, node.cell / width));
+		else if (node.cell != from)
+		{
+			Flood(fromCluster, from, node.cell);
+			AppendRoute(fromCluster, node.cell, path);
+		}
+		from = node.cell;
+		fromCluster = node.cluster;
+	}
+	if (from != goalCell)
+	{
+		Flood(goalCluster, from, goalCell);
+		AppendRoute(goalCluster, goalCell, path);
+	}
+	return path;
+}
+
+bool HierarchicalPathfinder::Flood(int cluster, int from, int to)
+{
+	int width = m_graph->GetWidth();
+	int size = m_graph->GetClusterSize();
+	int x0, y0, x1, y1;
+	m_graph->GetClusterBounds(cluster, x0, y0, x1, y1);
+	std::fill(m_dist.begin(), m_dist.end(), -1);
+	m_queue.clear();
+	int local = (from / width - y0) * size + from % width - x0;
+	int target = to < 0 ? -1 : (to / width - y0) * size + to % width - x0;
+	m_dist[local] = 0;
+	m_parent[local] = -1;
+	m_queue.push_back(local);
+	for (size_t head = 0; head < m_queue.size(); ++head)
+	{
+		int curr = m_queue[head];
+		++m_nodesExpanded;
+		if (curr == target)
+			return true;
+		int x = x0 + curr % size, y = y0 + curr / size;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = x + STEP_X[i], ny = y + STEP_Y[i];
+			if (nx < x0 || nx >= x1 || ny < y0 || ny >= y1 || m_graph->IsBlocked(nx, ny))
+				continue;
+			int next = (ny - y0) * size + nx - x0;
+			if (m_dist[next] >= 0)
+				continue;
+			m_dist[next] = m_dist[curr] + 1;
+			m_parent[next] = curr;
+			m_queue.push_back(next);
+		}
+	}
+	return false;
+}
+
+void HierarchicalPathfinder::AppendRoute(int cluster, int to, std::vector<MazePt>& path)
+{
+	int width = m_graph->GetWidth();
+	int size = m_graph->GetClusterSize();
+	int x0, y0, x1, y1;
+	m_graph->GetClusterBounds(cluster, x0, y0, x1, y1);
+	size_t first = path.size();
+	for (int curr = (to / width - y0) * size + to % width - x0; m_parent[curr] >= 0; curr = m_parent[curr])
+		path.push_back(MazePt(x0 + curr % size, y0 + curr / size));
+	std::reverse(path.begin() + first, path.end());
+}
+
+void HierarchicalPathfinder::PushOpen(int node, int g, int parent, int goalCell)
+{
+	if (m_closed[node] == m_generation)
+		return;
+	if (m_seen[node] == m_generation && m_g[node] <= g)
+		return;
+	m_seen[node] = m_generation;
+	m_g[node] = g;
+	m_nodeParent[node] = parent;
+
+	int h = 0;
+	if (node != m_goalNode)
+	{
+		int width = m_graph->GetWidth();
+		int cell = m_graph->GetNode(node).cell;
+		int dx = cell % width - goalCell % width, dy = cell / width - goalCell / width;
+		h = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+	}
+	OpenNode open = { g + h, node };
+	m_open.push_back(open);
+	std::push_heap(m_open.begin(), m_open.end(), OpenNodeCompare());
+}
+
+bool HierarchicalPathfinder::SearchAbstract(int start, int goal, int startCluster, int goalCluster)
+{
+	//the graph grows when repairs add entrances, the virtual goal node sits after the last one
+	int capacity = m_graph->GetNodeCapacity();
+	m_goalNode = capacity;
+	if (static_cast<int>(m_seen.size()) < capacity + 1)
+	{
+		m_seen.resize(capacity + 1, 0);
+		m_closed.resize(capacity + 1, 0);
+		m_goalSeen.resize(capacity + 1, 0);
+		m_g.resize(capacity + 1);
+		m_nodeParent.resize(capacity + 1);
+		m_goalCost.resize(capacity + 1);
+	}
+	if (++m_generation == 0)
+	{
+		std::fill(m_seen.begin(), m_seen.end(), 0);
+		std::fill(m_closed.begin(), m_closed.end(), 0);
+		std::fill(m_goalSeen.begin(), m_goalSeen.end(), 0);
+		m_generation = 1;
+	}
+	m_open.clear();
+	m_route.clear();
+
+	int width = m_graph->GetWidth();
+	int size = m_graph->GetClusterSize();
+	int x0, y0, x1, y1;
+
+	//how far each entrance of the goal's cluster is from the goal (the grid is undirected)
+	Flood(goalCluster, goal, -1);
+	m_graph->GetClusterBounds(goalCluster, x0, y0, x1, y1);
+	const std::vector<int>& goalNodes = m_graph->GetClusterNodes(goalCluster);
+	for (size_t i = 0; i < goalNodes.size(); ++i)
+	{
+		int cell = m_graph->GetNode(goalNodes[i]).cell;
+		int dist = m_dist[(cell / width - y0) * size + cell % width - x0];
+		if (dist < 0)
+			continue;
+		m_goalSeen[goalNodes[i]] = m_generation;
+		m_goalCost[goalNodes[i]] = dist;
+	}
+
+	Flood(startCluster, start, -1);
+	m_graph->GetClusterBounds(startCluster, x0, y0, x1, y1);
+	const std::vector<int>& startNodes = m_graph->GetClusterNodes(startCluster);
+	for (size_t i = 0; i < startNodes.size(); ++i)
+	{
+		int cell = m_graph->GetNode(startNodes[i]).cell;
+		int dist = m_dist[(cell / width - y0) * size + cell % width - x0];
+		if (dist >= 0)
+			PushOpen(startNodes[i], dist, -1, goal);
+	}
+
+	while (!m_open.empty())
+	{
+		std::pop_heap(m_open.begin(), m_open.end(), OpenNodeCompare());
+		int curr = m_open.back().index;
+		m_open.pop_back();
+		if (m_closed[curr] == m_generation)
+			continue;
+		m_closed[curr] = m_generation;
+		++m_nodesExpanded;
+		if (curr == m_goalNode)
+		{
+			for (int node = m_nodeParent[curr]; node >= 0; node = m_nodeParent[node])
+				m_route.push_back(node);
+			std::reverse(m_route.begin(), m_route.end());
+			return true;
+		}
+
+		const std::vector<ClusterGraph::Edge>& edges = m_graph->GetNode(curr).edges;
+		for (size_t i = 0; i < edges.size(); ++i)
+			PushOpen(edges[i].to, m_g[curr] + edges[i].cost, curr, goal);
+		if (m_goalSeen[curr] == m_generation)
+			PushOpen(m_goalNode, m_g[curr] + m_goalCost[curr], curr, goal);
+	}
+	return false;
+}
@@ -0,0 +1,129 @@
+#ifndef HIERARCHICAL_PATHFINDER_H
+#define HIERARCHICAL_PATHFINDER_H
+
+#include <vector>
+#include "Maze.h"
+#include "BitGrid.h"
+
+//abstract graph for hierarchical pathfinding (HPA*) on large sandbox grids
+//the grid is cut into square clusters. wherever two clusters share a run of open border cells there is an
+//entrance: a node on each side (one in the middle of a short run, one at each end of a long one) joined by
+//a step of cost 1. nodes in the same cluster are joined by their shortest distance inside the cluster.
+//a cell that opens or closes only changes its own cluster (and, on a border, the entrances there and
+//the cluster across it), so RepairCell rebuilds those instead of the whole graph. blocked cells follow GridPathfinder::IsBlocked
+class ClusterGraph
+{
+public:
+	struct Edge
+	{
+		int to;
+		int cost;
+	};
+	struct Node
+	{
+		int cell;
+		int cluster; //-1 while the slot is free
+		std::vector<Edge> edges;
+	};
+
+	ClusterGraph();
+	~ClusterGraph();
+
+	//the obstacle grid (walls and food, border set) is read by Init and RepairCell, keep it alive while in use
+	void Init(const BitGrid* blocked, int clusterSize = 16);
+	void Clear();
+	void RepairCell(int x, int y); //after the cell's wall or food state changed
+
+	bool IsBlocked(int x, int y) const; //at most one cell off the map
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetClusterSize() const; //0 until Init
+	int GetCluster(int x, int y) const;
+	void GetClusterBounds(int cluster, int& x0, int& y0, int& x1, int& y1) const; //x1, y1 exclusive
+	const std::vector<int>& GetClusterNodes(int cluster) const;
+	const Node& GetNode(int id) const;
+	int GetNodeCapacity() const; //every node id is below this
+	int GetNodeCount() const;
+
+private:
+	void BuildBorder(int cluster, bool east); //entrances to the east or north neighbour
+	void ClearBorder(std::vector<int>& border);
+	void BuildIntraEdges(int cluster);
+	int AddNode(int cell, int cluster);
+	void Flood(int cluster, int from); //distances inside the cluster into m_dist
+
+	int m_width;
+	int m_height;
+	const BitGrid* m_blocked;
+	int m_clusterSize;
+	int m_clustersX;
+	int m_clustersY;
+	std::vector<Node> m_nodes;
+	std::vector<int> m_freeNodes;
+	int m_nodeCount;
+	std::vector<std::vector<int>> m_clusterNodes;
+	std::vector<std::vector<int>> m_eastBorder;  //node ids on both sides of each cluster's east edge
+	std::vector<std::vector<int>> m_northBorder;
+	std::vector<int> m_dist;  //flood scratch, one cluster, -1 = not reached
+	std::vector<int> m_queue;
+};
+
+inline bool ClusterGraph::IsBlocked(int x, int y) const
+{
+	return m_blocked->Get(x, y);
+}
+
+//HPA* queries over a ClusterGraph: connect start and goal to the entrances of their clusters, A* across the
+//entrance graph, then refine each hop with a search inside its cluster. paths are close to shortest, not exact.
+//each instance only has per-cluster and per-node scratch, so give every thread its own; any number can
+//share one graph as long as nothing repairs it meanwhile
+class HierarchicalPathfinder
+{
+public:
+	HierarchicalPathfinder();
+	~HierarchicalPathfinder();
+
+	void Init(const ClusterGraph* graph);
+
+	//same contract as GridPathfinder::FindPath
+	std::vector<MazePt> FindPath(MazePt start, MazePt end);
+	int GetNodesExpanded() const; //cells flooded plus entrances expanded, for the last query
+
+private:
+	struct OpenNode
+	{
+		int f;
+		int index;
+	};
+	struct OpenNodeCompare
+	{
+		bool operator()(const OpenNode& lhs, const OpenNode& rhs) const { return lhs.f > rhs.f; }
+	};
+
+	bool Flood(int cluster, int from, int to); //BFS inside the cluster, stops early once 'to' is reached (-1 = never)
+	void AppendRoute(int cluster, int to, std::vector<MazePt>& path); //cells after the last Flood's start up to 'to', once it reached it
+	bool SearchAbstract(int start, int goal, int startCluster, int goalCluster);
+	void PushOpen(int node, int g, int parent, int goalCell);
+
+	const ClusterGraph* m_graph;
+	int m_nodesExpanded;
+
+	//cluster-local
+	std::vector<int> m_dist;
+	std::vector<int> m_parent; //local index, -1 at the flood's origin
+	std::vector<int> m_queue;
+
+	//per entrance node, plus the virtual goal at the end
+	unsigned m_generation;
+	std::vector<unsigned> m_seen;
+	std::vector<unsigned> m_closed;
+	std::vector<unsigned> m_goalSeen; //== m_generation where m_goalCost is valid
+	std::vector<int> m_g;
+	std::vector<int> m_nodeParent; //-1 = came straight from the start
+	std::vector<int> m_goalCost;
+	int m_goalNode; //== the graph's node capacity at the start of the query
+	std::vector<OpenNode> m_open;
+	std::vector<int> m_route; //entrance nodes, start to goal
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem()
+	: m_func(nullptr), m_pending(0), m_generation(0), m_quit(false)
+{
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+void JobSystem::Init(int threadCount)
+{
+	Shutdown();
+	if (threadCount <= 0)
+		threadCount = static_cast<int>(std::thread::hardware_concurrency());
+	if (threadCount <= 0)
+		threadCount = 1;
+
+	m_quit = false;
+	for (int i = 0; i < threadCount; ++i)
+		m_queues.push_back(new WorkQueue());
+	for (int i = 1; i < threadCount; ++i)
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_wakeLock);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); ++i)
+		m_workers[i].join();
+	m_workers.clear();
+	for (size_t i = 0; i < m_queues.size(); ++i)
+		delete m_queues[i];
+	m_queues.clear();
+}
+
+int JobSystem::GetThreadCount() const
+{
+	return m_queues.empty() ? 1 : static_cast<int>(m_queues.size());
+}
+
+void JobSystem::ParallelFor(int count, int grain, const RangeFunc& func)
+{
+	if (count <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+	int chunks = (count + grain - 1) / grain;
+	int threads = static_cast<int>(m_queues.size());
+	if (chunks == 1 || threads <= 1)
+	{
+		func(0, count);
+		return;
+	}
+
+	//thread t gets chunks [t * chunks / threads, (t + 1) * chunks / threads), neighbouring entities stay together
+	m_func = &func;
+	m_pending.store(chunks);
+	for (int t = 0; t < threads; ++t)
+	{
+		std::lock_guard<std::mutex> guard(m_queues[t]->lock);
+		for (int c = t * chunks / threads; c < (t + 1) * chunks / threads; ++c)
+		{
+			Range range = { c * grain, (c + 1) * grain < count ? (c + 1) * grain : count };
+			m_queues[t]->ranges.push_back(range);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> guard(m_wakeLock);
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	while (m_pending.load() > 0)
+	{
+		if (!RunOne(0))
+			std::this_thread::yield();
+	}
+	m_func = nullptr;
+}
+
+void JobSystem::WorkerMain(int index)
+{
+	unsigned seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> guard(m_wakeLock);
+			m_wake.wait(guard, [&]() { return m_quit || m_generation != seen; });
+			if (m_quit)
+				return;
+			seen = m_generation;
+		}
+		while (m_pending.load() > 0)
+		{
+			if (!RunOne(index))
+				std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::RunOne(int index)
+{
+	Range range;
+	if (!PopOwn(index, range) && !Steal(index, range))
+		return false;
+	(*m_func)(range.begin, range.end);
+	m_pending.fetch_sub(1);
+	return true;
+}
+
+bool JobSystem::PopOwn(int index, Range& range)
+{
+	WorkQueue& queue = *m_queues[index];
+	std::lock_guard<std::mutex> guard(queue.lock);
+	if (queue.ranges.empty())
+		return false;
+	range = queue.ranges.back();
+	queue.ranges.pop_back();
+	return true;
+}
+
+bool JobSystem::Steal(int thief, Range& range)
+{
+	int threads = static_cast<int>(m_queues.size());
+	for (int k = 1; k < threads; ++k)
+	{
+		WorkQueue& queue = *m_queues[(thief + k) % threads];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (queue.ranges.empty())
+			continue;
+		range = queue.ranges.front();
+		queue.ranges.pop_front();
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,61 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+//work-stealing thread pool for data-parallel loops over entity ranges
+//ParallelFor cuts [0, count) into chunks and deals them out in contiguous blocks, one queue per thread.
+//each thread works from the back of its own queue and, once that is empty, steals from the front of
+//the others', so uneven chunks (a healer scanning every ally, an idle worker doing nothing) even out.
+//the calling thread takes part and ParallelFor returns once every chunk is done.
+//chunks must only write data no other chunk reads; ParallelFor must not be nested
+class JobSystem
+{
+public:
+	typedef std::function<void(int begin, int end)> RangeFunc;
+
+	JobSystem();
+	~JobSystem();
+
+	void Init(int threadCount = 0); //threads including the caller, 0 = one per hardware thread
+	void Shutdown();
+	int GetThreadCount() const;
+
+	//func(begin, end) over [0, count) in chunks of up to grain; runs inline if it is a single chunk
+	void ParallelFor(int count, int grain, const RangeFunc& func);
+
+private:
+	struct Range
+	{
+		int begin;
+		int end;
+	};
+	struct WorkQueue
+	{
+		std::mutex lock;
+		std::deque<Range> ranges;
+	};
+
+	void WorkerMain(int index);
+	bool RunOne(int index); //false if there was nothing left to run or steal
+	bool PopOwn(int index, Range& range);
+	bool Steal(int thief, Range& range);
+
+	std::vector<std::thread> m_workers;
+	std::vector<WorkQueue*> m_queues; //[0] belongs to the calling thread
+	const RangeFunc* m_func;
+	std::atomic<int> m_pending;        //chunks not finished yet
+
+	std::mutex m_wakeLock;
+	std::condition_variable m_wake;
+	unsigned m_generation;             //bumped for every ParallelFor, guarded by m_wakeLock
+	bool m_quit;
+};
+
+#endif
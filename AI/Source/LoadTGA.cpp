@@ -5,7 +5,8 @@
 
 #include "LoadTGA.h"
 
-GLuint LoadTGA(const char *file_path)				// load TGA file to memory
+// read the header and the BGR(A) pixels of an uncompressed 24 or 32 bit TGA, data is new[]ed
+static GLubyte* ReadTGA(const char *file_path, GLubyte header[18], unsigned& width, unsigned& height, GLuint& bytesPerPixel)
 {
 	std::ifstream fileStream(file_path, std::ios::binary);
 	if(!fileStream.is_open()) {
@@ -13,12 +14,8 @@ GLuint LoadTGA(const char *file_path)				// load TGA file to memory
 		return 0;
 	}
 
-	GLubyte		header[ 18 ];									// first 6 useful header bytes
-	GLuint		bytesPerPixel;								    // number of bytes per pixel in TGA gile
 	GLuint		imageSize;									    // for setting memory
 	GLubyte *	data;
-	GLuint		texture = 0;
-	unsigned	width, height;
 
 	fileStream.read((char*)header, 18);
 	width = header[12] + header[13] * 256;
@@ -37,9 +34,23 @@ GLuint LoadTGA(const char *file_path)				// load TGA file to memory
 	imageSize		= width * height * bytesPerPixel;	// calculate memory required for TGA data
 	
 	data = new GLubyte[ imageSize ];
-	fileStream.seekg(18, std::ios::beg);
+	fileStream.seekg(18 + header[0], std::ios::beg);		// skip the image ID field
 	fileStream.read((char *)data, imageSize);
 	fileStream.close();	
+	return data;
+}
+
+GLuint LoadTGA(const char *file_path)				// load TGA file to memory
+{
+	GLubyte		header[ 18 ];									// first 6 useful header bytes
+	GLuint		bytesPerPixel;								    // number of bytes per pixel in TGA gile
+	GLubyte *	data;
+	GLuint		texture = 0;
+	unsigned	width, height;
+
+	data = ReadTGA(file_path, header, width, height, bytesPerPixel);
+	if (!data)
+		return 0;
 
 	glGenTextures(1, &texture);
 	glBindTexture(GL_TEXTURE_2D, texture);
@@ -62,4 +73,30 @@ GLuint LoadTGA(const char *file_path)				// load TGA file to memory
 	delete []data;
 
 	return texture;						
+}
+
+bool LoadTGAPixels(const char *file_path, unsigned& width, unsigned& height, std::vector<unsigned char>& pixels)
+{
+	GLubyte		header[ 18 ];
+	GLuint		bytesPerPixel;
+	GLubyte *	data = ReadTGA(file_path, header, width, height, bytesPerPixel);
+	if (!data)
+		return false;
+
+	bool topDown = (header[17] & 0x20) != 0;				// image descriptor bit 5: first row is the top one
+	pixels.resize(width * height * 4);
+	for (unsigned row = 0; row < height; ++row)
+	{
+		const GLubyte* src = data + (topDown ? height - 1 - row : row) * width * bytesPerPixel;
+		unsigned char* dst = &pixels[row * width * 4];
+		for (unsigned col = 0; col < width; ++col, src += bytesPerPixel, dst += 4)
+		{
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = bytesPerPixel == 4 ? src[3] : 255;
+		}
+	}
+	delete []data;
+	return true;
 }
\ No newline at end of file
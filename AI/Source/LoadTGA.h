@@ -1,6 +1,10 @@
 #ifndef LOAD_TGA_H
 #define LOAD_TGA_H
 
+#include <vector>
+
 GLuint LoadTGA(const char *file_path);
+//decode without a GL context: RGBA bytes, bottom row first (as texture coordinates and the grids run)
+bool LoadTGAPixels(const char *file_path, unsigned& width, unsigned& height, std::vector<unsigned char>& pixels);
 
 #endif
\ No newline at end of file
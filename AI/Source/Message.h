@@ -3,11 +3,65 @@
 
 #include <string>
 
+typedef int AddressHandle; //an interned PostOffice address, see PostOffice::GetAddress
+
+//ownership: a message sent through PostOffice comes from MessagePool::Create and belongs to the pool,
+//which destroys it at the end of the frame. neither PostOffice nor a handler deletes it, and a handler
+//that needs its contents later copies them out. messages handed straight to Handle may live on the stack
+//
+//every concrete message (ConcreteMessages.h) has a compile-time TYPE from MESSAGE_TYPE and passes it up,
+//so a receiver can switch on GetType() or index a MessageDispatcher with it instead of trying dynamic_casts
 class Message
 {
 public:
-	Message() {}
+	enum MESSAGE_TYPE
+	{
+		MSG_WRU = 0,
+		MSG_CHECK_ACTIVE,
+		MSG_CHECK_FISH,
+		MSG_CHECK_FOOD,
+		MSG_CHECK_SHARK,
+		MSG_SPAWN,
+		MSG_SPAWN_FOOD,
+		MSG_STOP,
+		MSG_EVOLVE,
+		MSG_SPAWN_UNIT,
+		MSG_RESOURCE_FOUND,
+		MSG_RESOURCE_DEPLETED,
+		MSG_ENEMY_SPOTTED,
+		MSG_REQUEST_HELP,
+		MSG_RESOURCE_DELIVERED,
+		MSG_UNIT_DIED,
+		MSG_TERRITORY_CLAIMED,
+		MSG_QUEEN_THREAT,
+		NUM_MESSAGE_TYPES
+	};
+
+	explicit Message(MESSAGE_TYPE type) : m_type(type) {}
 	virtual ~Message() {}
+
+	MESSAGE_TYPE GetType() const { return m_type; }
+	//non-zero if a message of the same type and key does exactly what this one does, so MessageQueue can drop repeats
+	virtual unsigned long long GetCoalesceKey() const { return 0; }
+	static const char* GetTypeName(MESSAGE_TYPE type)
+	{
+		static const char* const names[NUM_MESSAGE_TYPES] = {
+			"WRU", "CheckActive", "CheckFish", "CheckFood", "CheckShark", "Spawn", "SpawnFood", "Stop", "Evolve",
+			"SpawnUnit", "ResourceFound", "ResourceDepleted", "EnemySpotted", "RequestHelp", "ResourceDelivered",
+			"UnitDied", "TerritoryClaimed", "QueenThreat",
+		};
+		return names[type];
+	}
+
+private:
+	MESSAGE_TYPE m_type;
 };
 
-#endif
\ No newline at end of file
+//the message as a T if that is what it is, else nullptr. a compare instead of dynamic_cast's RTTI walk
+template <typename T>
+T* MessageCast(Message* message)
+{
+	return (message && message->GetType() == T::TYPE) ? static_cast<T*>(message) : nullptr;
+}
+
+#endif
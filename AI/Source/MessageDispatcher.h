@@ -0,0 +1,50 @@
+#ifndef MESSAGE_DISPATCHER_H
+#define MESSAGE_DISPATCHER_H
+
+#include "Message.h"
+
+//a receiver's handlers in a table indexed by Message::GetType(), so Dispatch is one load and one call
+//whichever message comes in. handlers are member functions taking the concrete message type:
+//	m_dispatcher.Register<MessageUnitDied, &SceneSandbox::OnUnitDied>();
+//	bool SceneSandbox::Handle(Message* message) { return m_dispatcher.Dispatch(this, message, true); }
+template <typename Owner>
+class MessageDispatcher
+{
+public:
+	MessageDispatcher()
+	{
+		for (int i = 0; i < Message::NUM_MESSAGE_TYPES; ++i)
+			m_handlers[i] = nullptr;
+	}
+
+	template <typename T, bool (Owner::*Handler)(T*)>
+	void Register()
+	{
+		m_handlers[T::TYPE] = &Thunk<T, Handler>;
+	}
+
+	bool IsRegistered(Message::MESSAGE_TYPE type) const
+	{
+		return m_handlers[type] != nullptr;
+	}
+
+	//unhandled returns for message types with no handler registered
+	bool Dispatch(Owner* owner, Message* message, bool unhandled = false) const
+	{
+		HandlerFunc handler = m_handlers[message->GetType()];
+		return handler ? handler(owner, message) : unhandled;
+	}
+
+private:
+	typedef bool (*HandlerFunc)(Owner*, Message*);
+
+	template <typename T, bool (Owner::*Handler)(T*)>
+	static bool Thunk(Owner* owner, Message* message)
+	{
+		return (owner->*Handler)(static_cast<T*>(message));
+	}
+
+	HandlerFunc m_handlers[Message::NUM_MESSAGE_TYPES];
+};
+
+#endif
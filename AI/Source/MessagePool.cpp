@@ -0,0 +1,123 @@
+#include "MessagePool.h"
+
+namespace
+{
+	const size_t ALIGNMENT = 16;
+
+	size_t AlignUp(size_t size)
+	{
+		return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	}
+}
+
+MessagePool::MessagePool()
+	: m_current(0), m_frameTotal(0), m_peakFrameTotal(0)
+{
+	for (int i = 0; i < MAX_TYPES; ++i)
+	{
+		m_frameCounts[i] = m_lastFrameCounts[i] = 0;
+		m_totalCounts[i] = 0;
+	}
+}
+
+MessagePool::~MessagePool()
+{
+	Reset();
+	for (size_t i = 0; i < m_blocks.size(); ++i)
+		delete[] m_blocks[i].memory;
+}
+
+MessagePool::AllocHeader* MessagePool::Header(void* memory)
+{
+	return reinterpret_cast<AllocHeader*>(static_cast<char*>(memory) - AlignUp(sizeof(AllocHeader)));
+}
+
+void* MessagePool::Allocate(size_t size, Message::MESSAGE_TYPE type)
+{
+	size_t total = AlignUp(sizeof(AllocHeader)) + AlignUp(size);
+	std::lock_guard<std::mutex> guard(m_lock);
+	while (m_current < m_blocks.size() && m_blocks[m_current].used + total > BLOCK_SIZE)
+		++m_current;
+	if (m_current == m_blocks.size())
+	{
+		Block block;
+		block.memory = new char[BLOCK_SIZE];
+		block.used = 0;
+		m_blocks.push_back(block);
+	}
+	Block& block = m_blocks[m_current];
+	AllocHeader* header = reinterpret_cast<AllocHeader*>(block.memory + block.used);
+	header->message = nullptr;
+	header->size = total;
+	block.used += total;
+
+	++m_frameCounts[type];
+	++m_totalCounts[type];
+	++m_frameTotal;
+	return reinterpret_cast<char*>(header) + AlignUp(sizeof(AllocHeader));
+}
+
+void MessagePool::Reset()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	for (size_t i = 0; i < m_blocks.size(); ++i)
+	{
+		Block& block = m_blocks[i];
+		for (size_t offset = 0; offset < block.used;)
+		{
+			AllocHeader* header = reinterpret_cast<AllocHeader*>(block.memory + offset);
+			if (header->message)
+				header->message->~Message();
+			offset += header->size;
+		}
+		block.used = 0;
+	}
+	m_current = 0;
+
+	for (int i = 0; i < MAX_TYPES; ++i)
+	{
+		m_lastFrameCounts[i] = m_frameCounts[i];
+		m_frameCounts[i] = 0;
+	}
+	m_peakFrameTotal = m_frameTotal > m_peakFrameTotal ? m_frameTotal : m_peakFrameTotal;
+	m_frameTotal = 0;
+}
+
+void MessagePool::ResetStats()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	for (int i = 0; i < MAX_TYPES; ++i)
+	{
+		m_lastFrameCounts[i] = 0;
+		m_totalCounts[i] = 0;
+	}
+	m_peakFrameTotal = 0;
+}
+
+int MessagePool::GetLastFrameCount(Message::MESSAGE_TYPE type) const
+{
+	return m_lastFrameCounts[type];
+}
+
+long long MessagePool::GetTotalCount(Message::MESSAGE_TYPE type) const
+{
+	return m_totalCounts[type];
+}
+
+long long MessagePool::GetTotal() const
+{
+	long long total = 0;
+	for (int i = 0; i < MAX_TYPES; ++i)
+		total += m_totalCounts[i];
+	return total;
+}
+
+int MessagePool::GetPeakFrameCount() const
+{
+	return m_peakFrameTotal;
+}
+
+size_t MessagePool::GetBlockCount() const
+{
+	return m_blocks.size();
+}
@@ -0,0 +1,70 @@
+#ifndef MESSAGE_POOL_H
+#define MESSAGE_POOL_H
+
+#include <vector>
+#include <mutex>
+#include <new>
+#include <utility>
+#include "SingletonTemplate.h"
+#include "Message.h"
+
+//per-frame arena for messages: Create constructs a message in place in a fixed-size block,
+//and Reset (once a frame, after the scene's Update) destroys every message made since the last Reset
+//and rewinds the blocks. blocks are kept, so once the busiest frame has been seen messaging allocates nothing.
+//safe to Create from several threads at once (buffered AI), Reset only while nothing else is sending.
+//also counts the messages made per type: this frame, last frame, and since ResetStats
+class MessagePool : public Singleton<MessagePool>
+{
+	friend Singleton<MessagePool>;
+
+public:
+	static const int MAX_TYPES = Message::NUM_MESSAGE_TYPES;
+	static const size_t BLOCK_SIZE = 16 * 1024;
+
+	template <typename T, typename... Args>
+	T* Create(Args&&... args)
+	{
+		void* memory = Allocate(sizeof(T), T::TYPE);
+		T* message = new (memory) T(std::forward<Args>(args)...);
+		Header(memory)->message = message;
+		return message;
+	}
+
+	void Reset(); //end of frame: every message from Create is destroyed
+	void ResetStats();
+
+	int GetLastFrameCount(Message::MESSAGE_TYPE type) const;
+	long long GetTotalCount(Message::MESSAGE_TYPE type) const;
+	long long GetTotal() const;
+	int GetPeakFrameCount() const; //most messages made in one frame
+	size_t GetBlockCount() const;
+
+private:
+	MessagePool();
+	~MessagePool();
+
+	struct AllocHeader
+	{
+		Message* message; //null until constructed
+		size_t size; //header included
+	};
+	struct Block
+	{
+		char* memory;
+		size_t used;
+	};
+
+	static AllocHeader* Header(void* memory);
+	void* Allocate(size_t size, Message::MESSAGE_TYPE type);
+
+	std::mutex m_lock;
+	std::vector<Block> m_blocks;
+	size_t m_current; //block being filled
+	int m_frameCounts[MAX_TYPES];
+	int m_lastFrameCounts[MAX_TYPES];
+	long long m_totalCounts[MAX_TYPES];
+	int m_frameTotal;
+	int m_peakFrameTotal;
+};
+
+#endif
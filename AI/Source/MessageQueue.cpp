@@ -0,0 +1,77 @@
+#include "MessageQueue.h"
+#include "PostOffice.h"
+
+MessageQueue::MessageQueue()
+	: m_pending(0)
+{
+	ResetStats();
+}
+
+MessageQueue::~MessageQueue()
+{
+}
+
+void MessageQueue::Push(AddressHandle address, Message* message)
+{
+	std::vector<Entry>& queue = m_queues[message->GetType()];
+	unsigned long long key = message->GetCoalesceKey();
+	++m_stats.queued;
+	if (key)
+	{
+		for (size_t i = 0; i < queue.size(); ++i)
+		{
+			if (queue[i].key == key && queue[i].address == address)
+			{
+				++m_stats.coalesced;
+				return;
+			}
+		}
+	}
+	queue.push_back(Entry());
+	Entry& entry = queue.back();
+	entry.address = address;
+	entry.message = message;
+	entry.key = key;
+	++m_pending;
+}
+
+void MessageQueue::Deliver(PostOffice& postOffice)
+{
+	while (m_pending > 0)
+	{
+		for (int type = 0; type < Message::NUM_MESSAGE_TYPES; ++type)
+		{
+			if (m_queues[type].empty())
+				continue;
+			m_batch.swap(m_queues[type]);
+			m_pending -= static_cast<int>(m_batch.size());
+			++m_stats.batches;
+			for (size_t i = 0; i < m_batch.size(); ++i)
+				postOffice.Deliver(m_batch[i].address, m_batch[i].message);
+			m_stats.delivered += m_batch.size();
+			m_batch.clear();
+		}
+	}
+}
+
+void MessageQueue::Clear()
+{
+	for (int type = 0; type < Message::NUM_MESSAGE_TYPES; ++type)
+		m_queues[type].clear();
+	m_pending = 0;
+}
+
+int MessageQueue::GetPendingCount() const
+{
+	return m_pending;
+}
+
+const MessageQueue::Stats& MessageQueue::GetStats() const
+{
+	return m_stats;
+}
+
+void MessageQueue::ResetStats()
+{
+	m_stats.queued = m_stats.coalesced = m_stats.delivered = m_stats.batches = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+#include <vector>
+#include "Message.h"
+
+class PostOffice;
+
+//messages held back by PostOffice for delivery at a fixed point in the frame instead of inside Send.
+//one queue per message type: Deliver hands them over a type at a time, in MESSAGE_TYPE order and in the
+//order they were sent within a type, so a receiver handles all of one kind back to back.
+//a message with a coalesce key (Message::GetCoalesceKey) that matches one already waiting for the same
+//address is dropped, since delivering it again would do nothing the first one doesn't
+class MessageQueue
+{
+public:
+	struct Stats
+	{
+		long long queued;
+		long long coalesced; //dropped as duplicates
+		long long delivered;
+		long long batches; //non-empty per-type queues delivered
+	};
+
+	MessageQueue();
+	~MessageQueue();
+
+	void Push(AddressHandle address, Message* message);
+	void Deliver(PostOffice& postOffice); //until empty, including anything the handlers queue
+	void Clear(); //drop everything waiting (the messages themselves belong to MessagePool)
+	int GetPendingCount() const;
+	const Stats& GetStats() const;
+	void ResetStats();
+
+private:
+	struct Entry
+	{
+		AddressHandle address;
+		Message* message;
+		unsigned long long key;
+	};
+
+	std::vector<Entry> m_queues[Message::NUM_MESSAGE_TYPES];
+	std::vector<Entry> m_batch; //the queue being delivered, swapped out so handlers can queue more
+	int m_pending;
+	Stats m_stats;
+};
+
+#endif
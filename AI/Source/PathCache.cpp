@@ -0,0 +1,165 @@
+#include "PathCache.h"
+
+PathCache::PathCache()
+	: m_width(0), m_height(0), m_capacity(0), m_version(0), m_head(-1), m_tail(-1), m_count(0), m_cellCount(0), m_stats()
+{
+}
+
+PathCache::~PathCache()
+{
+}
+
+void PathCache::Init(int width, int height, int capacity)
+{
+	m_width = width;
+	m_height = height;
+	m_capacity = capacity > 0 ? capacity : 1;
+	Clear();
+}
+
+void PathCache::Clear()
+{
+	m_entries.clear();
+	m_free.clear();
+	m_index.clear();
+	m_head = m_tail = -1;
+	m_count = 0;
+	m_cellCount = 0;
+	m_stats = Stats();
+}
+
+void PathCache::SetObstacleVersion(unsigned version)
+{
+	if (version == m_version)
+		return;
+	m_version = version;
+	++m_stats.invalidations;
+}
+
+long long PathCache::GetKey(int cell, int goal) const
+{
+	return static_cast<long long>(cell) * (static_cast<long long>(m_width) * m_height) + goal;
+}
+
+bool PathCache::Find(MazePt start, MazePt goal, std::vector<MazePt>& path)
+{
+	++m_stats.lookups;
+	std::unordered_map<long long, Slot>::iterator it = m_index.find(GetKey(start.y * m_width + start.x, goal.y * m_width + goal.x));
+	if (it == m_index.end())
+		return false;
+	int entry = it->second.entry;
+	int offset = it->second.offset;
+	if (m_entries[entry].version != m_version)
+	{
+		Remove(entry);
+		return false;
+	}
+
+	const std::vector<int>& cells = m_entries[entry].cells;
+	path.clear();
+	path.reserve(cells.size() - offset - 1);
+	for (size_t i = offset + 1; i < cells.size(); ++i)
+		path.push_back(MazePt(cells[i] % m_width, cells[i] / m_width));
+	Touch(entry);
+	++m_stats.hits;
+	if (offset > 0) ++m_stats.suffixHits;
+	return true;
+}
+
+void PathCache::Insert(MazePt start, MazePt goal, const std::vector<MazePt>& path)
+{
+	if (m_width <= 0)
+		return;
+	int goalIndex = goal.y * m_width + goal.x;
+	if (m_count >= m_capacity)
+	{
+		Remove(m_tail);
+		++m_stats.evictions;
+	}
+
+	int entry;
+	if (!m_free.empty()) { entry = m_free.back(); m_free.pop_back(); }
+	else { entry = static_cast<int>(m_entries.size()); m_entries.push_back(Entry()); }
+	Entry& e = m_entries[entry];
+	e.version = m_version;
+	e.goal = goalIndex;
+	e.cells.clear();
+	e.cells.reserve(path.size() + 1);
+	e.cells.push_back(start.y * m_width + start.x);
+	for (size_t i = 0; i < path.size(); ++i)
+		e.cells.push_back(path[i].y * m_width + path[i].x);
+	//newer routes take over the cells they share with older ones
+	for (size_t i = 0; i < e.cells.size(); ++i)
+	{
+		Slot& slot = m_index[GetKey(e.cells[i], goalIndex)];
+		slot.entry = entry;
+		slot.offset = static_cast<int>(i);
+	}
+	e.prev = e.next = -1;
+	Touch(entry);
+	++m_count;
+	m_cellCount += static_cast<int>(e.cells.size());
+	++m_stats.inserts;
+}
+
+void PathCache::Unlink(int entry)
+{
+	Entry& e = m_entries[entry];
+	if (e.prev >= 0) m_entries[e.prev].next = e.next; else if (m_head == entry) m_head = e.next;
+	if (e.next >= 0) m_entries[e.next].prev = e.prev; else if (m_tail == entry) m_tail = e.prev;
+	e.prev = e.next = -1;
+}
+
+void PathCache::Touch(int entry)
+{
+	if (m_head == entry)
+		return;
+	Unlink(entry);
+	Entry& e = m_entries[entry];
+	e.next = m_head;
+	if (m_head >= 0) m_entries[m_head].prev = entry;
+	m_head = entry;
+	if (m_tail < 0) m_tail = entry;
+}
+
+void PathCache::Remove(int entry)
+{
+	Entry& e = m_entries[entry];
+	for (size_t i = 0; i < e.cells.size(); ++i)
+	{
+		std::unordered_map<long long, Slot>::iterator it = m_index.find(GetKey(e.cells[i], e.goal));
+		if (it != m_index.end() && it->second.entry == entry)
+			m_index.erase(it);
+	}
+	Unlink(entry);
+	m_cellCount -= static_cast<int>(e.cells.size());
+	--m_count;
+	e.cells.clear();
+	m_free.push_back(entry);
+}
+
+const PathCache::Stats& PathCache::GetStats() const
+{
+	return m_stats;
+}
+
+int PathCache::GetEntryCount() const
+{
+	return m_count;
+}
+
+int PathCache::GetCellCount() const
+{
+	return m_cellCount;
+}
+
+size_t PathCache::GetMemoryUsage() const
+{
+	//an unordered_map node is the value plus a next pointer and the cached hash, and each bucket is a pointer
+	size_t bytes = m_entries.capacity() * sizeof(Entry) + m_free.capacity() * sizeof(int);
+	for (size_t i = 0; i < m_entries.size(); ++i)
+		bytes += m_entries[i].cells.capacity() * sizeof(int);
+	bytes += m_index.size() * (sizeof(std::pair<const long long, Slot>) + 2 * sizeof(void*));
+	bytes += m_index.bucket_count() * sizeof(void*);
+	return bytes;
+}
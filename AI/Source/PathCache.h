@@ -0,0 +1,77 @@
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <vector>
+#include <unordered_map>
+#include "Maze.h"
+
+//LRU cache of grid paths keyed by (start cell, goal cell)
+//every cell along a stored path is indexed too: the rest of a shortest path is the shortest path from
+//there, so a unit part way along a cached route (a worker heading back to the same queen) reuses its tail.
+//entries are tagged with the obstacle version they were found under, so moving the version on retires
+//them all at once; stale entries are dropped when looked up or when the LRU reaches them
+class PathCache
+{
+public:
+	struct Stats
+	{
+		int lookups;
+		int hits;       //including suffix hits
+		int suffixHits; //answered from the middle of another route
+		int inserts;
+		int evictions;  //to make room, stale or not
+		int invalidations; //version changes
+	};
+
+	PathCache();
+	~PathCache();
+
+	void Init(int width, int height, int capacity = 512); //capacity in paths
+	void Clear(); //entries and stats
+
+	void SetObstacleVersion(unsigned version); //the owner's count of wall/food grid changes
+
+	//path as GridPathfinder::FindPath would return it (including "no path"), false if not cached
+	bool Find(MazePt start, MazePt goal, std::vector<MazePt>& path);
+	void Insert(MazePt start, MazePt goal, const std::vector<MazePt>& path);
+
+	const Stats& GetStats() const;
+	int GetEntryCount() const;
+	int GetCellCount() const;    //cells stored over all entries
+	size_t GetMemoryUsage() const; //bytes, roughly (entries, cells and index nodes)
+
+private:
+	struct Entry
+	{
+		unsigned version;
+		int goal;
+		std::vector<int> cells; //start first, then the path
+		int prev; //LRU links, towards the most recently used
+		int next;
+	};
+	struct Slot
+	{
+		int entry;
+		int offset; //into cells
+	};
+
+	long long GetKey(int cell, int goal) const;
+	void Touch(int entry);
+	void Unlink(int entry);
+	void Remove(int entry);
+
+	int m_width;
+	int m_height;
+	int m_capacity;
+	unsigned m_version;
+	std::vector<Entry> m_entries;
+	std::vector<int> m_free;
+	int m_head; //most recently used, -1 if empty
+	int m_tail; //evicted first
+	int m_count;
+	int m_cellCount;
+	std::unordered_map<long long, Slot> m_index; //(cell, goal) -> where the cell sits on a cached route
+	Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "PathRequestQueue.h"
+#include <algorithm>
+#include "MyMath.h"
+
+PathRequestQueue::PathRequestQueue()
+	: m_width(0), m_height(0), m_clusters(nullptr), m_budget(0.f), m_cache(nullptr), m_order(0), m_frame(0), m_stats()
+{
+}
+
+PathRequestQueue::~PathRequestQueue()
+{
+}
+
+void PathRequestQueue::Init(const BitGrid* blocked, GridPathfinder::ALGORITHM algorithm, int lanes)
+{
+	m_width = blocked->GetWidth();
+	m_height = blocked->GetHeight();
+	m_lanes.clear();
+	m_lanes.resize(Math::Max(1, lanes));
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		m_lanes[i].flat.Init(blocked);
+		m_lanes[i].flat.SetAlgorithm(algorithm);
+	}
+	Clear();
+}
+
+void PathRequestQueue::Clear()
+{
+	m_requests.clear();
+	m_byKey.clear();
+	m_ownerKey.clear();
+	m_order = 0;
+	m_frame = 0;
+	m_stats = Stats();
+}
+
+void PathRequestQueue::SetBudget(float milliseconds)
+{
+	m_budget = milliseconds;
+}
+
+void PathRequestQueue::SetCache(PathCache* cache)
+{
+	m_cache = cache;
+}
+
+void PathRequestQueue::SetClusterGraph(const ClusterGraph* graph)
+{
+	m_clusters = graph;
+	if (graph)
+	{
+		for (size_t i = 0; i < m_lanes.size(); ++i)
+			m_lanes[i].hierarchical.Init(graph);
+	}
+}
+
+long long PathRequestQueue::GetKey(MazePt start, MazePt goal) const
+{
+	long long cells = static_cast<long long>(m_width) * m_height;
+	return (static_cast<long long>(start.y) * m_width + start.x) * cells + (static_cast<long long>(goal.y) * m_width + goal.x);
+}
+
+bool PathRequestQueue::IsWanted(const Request& request) const
+{
+	for (size_t i = 0; i < request.owners.size(); ++i)
+	{
+		std::unordered_map<GOHandle, long long>::const_iterator it = m_ownerKey.find(request.owners[i]);
+		if (it != m_ownerKey.end() && it->second == request.key)
+			return true;
+	}
+	return false;
+}
+
+bool PathRequestQueue::Submit(GOHandle owner, MazePt start, MazePt goal, int priority)
+{
+	long long key = GetKey(start, goal);
+	std::unordered_map<GOHandle, long long>::iterator owned = m_ownerKey.find(owner);
+	if (owned != m_ownerKey.end() && owned->second == key)
+		return false; //asked already, still waiting
+	m_ownerKey[owner] = key; //an older request of owner's is left to be dropped or answered for others
+
+	std::unordered_map<long long, int>::iterator queued = m_byKey.find(key);
+	if (queued != m_byKey.end())
+	{
+		Request& request = m_requests[queued->second];
+		request.owners.push_back(owner);
+		request.priority = Math::Max(request.priority, priority);
+		++m_stats.merged;
+		return false;
+	}
+
+	m_byKey[key] = static_cast<int>(m_requests.size());
+	m_requests.push_back(Request());
+	Request& request = m_requests.back();
+	request.key = key;
+	request.start = start;
+	request.goal = goal;
+	request.priority = priority;
+	request.order = m_order++;
+	request.frame = m_frame;
+	request.submitTime = Clock::now();
+	request.owners.push_back(owner);
+	request.done = false;
+	++m_stats.submitted;
+	m_stats.peakDepth = Math::Max(m_stats.peakDepth, static_cast<int>(m_requests.size()));
+	return true;
+}
+
+bool PathRequestQueue::IsPending(GOHandle owner) const
+{
+	return m_ownerKey.find(owner) != m_ownerKey.end();
+}
+
+void PathRequestQueue::Cancel(GOHandle owner)
+{
+	m_ownerKey.erase(owner);
+}
+
+void PathRequestQueue::Process(JobSystem& jobs, std::vector<Result>& results)
+{
+	++m_frame;
+	if (m_requests.empty())
+		return;
+
+	//nobody waits for these any more (every owner died, was cancelled or asked for something else)
+	size_t kept = 0;
+	for (size_t i = 0; i < m_requests.size(); ++i)
+	{
+		if (!IsWanted(m_requests[i])) { ++m_stats.dropped; continue; }
+		if (kept != i) m_requests[kept] = std::move(m_requests[i]);
+		++kept;
+	}
+	m_requests.resize(kept);
+	std::sort(m_requests.begin(), m_requests.end(), [](const Request& lhs, const Request& rhs) {
+		return lhs.priority > rhs.priority || (lhs.priority == rhs.priority && lhs.order < rhs.order);
+	});
+
+	//lane k takes requests k, k + lanes, ... so every lane starts on the most urgent work left.
+	//the budget is checked between searches, and each lane always finishes at least one
+	int count = static_cast<int>(m_requests.size());
+	int lanes = Math::Min(Math::Min(static_cast<int>(m_lanes.size()), jobs.GetThreadCount()), count);
+	Clock::time_point deadline = Clock::now() + std::chrono::microseconds(static_cast<long long>(m_budget * 1000.f));
+	bool budgeted = m_budget > 0.f;
+	jobs.ParallelFor(lanes, 1, [this, lanes, count, deadline, budgeted](int begin, int end) {
+		for (int lane = begin; lane < end; ++lane) {
+			for (int i = lane; i < count; i += lanes) {
+				if (budgeted && i >= lanes && Clock::now() > deadline) break;
+				Request& request = m_requests[i];
+				request.path = m_clusters ? m_lanes[lane].hierarchical.FindPath(request.start, request.goal) : m_lanes[lane].flat.FindPath(request.start, request.goal);
+				request.done = true;
+			}
+		}
+	});
+
+	Clock::time_point now = Clock::now();
+	kept = 0;
+	for (size_t i = 0; i < m_requests.size(); ++i)
+	{
+		Request& request = m_requests[i];
+		if (!request.done)
+		{
+			if (kept != i) m_requests[kept] = std::move(request);
+			++kept;
+			continue;
+		}
+
+		for (size_t o = 0; o < request.owners.size(); ++o)
+		{
+			std::unordered_map<GOHandle, long long>::iterator owned = m_ownerKey.find(request.owners[o]);
+			if (owned == m_ownerKey.end() || owned->second != request.key)
+				continue;
+			m_ownerKey.erase(owned);
+			results.push_back(Result());
+			Result& result = results.back();
+			result.owner = request.owners[o];
+			result.start = request.start;
+			result.goal = request.goal;
+			result.path = request.path;
+		}
+
+		if (m_cache) m_cache->Insert(request.start, request.goal, request.path);
+		int frames = m_frame - request.frame;
+		double ms = std::chrono::duration<double, std::milli>(now - request.submitTime).count();
+		++m_stats.completed;
+		m_stats.latencyFramesTotal += frames;
+		m_stats.latencyFramesMax = Math::Max(m_stats.latencyFramesMax, frames);
+		m_stats.latencyMsTotal += ms;
+		m_stats.latencyMsMax = Math::Max(m_stats.latencyMsMax, ms);
+	}
+	m_requests.resize(kept);
+
+	m_byKey.clear();
+	for (size_t i = 0; i < m_requests.size(); ++i)
+		m_byKey[m_requests[i].key] = static_cast<int>(i);
+}
+
+int PathRequestQueue::GetDepth() const
+{
+	return static_cast<int>(m_requests.size());
+}
+
+const PathRequestQueue::Stats& PathRequestQueue::GetStats() const
+{
+	return m_stats;
+}
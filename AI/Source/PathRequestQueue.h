@@ -0,0 +1,102 @@
+#ifndef PATH_REQUEST_QUEUE_H
+#define PATH_REQUEST_QUEUE_H
+
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include "Maze.h"
+#include "GridPathfinder.h"
+#include "HierarchicalPathfinder.h"
+#include "PathCache.h"
+#include "GameObjectHandle.h"
+#include "JobSystem.h"
+
+//deferred path searches, answered in batches once per frame
+//units Submit (start, goal, priority) and carry on along their old path (or wait) until Process hands
+//the result back. identical requests share one search, and a unit that asks again before being answered
+//replaces its earlier request. Process searches the highest priority requests first, one GridPathfinder
+//per job thread, until the frame's time budget is used up; whatever is left waits for the next frame.
+//the obstacle grid must not change while Process runs
+class PathRequestQueue
+{
+public:
+	struct Result
+	{
+		GOHandle owner;
+		MazePt start;
+		MazePt goal;
+		std::vector<MazePt> path; //as GridPathfinder::FindPath, empty if the goal can't be reached
+	};
+	struct Stats
+	{
+		int submitted;   //requests that needed a search of their own
+		int merged;      //requests folded into one already queued
+		int completed;   //searches run
+		int dropped;     //queued searches nobody was waiting for any more
+		int peakDepth;   //most searches queued at once
+		int latencyFramesMax;
+		double latencyFramesTotal; //over completed, for the average
+		double latencyMsMax;
+		double latencyMsTotal;
+	};
+
+	PathRequestQueue();
+	~PathRequestQueue();
+
+	//lanes = pathfinders, at most one per job thread is used. the grid is read as in GridPathfinder::Init
+	void Init(const BitGrid* blocked, GridPathfinder::ALGORITHM algorithm, int lanes);
+	void Clear(); //forget queued requests and stats
+	void SetBudget(float milliseconds); //per Process, 0 = answer everything queued
+	void SetCache(PathCache* cache); //searched paths are stored here, nullptr for none
+	void SetClusterGraph(const ClusterGraph* graph); //search with HPA* over graph instead, nullptr to go back
+
+	//true if it queued a new search, false if it joined one (including owner's own, unchanged request)
+	bool Submit(GOHandle owner, MazePt start, MazePt goal, int priority = 0);
+	bool IsPending(GOHandle owner) const;
+	void Cancel(GOHandle owner);
+
+	//run queued searches on jobs and append the answers, highest priority first, to results
+	void Process(JobSystem& jobs, std::vector<Result>& results);
+
+	int GetDepth() const; //searches queued
+	const Stats& GetStats() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	struct Lane
+	{
+		GridPathfinder flat;
+		HierarchicalPathfinder hierarchical;
+	};
+	struct Request
+	{
+		long long key;
+		MazePt start;
+		MazePt goal;
+		int priority;
+		unsigned order; //submission order, breaks priority ties
+		int frame;
+		Clock::time_point submitTime;
+		std::vector<GOHandle> owners; //an owner that has since asked for something else is skipped
+		std::vector<MazePt> path;
+		bool done;
+	};
+
+	long long GetKey(MazePt start, MazePt goal) const;
+	bool IsWanted(const Request& request) const;
+
+	int m_width;
+	int m_height;
+	std::vector<Lane> m_lanes;
+	const ClusterGraph* m_clusters;
+	float m_budget;
+	PathCache* m_cache;
+	std::vector<Request> m_requests;
+	std::unordered_map<long long, int> m_byKey;        //key -> index in m_requests
+	std::unordered_map<GOHandle, long long> m_ownerKey; //what each waiting owner last asked for
+	unsigned m_order;
+	int m_frame;
+	Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "PheromoneField.h"
+#include <cmath>
+
+const float PheromoneField::HALF_LIFE = 60.f;
+const float PheromoneField::CUTOFF = 0.05f; //a fresh trail lasts about 4.3 half-lives
+
+PheromoneField::PheromoneField()
+	: m_noGrid(0), m_gridSize(1.f), m_trailCount(0)
+{
+}
+
+PheromoneField::~PheromoneField()
+{
+}
+
+void PheromoneField::Init(int noGrid, float gridSize)
+{
+	m_noGrid = noGrid;
+	m_gridSize = gridSize;
+	Clear();
+}
+
+void PheromoneField::Clear()
+{
+	m_strength.assign(m_noGrid * m_noGrid, 0.f);
+	m_foodId.assign(m_noGrid * m_noGrid, -1);
+	m_trailCells.clear();
+	m_trailCount = 0;
+}
+
+void PheromoneField::Deposit(int gridX, int gridY, int foodId, float strength)
+{
+	if (gridX < 0 || gridX >= m_noGrid || gridY < 0 || gridY >= m_noGrid || foodId < 0)
+		return;
+	int index = gridY * m_noGrid + gridX;
+	if (m_strength[index] <= 0.f)
+	{
+		m_foodId[index] = foodId;
+		m_trailCells.push_back(index);
+		++m_trailCount;
+	}
+	if (strength > m_strength[index])
+		m_strength[index] = strength;
+}
+
+bool PheromoneField::HasTrail(int gridX, int gridY) const
+{
+	return GetStrength(gridX, gridY) > 0.f;
+}
+
+float PheromoneField::GetStrength(int gridX, int gridY) const
+{
+	if (gridX < 0 || gridX >= m_noGrid || gridY < 0 || gridY >= m_noGrid)
+		return 0.f;
+	return m_strength[gridY * m_noGrid + gridX];
+}
+
+int PheromoneField::GetFoodId(int gridX, int gridY) const
+{
+	if (gridX < 0 || gridX >= m_noGrid || gridY < 0 || gridY >= m_noGrid)
+		return -1;
+	return m_foodId[gridY * m_noGrid + gridX];
+}
+
+void PheromoneField::ClearFood(int foodId)
+{
+	size_t alive = 0;
+	for (size_t i = 0; i < m_trailCells.size(); ++i)
+	{
+		int index = m_trailCells[i];
+		if (m_foodId[index] == foodId)
+		{
+			m_strength[index] = 0.f;
+			m_foodId[index] = -1;
+		}
+		else
+			m_trailCells[alive++] = index;
+	}
+	m_trailCells.resize(alive);
+	m_trailCount = static_cast<int>(alive);
+}
+
+void PheromoneField::Evaporate(float dt)
+{
+	if (m_trailCount == 0 || dt <= 0.f)
+		return;
+	const float decay = std::pow(0.5f, dt / HALF_LIFE);
+	float* strength = m_strength.data();
+	int* foodId = m_foodId.data();
+
+	//the trail list is compacted in place as cells fade out
+	size_t alive = 0;
+	for (size_t i = 0; i < m_trailCells.size(); ++i)
+	{
+		int index = m_trailCells[i];
+		strength[index] *= decay;
+		if (strength[index] >= CUTOFF)
+			m_trailCells[alive++] = index;
+		else
+		{
+			strength[index] = 0.f;
+			foodId[index] = -1;
+		}
+	}
+	m_trailCells.resize(alive);
+	m_trailCount = static_cast<int>(alive);
+}
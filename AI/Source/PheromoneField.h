@@ -0,0 +1,80 @@
+#ifndef PHEROMONE_FIELD_H
+#define PHEROMONE_FIELD_H
+
+#include <vector>
+#include "Vector3.h"
+
+//one team's pheromone trails, one cell per grid square
+//each cell holds a strength (0 = no trail) and the id of the food source the trail leads to.
+//deposits and lookups are array reads, and evaporation only visits the cells that hold a trail,
+//so it costs the same on a 4096x4096 map as on the 30x30 one
+class PheromoneField
+{
+public:
+	PheromoneField();
+	~PheromoneField();
+
+	void Init(int noGrid, float gridSize);
+	void Clear();
+
+	//lay or refresh a trail cell; an existing trail keeps the food it already leads to
+	void Deposit(int gridX, int gridY, int foodId, float strength = 1.f);
+	bool HasTrail(int gridX, int gridY) const;
+	float GetStrength(int gridX, int gridY) const;
+	int GetFoodId(int gridX, int gridY) const; //-1 if no trail
+
+	void ClearFood(int foodId); //the source is gone, erase every trail leading to it
+	void Evaporate(float dt);   //exponential decay, cells fading below the cutoff are erased
+
+	//food id of the nearest trail cell (by cell centre) strictly closer than maxRange whose food passes accept(foodId)
+	//-1 if none
+	template<typename Predicate>
+	int FindNearest(const Vector3& pos, float maxRange, Predicate accept) const;
+
+	const std::vector<float>& GetStrengths() const { return m_strength; } //row-major, for rendering
+
+	static const float HALF_LIFE; //seconds
+	static const float CUTOFF;
+
+private:
+	int m_noGrid;
+	float m_gridSize;
+	int m_trailCount;
+	std::vector<float> m_strength;
+	std::vector<int> m_foodId;
+	std::vector<int> m_trailCells; //indices of the cells with a trail, in no particular order
+};
+
+template<typename Predicate>
+int PheromoneField::FindNearest(const Vector3& pos, float maxRange, Predicate accept) const
+{
+	if (m_trailCount == 0)
+		return -1;
+	int reach = static_cast<int>(maxRange / m_gridSize) + 1;
+	int cx = static_cast<int>(pos.x / m_gridSize);
+	int cy = static_cast<int>(pos.y / m_gridSize);
+	int minX = cx - reach < 0 ? 0 : cx - reach; int maxX = cx + reach >= m_noGrid ? m_noGrid - 1 : cx + reach;
+	int minY = cy - reach < 0 ? 0 : cy - reach; int maxY = cy + reach >= m_noGrid ? m_noGrid - 1 : cy + reach;
+
+	int nearest = -1;
+	float nearestDistSq = maxRange * maxRange;
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			int index = y * m_noGrid + x;
+			if (m_strength[index] <= 0.f)
+				continue;
+			Vector3 centre((x + 0.5f) * m_gridSize, (y + 0.5f) * m_gridSize, pos.z);
+			float distSq = (pos - centre).LengthSquared();
+			if (distSq < nearestDistSq && accept(m_foodId[index]))
+			{
+				nearestDistSq = distSq;
+				nearest = m_foodId[index];
+			}
+		}
+	}
+	return nearest;
+}
+
+#endif
@@ -1,30 +1,158 @@
 #include "PostOffice.h"
+#include "CommandBuffer.h"
+#include <algorithm>
+
+AddressHandle PostOffice::GetAddress(const std::string & address)
+{
+	std::map<std::string, AddressHandle>::iterator it = m_addressBook.find(address);
+	if (it != m_addressBook.end())
+		return it->second;
+	AddressHandle handle = static_cast<AddressHandle>(m_addressNames.size());
+	m_addressBook.insert(std::pair<std::string, AddressHandle>(address, handle));
+	m_addressNames.push_back(address);
+	m_receivers.push_back(std::vector<ObjectBase*>());
+	return handle;
+}
+
+const std::string& PostOffice::GetAddressName(AddressHandle address) const
+{
+	return m_addressNames[address];
+}
 
 void PostOffice::Register(const std::string & address, ObjectBase * object)
 {
 	if (!object)
 		return;
-	if (m_addressBook.find(address) != m_addressBook.end())
+	std::vector<ObjectBase*>& receivers = m_receivers[GetAddress(address)];
+	if (!receivers.empty())
 		return;
-	m_addressBook.insert(std::pair<std::string, ObjectBase*>(address, object));
+	receivers.push_back(object);
+}
+
+void PostOffice::Unregister(const std::string & address)
+{
+	std::map<std::string, AddressHandle>::iterator it = m_addressBook.find(address);
+	if (it != m_addressBook.end())
+		Unregister(it->second);
+}
+
+void PostOffice::Unregister(AddressHandle address)
+{
+	m_receivers[address].clear();
+}
+
+void PostOffice::Subscribe(AddressHandle address, ObjectBase * object)
+{
+	if (!object)
+		return;
+	std::vector<ObjectBase*>& receivers = m_receivers[address];
+	if (std::find(receivers.begin(), receivers.end(), object) == receivers.end())
+		receivers.push_back(object);
+}
+
+void PostOffice::Unsubscribe(AddressHandle address, ObjectBase * object)
+{
+	std::vector<ObjectBase*>& receivers = m_receivers[address];
+	std::vector<ObjectBase*>::iterator it = std::find(receivers.begin(), receivers.end(), object);
+	if (it != receivers.end())
+		receivers.erase(it); //keeps the others in order, so delivery order doesn't depend on who left
+}
+
+int PostOffice::GetReceiverCount(AddressHandle address) const
+{
+	return static_cast<int>(m_receivers[address].size());
 }
 
 bool PostOffice::Send(const std::string & address, Message * message)
+{
+	return Send(GetAddress(address), message);
+}
+
+bool PostOffice::Send(AddressHandle address, Message * message)
 {
 	if (!message)
 		return false;
-	std::map<std::string, ObjectBase*>::iterator it = m_addressBook.find(address);
-	if (m_addressBook.find(address) == m_addressBook.end())
+	//queued for later while the calling thread is running deferred AI updates
+	if (CommandBuffer::GetBound())
 	{
-		delete message;
-		return false;
+		CommandBuffer::QueueMessage(address, message);
+		return true;
+	}
+	if (m_deferred[message->GetType()])
+	{
+		m_deferredQueue.Push(address, message);
+		return true;
 	}
-	ObjectBase *object = (ObjectBase*)it->second;
-	return object->Handle(message);
+	return Deliver(address, message);
+}
+
+bool PostOffice::Deliver(AddressHandle address, Message * message)
+{
+	std::vector<ObjectBase*>& receivers = m_receivers[address];
+	if (receivers.size() == 1)
+		return receivers[0]->Handle(message);
+	//by index: a receiver may subscribe someone else while handling
+	bool handled = false;
+	for (size_t i = 0; i < receivers.size(); ++i)
+		handled = receivers[i]->Handle(message) || handled;
+	return handled;
+}
+
+bool PostOffice::SendRadius(const RadiusAddress & area, Message * message)
+{
+	if (!message || !m_locator)
+		return false;
+	size_t first = m_areaReceivers.size();
+	m_locator->FindReceivers(area, m_areaReceivers);
+	bool handled = false;
+	for (size_t i = first; i < m_areaReceivers.size(); ++i)
+		handled = m_areaReceivers[i]->Handle(message) || handled;
+	m_areaReceivers.resize(first);
+	return handled;
+}
+
+void PostOffice::SetLocator(ReceiverLocator * locator)
+{
+	m_locator = locator;
+}
+
+ReceiverLocator* PostOffice::GetLocator() const
+{
+	return m_locator;
+}
+
+void PostOffice::SetDeferred(Message::MESSAGE_TYPE type, bool deferred)
+{
+	m_deferred[type] = deferred;
+}
+
+bool PostOffice::IsDeferred(Message::MESSAGE_TYPE type) const
+{
+	return m_deferred[type];
+}
+
+void PostOffice::DeliverDeferred()
+{
+	m_deferredQueue.Deliver(*this);
+}
+
+void PostOffice::ClearDeferred()
+{
+	for (int i = 0; i < Message::NUM_MESSAGE_TYPES; ++i)
+		m_deferred[i] = false;
+	m_deferredQueue.Clear();
+}
+
+const MessageQueue& PostOffice::GetDeferredQueue() const
+{
+	return m_deferredQueue;
 }
 
 PostOffice::PostOffice()
+	: m_locator(nullptr)
 {
+	for (int i = 0; i < Message::NUM_MESSAGE_TYPES; ++i)
+		m_deferred[i] = false;
 }
 
 PostOffice::~PostOffice()
@@ -5,22 +5,77 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include "ObjectBase.h"
 #include "Message.h"
+#include "MessageQueue.h"
+#include "Vector3.h"
 
+//an area used as an address: whoever of a team and kind is within radius of centre
+struct RadiusAddress
+{
+	Vector3 centre;
+	float radius;
+	int teamID; //-1 for any team
+	unsigned typeMask; //one bit per receiver type (the locator says what a type is), 0 for any
+};
+
+//finds the receivers of radius-addressed messages for PostOffice, see SetLocator.
+//the scene is expected to answer from its spatial grid, so the cost follows the crowd near centre
+class ReceiverLocator
+{
+public:
+	virtual ~ReceiverLocator() {}
+	virtual void FindReceivers(const RadiusAddress& area, std::vector<ObjectBase*>& receivers) = 0; //appends
+};
+
+//routes messages to receivers by address. an address name is interned once by GetAddress and
+//used as an AddressHandle from then on, so sending is a vector index rather than a map lookup.
+//an address has any number of receivers: Register gives it its one owner (the "Scene"),
+//Subscribe adds listeners to a channel such as a team's alerts, and a message sent to it reaches all of them
 class PostOffice : public Singleton<PostOffice>
 {
 	friend Singleton<PostOffice>;
 
 public:
-	void Register(const std::string &address, ObjectBase *object);
+	AddressHandle GetAddress(const std::string &address); //the same handle for the same name, for as long as the program runs
+	const std::string& GetAddressName(AddressHandle address) const;
+
+	void Register(const std::string &address, ObjectBase *object); //ignored if the address already has a receiver
+	void Unregister(const std::string &address); //every receiver of the address
+	void Unregister(AddressHandle address);
+	void Subscribe(AddressHandle address, ObjectBase *object);
+	void Unsubscribe(AddressHandle address, ObjectBase *object);
+	int GetReceiverCount(AddressHandle address) const;
+
+	//true if a receiver handled it
 	bool Send(const std::string &address, Message *message);
-	//void BroadCast(Message *message);
+	bool Send(AddressHandle address, Message *message);
+	bool Deliver(AddressHandle address, Message *message); //straight to the receivers, deferred or not
+
+	//to every receiver the locator finds in the area, always at once (never buffered or deferred),
+	//so only from the main thread. false if nobody handled it or there is no locator
+	bool SendRadius(const RadiusAddress &area, Message *message);
+	void SetLocator(ReceiverLocator *locator);
+	ReceiverLocator* GetLocator() const;
+
+	//messages of a deferred type are queued by Send (true is returned) and reach their receivers in DeliverDeferred
+	void SetDeferred(Message::MESSAGE_TYPE type, bool deferred);
+	bool IsDeferred(Message::MESSAGE_TYPE type) const;
+	void DeliverDeferred();
+	void ClearDeferred(); //nothing deferred any more and the queue dropped
+	const MessageQueue& GetDeferredQueue() const;
 
 private:
 	PostOffice();
 	~PostOffice();
-	std::map<std::string, ObjectBase*> m_addressBook;
+	std::map<std::string, AddressHandle> m_addressBook; //only consulted to turn names into handles
+	std::vector<std::string> m_addressNames;
+	std::vector<std::vector<ObjectBase*> > m_receivers; //per handle, in the order they subscribed
+	bool m_deferred[Message::NUM_MESSAGE_TYPES];
+	MessageQueue m_deferredQueue;
+	ReceiverLocator* m_locator;
+	std::vector<ObjectBase*> m_areaReceivers; //scratch for SendRadius, a stack so handlers can send again
 };
 
 #endif
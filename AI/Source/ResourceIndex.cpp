@@ -0,0 +1,108 @@
+#include "ResourceIndex.h"
+#include <algorithm>
+
+ResourceIndex::ResourceIndex()
+	: m_bucketsPerSide(0), m_bucketSize(1.f), m_units(nullptr)
+{
+}
+
+ResourceIndex::~ResourceIndex()
+{
+}
+
+void ResourceIndex::Init(int noGrid, float gridSize, const UnitStore* units, int bucketCells)
+{
+	m_units = units;
+	m_bucketsPerSide = Math::Max(1, (noGrid + bucketCells - 1) / bucketCells);
+	m_bucketSize = gridSize * bucketCells;
+	Clear();
+}
+
+void ResourceIndex::Clear()
+{
+	m_buckets.assign(m_bucketsPerSide * m_bucketsPerSide, std::vector<GameObject*>());
+	m_bucketOf.clear();
+}
+
+int ResourceIndex::GetBucketIndex(const Vector3& pos) const
+{
+	int bx = Math::Clamp(static_cast<int>(pos.x / m_bucketSize), 0, m_bucketsPerSide - 1);
+	int by = Math::Clamp(static_cast<int>(pos.y / m_bucketSize), 0, m_bucketsPerSide - 1);
+	return by * m_bucketsPerSide + bx;
+}
+
+void ResourceIndex::RemoveFromBucket(int bucket, GameObject* go)
+{
+	std::vector<GameObject*>& list = m_buckets[bucket];
+	for (size_t i = 0; i < list.size(); ++i)
+	{
+		if (list[i] == go)
+		{
+			list[i] = list.back();
+			list.pop_back();
+			return;
+		}
+	}
+}
+
+void ResourceIndex::Insert(GameObject* go)
+{
+	if (!go || m_buckets.empty())
+		return;
+	int bucket = GetBucketIndex(m_units->GetPos(go));
+	std::unordered_map<const GameObject*, int>::iterator it = m_bucketOf.find(go);
+	if (it != m_bucketOf.end())
+	{
+		if (it->second == bucket)
+			return;
+		RemoveFromBucket(it->second, go);
+		it->second = bucket;
+	}
+	else
+	{
+		m_bucketOf.insert(std::pair<const GameObject*, int>(go, bucket));
+	}
+	m_buckets[bucket].push_back(go);
+}
+
+void ResourceIndex::Remove(GameObject* go)
+{
+	std::unordered_map<const GameObject*, int>::iterator it = m_bucketOf.find(go);
+	if (it == m_bucketOf.end())
+		return;
+	RemoveFromBucket(it->second, go);
+	m_bucketOf.erase(it);
+}
+
+void ResourceIndex::Prune()
+{
+	//only the buckets holding something switched off, big maps have far more buckets than objects
+	m_pruneBuckets.clear();
+	for (std::unordered_map<const GameObject*, int>::const_iterator it = m_bucketOf.begin(); it != m_bucketOf.end(); ++it)
+	{
+		if (!it->first->active)
+			m_pruneBuckets.push_back(it->second);
+	}
+	std::sort(m_pruneBuckets.begin(), m_pruneBuckets.end());
+	m_pruneBuckets.erase(std::unique(m_pruneBuckets.begin(), m_pruneBuckets.end()), m_pruneBuckets.end());
+	for (size_t b = 0; b < m_pruneBuckets.size(); ++b)
+	{
+		std::vector<GameObject*>& bucket = m_buckets[m_pruneBuckets[b]];
+		for (size_t i = 0; i < bucket.size();)
+		{
+			if (bucket[i]->active)
+			{
+				++i;
+				continue;
+			}
+			m_bucketOf.erase(bucket[i]);
+			bucket[i] = bucket.back();
+			bucket.pop_back();
+		}
+	}
+}
+
+int ResourceIndex::GetCount() const
+{
+	return static_cast<int>(m_bucketOf.size());
+}
@@ -0,0 +1,95 @@
+#ifndef RESOURCE_INDEX_H
+#define RESOURCE_INDEX_H
+
+#include <vector>
+#include <unordered_map>
+#include <cfloat>
+#include "Vector3.h"
+#include "GameObject.h"
+#include "UnitStore.h"
+
+//sparse bucket index for objects that rarely move (food sources)
+//the map is split into square buckets of bucketCells x bucketCells grid cells.
+//objects are added/removed as they spawn and deplete, and nearest-neighbour
+//queries search outward ring by ring, stopping once no closer bucket can exist.
+//positions are read from the scene's UnitStore
+class ResourceIndex
+{
+public:
+	ResourceIndex();
+	~ResourceIndex();
+
+	void Init(int noGrid, float gridSize, const UnitStore* units, int bucketCells = 4);
+	void Clear();
+
+	void Insert(GameObject* go); //re-buckets the object if it is already indexed
+	void Remove(GameObject* go);
+	int GetCount() const;
+
+	void Prune(); //drop objects that were switched off without Remove
+
+	//nearest active indexed object strictly closer than maxRange that passes accept(go)
+	//read-only, so any number of threads may query at once
+	template<typename Predicate>
+	GameObject* FindNearest(const Vector3& pos, float maxRange, Predicate accept) const;
+
+private:
+	int GetBucketIndex(const Vector3& pos) const;
+	void RemoveFromBucket(int bucket, GameObject* go);
+
+	int m_bucketsPerSide;
+	float m_bucketSize; //world units
+	const UnitStore* m_units;
+	std::vector<std::vector<GameObject*>> m_buckets;
+	std::unordered_map<const GameObject*, int> m_bucketOf;
+	std::vector<int> m_pruneBuckets; //scratch for Prune
+};
+
+template<typename Predicate>
+GameObject* ResourceIndex::FindNearest(const Vector3& pos, float maxRange, Predicate accept) const
+{
+	GameObject* nearest = nullptr;
+	if (m_bucketOf.empty())
+		return nearest;
+	float nearestDistSq = (maxRange < FLT_MAX) ? maxRange * maxRange : FLT_MAX;
+
+	int centre = GetBucketIndex(pos);
+	int cx = centre % m_bucketsPerSide;
+	int cy = centre / m_bucketsPerSide;
+	for (int ring = 0; ring < m_bucketsPerSide; ++ring)
+	{
+		//every bucket on this ring is at least (ring - 1) whole buckets away
+		float ringDist = (ring - 1) * m_bucketSize;
+		if (ring > 1 && ringDist * ringDist >= nearestDistSq)
+			break;
+
+		for (int by = cy - ring; by <= cy + ring; ++by)
+		{
+			if (by < 0 || by >= m_bucketsPerSide)
+				continue;
+			//interior rows only contribute their two end buckets
+			int step = (by == cy - ring || by == cy + ring || ring == 0) ? 1 : ring * 2;
+			for (int bx = cx - ring; bx <= cx + ring; bx += step)
+			{
+				if (bx < 0 || bx >= m_bucketsPerSide)
+					continue;
+				const std::vector<GameObject*>& bucket = m_buckets[by * m_bucketsPerSide + bx];
+				for (size_t i = 0; i < bucket.size(); ++i)
+				{
+					GameObject* go = bucket[i];
+					if (!go->active)
+						continue;
+					float distSq = (pos - m_units->GetPos(go)).LengthSquared();
+					if (distSq < nearestDistSq && accept(go))
+					{
+						nearestDistSq = distSq;
+						nearest = go;
+					}
+				}
+			}
+		}
+	}
+	return nearest;
+}
+
+#endif
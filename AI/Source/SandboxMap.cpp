@@ -0,0 +1,184 @@
+#include "SandboxMap.h"
+#include "GL\glew.h"
+#include "LoadTGA.h"
+#include "MyMath.h"
+#include <iostream>
+
+SandboxMap::SandboxMap()
+	: m_size(0)
+{
+}
+
+SandboxMap::~SandboxMap()
+{
+}
+
+void SandboxMap::CreateDefault(int size)
+{
+	m_size = Math::Max(MIN_SIZE, Math::Min(size, MAX_SIZE));
+	m_walls.Init(m_size, m_size, true);
+	m_foodSpawns.clear();
+
+	//an 8x8 pen in the bottom-left (red) and top-right (blue) corner, each wall with a two cell gap
+	const int pen = 8;
+	int far = m_size - pen;
+	for (int i = 0; i < pen; ++i)
+	{
+		if (i != 3 && i != 4)
+		{
+			m_walls.Set(pen - 1, i, true);
+			m_walls.Set(i, pen - 1, true);
+		}
+		if (i != 4 && i != 5)
+		{
+			m_walls.Set(far, far + i, true);
+			m_walls.Set(far + i, far, true);
+		}
+	}
+
+	Colony& red = m_colonies[0];
+	red.queen.Set(3, 3);
+	red.x0 = red.y0 = 0;
+	red.x1 = red.y1 = pen;
+	Colony& blue = m_colonies[1];
+	blue.queen.Set(m_size - 4, m_size - 4);
+	blue.x0 = blue.y0 = far;
+	blue.x1 = blue.y1 = m_size;
+	FindEntrances(red);
+	FindEntrances(blue);
+}
+
+bool SandboxMap::Load(const char* file_path)
+{
+	unsigned width, height;
+	std::vector<unsigned char> pixels;
+	if (!LoadTGAPixels(file_path, width, height, pixels))
+		return false;
+	if (width != height || static_cast<int>(width) < MIN_SIZE || static_cast<int>(width) > MAX_SIZE)
+	{
+		std::cout << file_path << ": maps must be square, " << MIN_SIZE << " to " << MAX_SIZE << " cells a side\n";
+		return false;
+	}
+
+	int size = static_cast<int>(width);
+	BitGrid walls;
+	walls.Init(size, size, true);
+	std::vector<MazePt> foodSpawns;
+	Colony colonies[2];
+	bool hasQueen[2] = { false, false };
+	for (int team = 0; team < 2; ++team)
+	{
+		colonies[team].x0 = colonies[team].y0 = size;
+		colonies[team].x1 = colonies[team].y1 = 0;
+	}
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const unsigned char* p = &pixels[(y * size + x) * 4];
+			bool r = p[0] >= 64, g = p[1] >= 64, b = p[2] >= 64;
+			int team = -1;
+			if (!r && !g && !b)
+				walls.Set(x, y, true);
+			else if (g && !r && !b)
+				foodSpawns.push_back(MazePt(x, y));
+			else if (r && !g && !b)
+				team = 0;
+			else if (b && !r && !g)
+				team = 1;
+			if (team < 0)
+				continue;
+
+			Colony& colony = colonies[team];
+			if (p[team == 0 ? 0 : 2] >= 192)
+			{
+				if (hasQueen[team])
+				{
+					std::cout << file_path << ": more than one " << (team == 0 ? "red" : "blue") << " queen\n";
+					return false;
+				}
+				colony.queen.Set(x, y);
+				hasQueen[team] = true;
+			}
+			colony.x0 = Math::Min(colony.x0, x);
+			colony.y0 = Math::Min(colony.y0, y);
+			colony.x1 = Math::Max(colony.x1, x + 1);
+			colony.y1 = Math::Max(colony.y1, y + 1);
+		}
+	}
+	if (!hasQueen[0] || !hasQueen[1])
+	{
+		std::cout << file_path << ": needs one red and one blue queen\n";
+		return false;
+	}
+
+	m_size = size;
+	m_walls = walls;
+	m_foodSpawns.swap(foodSpawns);
+	for (int team = 0; team < 2; ++team)
+	{
+		m_colonies[team] = colonies[team];
+		FindEntrances(m_colonies[team]);
+	}
+	return true;
+}
+
+void SandboxMap::FindEntrances(Colony& colony) const
+{
+	//open cells along the top or bottom side first, then the left or right one, skipping sides on the map's edge
+	colony.entrances.clear();
+	int row = colony.y0 > 0 ? colony.y0 : colony.y1 < m_size ? colony.y1 - 1 : -1;
+	int col = colony.x0 > 0 ? colony.x0 : colony.x1 < m_size ? colony.x1 - 1 : -1;
+	if (row >= 0)
+	{
+		for (int x = colony.x0; x < colony.x1; ++x)
+			if (!IsWall(x, row)) colony.entrances.push_back(MazePt(x, row));
+	}
+	if (col >= 0)
+	{
+		for (int y = colony.y0; y < colony.y1; ++y)
+			if (y != row && !IsWall(col, y)) colony.entrances.push_back(MazePt(col, y));
+	}
+}
+
+int SandboxMap::GetSize() const
+{
+	return m_size;
+}
+
+const BitGrid& SandboxMap::GetWalls() const
+{
+	return m_walls;
+}
+
+bool SandboxMap::IsWall(int x, int y) const
+{
+	return m_walls.Get(x, y);
+}
+
+const std::vector<MazePt>& SandboxMap::GetFoodSpawns() const
+{
+	return m_foodSpawns;
+}
+
+const SandboxMap::Colony& SandboxMap::GetColony(int teamID) const
+{
+	return m_colonies[teamID];
+}
+
+bool SandboxMap::IsInTerritory(int x, int y, int teamID) const
+{
+	const Colony& colony = m_colonies[teamID];
+	return x >= colony.x0 && x < colony.x1 && y >= colony.y0 && y < colony.y1;
+}
+
+bool SandboxMap::IsNearColony(int x, int y, int margin) const
+{
+	for (int team = 0; team < 2; ++team)
+	{
+		const Colony& colony = m_colonies[team];
+		if (x >= colony.x0 - margin && x < colony.x1 + margin && y >= colony.y0 - margin && y < colony.y1 + margin)
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,53 @@
+#ifndef SANDBOX_MAP_H
+#define SANDBOX_MAP_H
+
+#include <vector>
+#include "Maze.h"
+#include "BitGrid.h"
+
+//layout of a sandbox match: a square grid of walls, where food may spawn and where each colony sits
+//either the built-in layout (a walled pen in two opposite corners) at any size, or read from a TGA mask,
+//one pixel per cell with the bottom row first:
+//	black			wall
+//	bright red/blue	the red/blue queen's cell
+//	dark red/blue	part of that colony's territory (the territory is the bounding box of these and the queen)
+//	green			a food spawn (none at all = food is scattered at random, as in the built-in layout)
+//	anything else	open ground
+//a colony's entrances are the open cells on the sides of its territory that face into the map
+class SandboxMap
+{
+public:
+	struct Colony
+	{
+		MazePt queen;
+		int x0, y0, x1, y1; //territory, x1 and y1 exclusive
+		std::vector<MazePt> entrances;
+	};
+
+	static const int MIN_SIZE = 16;
+	static const int MAX_SIZE = 4096;
+
+	SandboxMap();
+	~SandboxMap();
+
+	void CreateDefault(int size); //clamped to MIN_SIZE..MAX_SIZE
+	bool Load(const char* file_path); //false (and the map left as it was) if the file isn't a usable mask
+
+	int GetSize() const;
+	const BitGrid& GetWalls() const; //border set
+	bool IsWall(int x, int y) const;
+	const std::vector<MazePt>& GetFoodSpawns() const;
+	const Colony& GetColony(int teamID) const;
+	bool IsInTerritory(int x, int y, int teamID) const;
+	bool IsNearColony(int x, int y, int margin) const; //within margin cells of either territory
+
+private:
+	void FindEntrances(Colony& colony) const;
+
+	int m_size;
+	BitGrid m_walls;
+	std::vector<MazePt> m_foodSpawns;
+	Colony m_colonies[2];
+};
+
+#endif
@@ -26,6 +26,8 @@ SceneData::SceneData()
 	, m_noGrid(0)
 	, m_gridSize(0.f)
 	, m_gridOffset(0.f)
+	, m_map(nullptr)
+	, m_units(nullptr)
 {
 }
 
@@ -62,3 +64,23 @@ void SceneData::SetGridOffset(const float gridOffset)
 {
 	m_gridOffset = gridOffset;
 }
+
+const SandboxMap* SceneData::GetMap() const
+{
+	return m_map;
+}
+
+void SceneData::SetMap(const SandboxMap* map)
+{
+	m_map = map;
+}
+
+UnitStore* SceneData::GetUnits() const
+{
+	return m_units;
+}
+
+void SceneData::SetUnits(UnitStore* units)
+{
+	m_units = units;
+}
@@ -3,6 +3,9 @@
 
 #include "SingletonTemplate.h"
 
+class SandboxMap;
+struct UnitStore;
+
 class SceneData : public Singleton<SceneData>
 {
 	friend Singleton<SceneData>;
@@ -17,6 +20,10 @@ public:
 	void SetGridSize(const float gridSize);
 	float GetGridOffset() const;
 	void SetGridOffset(const float gridOffset);
+	const SandboxMap* GetMap() const;
+	void SetMap(const SandboxMap* map);
+	UnitStore* GetUnits() const; //the sandbox's unit positions, targets and speeds, see UnitStore
+	void SetUnits(UnitStore* units);
 
 private:
 	SceneData();
@@ -26,6 +33,8 @@ private:
 	int m_noGrid;
 	float m_gridSize;
 	float m_gridOffset;
+	const SandboxMap* m_map;
+	UnitStore* m_units;
 };
 
 #endif
@@ -541,7 +541,7 @@ void SceneMovement_Week04::Exit()
 //handle all incoming messages from PostOffice
 bool SceneMovement_Week04::Handle(Message* message)
 {
-	MessageWRU* messageWRU = dynamic_cast<MessageWRU*>(message);
+	MessageWRU* messageWRU = MessageCast<MessageWRU>(message);
 	if (messageWRU)
 	{
 		//get pointer to the entity who fired the event
@@ -571,7 +571,7 @@ void SceneMovement_Week05::Exit()
 bool SceneMovement_Week05::Handle(Message* message)
 {
 	// Exercise Week 05
-	MessageSpawnFood* msgSpawnFood = dynamic_cast<MessageSpawnFood*>(message);
+	MessageSpawnFood* msgSpawnFood = MessageCast<MessageSpawnFood>(message);
 	if (msgSpawnFood)
 	{
 		for (int i = 0; i < msgSpawnFood->count; i++)
@@ -593,7 +593,7 @@ bool SceneMovement_Week05::Handle(Message* message)
 		return true;
 	}
 
-	MessageEvolve* msgFishFoodEvolve = dynamic_cast<MessageEvolve*>(message);
+	MessageEvolve* msgFishFoodEvolve = MessageCast<MessageEvolve>(message);
 	if (msgFishFoodEvolve)
 	{
 		msgFishFoodEvolve->go->Handle(message);
@@ -613,7 +613,7 @@ bool SceneMovement_Week05::Handle(Message* message)
 		return true;
 	}
 
-	MessageWRU* messageWRU = dynamic_cast<MessageWRU*>(message);
+	MessageWRU* messageWRU = MessageCast<MessageWRU>(message);
 	if (messageWRU)
 	{
 		//get pointer to the entity who fired the event
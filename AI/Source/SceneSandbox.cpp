@@ -6,17 +6,24 @@
 #include "SceneData.h"
 #include "PostOffice.h"
 #include "ConcreteMessages.h"
+#include "MeshBuilder.h"
 #include <iomanip>
-#include <queue>
 #include <algorithm>
+#include <cmath>
 
 SceneSandbox::SceneSandbox()
 	: m_goList{}, m_spatialGrid{}, m_speed{}, m_worldWidth{}, m_worldHeight{},
 	m_noGrid{}, m_gridSize{}, m_gridOffset{},
 	m_redWorkerCount{}, m_redResources{}, m_blueWorkerCount{}, m_blueResources{},
 	m_redQueen{}, m_blueQueen{}, m_simulationTime{}, m_simulationEnded{}, m_winner{}, m_updateTimer{}, m_updateCycle{},
-	m_wallGrid{}, m_foodGrid{}, m_coloniesDetected(false)
+	m_coloniesDetected(false), m_headless(false), m_seed(0), m_poolReserve(24), m_jobThreads(0), m_bufferedAI(false), m_deferredMessages(false), m_aiPhase(0), m_inactiveAfterFlush(0), m_obstacleVersion(0), m_mapSize(30)
 {
+	m_dispatcher.Register<MessageSpawnUnit, &SceneSandbox::OnSpawnUnit>();
+	m_dispatcher.Register<MessageResourceDepleted, &SceneSandbox::OnResourceDepleted>();
+	m_dispatcher.Register<MessageUnitDied, &SceneSandbox::OnUnitDied>();
+	m_dispatcher.Register<MessageResourceDelivered, &SceneSandbox::OnResourceDelivered>();
+	m_dispatcher.Register<MessageEnemySpotted, &SceneSandbox::OnEnemySpotted>();
+	m_dispatcher.Register<MessageRequestHelp, &SceneSandbox::OnRequestHelp>();
 }
 
 SceneSandbox::~SceneSandbox()
@@ -25,7 +32,8 @@ SceneSandbox::~SceneSandbox()
 
 void SceneSandbox::Init()
 {
-	SceneBase::Init();
+	if (!m_headless)
+		SceneBase::Init();
 	bLightEnabled = false;
 
 	// Calculating aspect ratio
@@ -35,44 +43,59 @@ void SceneSandbox::Init()
 	// Physics code
 	m_speed = 1.f;
 
-	Math::InitRNG();
+	Math::InitRNG(m_seed);
 	
-	// Grid setup - 30x30
-	m_noGrid = 30;
+	// Grid setup - 30x30 unless a bigger map was asked for
+	if (m_mapFile.empty() || !m_map.Load(m_mapFile.c_str()))
+		m_map.CreateDefault(m_mapSize);
+	m_noGrid = m_map.GetSize();
 	m_gridSize = m_worldHeight / m_noGrid;
 	m_gridOffset = m_gridSize / 2;
 
-	m_wallGrid.assign(m_noGrid * m_noGrid, false);
-	m_foodGrid.assign(m_noGrid * m_noGrid, false);
-
-	// 1. Walls around Speedy Ant Colony
-	for (int y = 0; y <= 7; ++y)
-	{
-		// Leave gap at y=3 and y=4 for entry/exit
-		if (y != 3 && y != 4)
-			m_wallGrid[Get1DIndex(7, y)] = true;
-	}
-	// Horizontal Wall at y=7
-	for (int x = 0; x <= 7; ++x)
-	{
-		// Leave gap at x=3 and x=4
-		if (x != 3 && x != 4)
-			m_wallGrid[Get1DIndex(x, 7)] = true;
-	}
-
-	// 2. Walls around Strong Ant Colony
-	for (int y = 22; y < m_noGrid; ++y)
-	{
-		// Leave gap at y=26 and y=27
-		if (y != 26 && y != 27)
-			m_wallGrid[Get1DIndex(22, y)] = true;
-	}
-	// Horizontal Wall at y=22
-	for (int x = 22; x < m_noGrid; ++x)
+	// Allocate the whole match's objects up front so spawning never hits the heap
+	m_pool.Init(&m_goList);
+	m_pool.Reserve(GameObject::GO_QUEEN, 2);
+	m_pool.Reserve(GameObject::GO_FOOD, Math::Max(25, static_cast<int>(m_map.GetFoodSpawns().size())));
+	m_pool.Reserve(GameObject::GO_WORKER, m_poolReserve);
+	m_pool.Reserve(GameObject::GO_SOLDIER, m_poolReserve);
+	m_pool.Reserve(GameObject::GO_HEALER, m_poolReserve);
+	m_pool.Reserve(GameObject::GO_SCOUT, m_poolReserve);
+	m_pool.Reserve(GameObject::GO_TANK, m_poolReserve);
+
+	m_wallGrid = m_map.GetWalls();
+	m_foodGrid.Init(m_noGrid, m_noGrid, true);
+	m_blockedGrid = m_wallGrid;
+	m_units.Clear();
+	m_pool.SetUnitStore(&m_units);
+	m_spatialGrid.Init(m_noGrid, m_gridSize, &m_units);
+	m_pool.SetSpatialGrid(&m_spatialGrid);
+	m_foodIndex.Init(m_noGrid, m_gridSize, &m_units, Math::Max(4, m_noGrid / 64)); // at most 64x64 buckets, the nearest-food search walks empty ones too
+	m_pheromones[0].Init(m_noGrid, m_gridSize);
+	m_pheromones[1].Init(m_noGrid, m_gridSize);
+	m_pathfinder.Init(&m_blockedGrid);
+	m_jobs.Init(m_jobThreads);
+	m_pathfinder.SetAlgorithm(GridPathfinder::ALGO_ASTAR);
+	m_pathRequests.Init(&m_blockedGrid, m_pathfinder.GetAlgorithm(), m_jobs.GetThreadCount());
+	m_pathRequests.SetBudget(m_headless ? 0.f : 2.f); // headless answers everything so a seed always plays out the same
+	m_pathCache.Init(m_noGrid, m_noGrid);
+	m_pathRequests.SetCache(&m_pathCache);
+	m_flowFields.Init(&m_blockedGrid);
+
+	if (!m_headless)
 	{
-		// Leave gap at x=26 and x=27
-		if (x != 26 && x != 27)
-			m_wallGrid[Get1DIndex(x, 22)] = true;
+		// Pheromones are drawn as one texture over the map, one texel per grid cell
+		GLuint texture = 0;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_noGrid, m_noGrid, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		meshList[GEO_PHEROMONE] = MeshBuilder::GenerateQuad("pheromone", Color(1, 1, 1));
+		meshList[GEO_PHEROMONE]->textureID = texture;
+		m_pheromonePixels.assign(m_noGrid * m_noGrid * 4, 0);
 	}
 
 	SceneData::GetInstance()->SetObjectCount(0);
@@ -80,88 +103,111 @@ void SceneSandbox::Init()
 	SceneData::GetInstance()->SetNumGrid(m_noGrid);
 	SceneData::GetInstance()->SetGridSize(m_gridSize);
 	SceneData::GetInstance()->SetGridOffset(m_gridOffset);
+	SceneData::GetInstance()->SetMap(&m_map);
+	SceneData::GetInstance()->SetUnits(&m_units);
 	ResetGlobalSandboxVars();
 	// Register scene with post office
 	PostOffice::GetInstance()->Register("Scene", this);
+	PostOffice::GetInstance()->SetLocator(this);
+	// Deferred: everything the scene handles is queued and delivered by type after each state machine pass
+	for (int i = 0; i < Message::NUM_MESSAGE_TYPES; ++i) {
+		Message::MESSAGE_TYPE type = static_cast<Message::MESSAGE_TYPE>(i);
+		if (m_dispatcher.IsRegistered(type)) PostOffice::GetInstance()->SetDeferred(type, m_deferredMessages);
+	}
 
 	m_redWorkerCount = 0; m_redSoldierCount = 0; m_redHealerCount = 0; m_redScoutCount = 0; m_redTankCount = 0;
 	m_blueWorkerCount = 0; m_blueSoldierCount = 0; m_blueHealerCount = 0; m_blueScoutCount = 0; m_blueTankCount = 0;
 	m_redResources = 0; m_blueResources = 0;
 	m_simulationTime = 0.f; m_simulationEnded = false; m_winner = 2;
+	m_inactiveAfterFlush = 0;
 	m_updateTimer = 0.f; m_updateCycle = 0;
 
 	//spawn queens
-	m_redQueen = FetchGO(GameObject::GO_QUEEN); m_redQueen->teamID = 0; m_redQueen->pos.Set(m_gridSize * 3.f + m_gridOffset, m_gridSize * 3.f + m_gridOffset, 0); m_redQueen->homeBase = m_redQueen->pos; m_redQueen->scale.Set(m_gridSize * 1.5f, m_gridSize * 1.5f, 1.f); m_redQueen->maxHealth = 50.f; m_redQueen->health = 50.f; m_redQueen->moveSpeed = 0.f; m_redQueen->detectionRange = m_gridSize * 8.f; m_redQueen->sm = new StateMachine(); m_redQueen->sm->AddState(new StateQueenSpawning("Spawning", m_redQueen)); m_redQueen->sm->AddState(new StateQueenEmergency("Emergency", m_redQueen)); m_redQueen->sm->AddState(new StateQueenCooldown("Cooldown", m_redQueen)); m_redQueen->sm->SetNextState("Spawning");
-	m_blueQueen = FetchGO(GameObject::GO_QUEEN); m_blueQueen->teamID = 1; m_blueQueen->pos.Set(m_gridSize * (m_noGrid - 4.f) + m_gridOffset, m_gridSize * (m_noGrid - 4.f) + m_gridOffset, 0); m_blueQueen->homeBase = m_blueQueen->pos; m_blueQueen->scale.Set(m_gridSize * 1.5f, m_gridSize * 1.5f, 1.f); m_blueQueen->maxHealth = 50.f; m_blueQueen->health = 50.f; m_blueQueen->moveSpeed = 0.f; m_blueQueen->detectionRange = m_gridSize * 8.f; m_blueQueen->sm = new StateMachine(); m_blueQueen->sm->AddState(new StateQueenSpawning("Spawning", m_blueQueen)); m_blueQueen->sm->AddState(new StateQueenEmergency("Emergency", m_blueQueen)); m_blueQueen->sm->AddState(new StateQueenCooldown("Cooldown", m_blueQueen)); m_blueQueen->sm->SetNextState("Spawning");
+	m_redQueen = FetchGO(GameObject::GO_QUEEN); m_redQueen->teamID = 0; m_units.SetPos(m_redQueen, Vector3(m_gridSize * m_map.GetColony(0).queen.x + m_gridOffset, m_gridSize * m_map.GetColony(0).queen.y + m_gridOffset, 0)); m_redQueen->homeBase = m_units.GetPos(m_redQueen); m_redQueen->scale.Set(m_gridSize * 1.5f, m_gridSize * 1.5f, 1.f); m_redQueen->maxHealth = 50.f; m_redQueen->health = 50.f; m_units.SetSpeed(m_redQueen, 0.f); m_redQueen->detectionRange = m_gridSize * 8.f; m_redQueen->sm = new StateMachine(); m_redQueen->sm->AddState(new StateQueenSpawning("Spawning", m_redQueen)); m_redQueen->sm->AddState(new StateQueenEmergency("Emergency", m_redQueen)); m_redQueen->sm->AddState(new StateQueenCooldown("Cooldown", m_redQueen)); m_redQueen->sm->SetNextState("Spawning");
+	m_blueQueen = FetchGO(GameObject::GO_QUEEN); m_blueQueen->teamID = 1; m_units.SetPos(m_blueQueen, Vector3(m_gridSize * m_map.GetColony(1).queen.x + m_gridOffset, m_gridSize * m_map.GetColony(1).queen.y + m_gridOffset, 0)); m_blueQueen->homeBase = m_units.GetPos(m_blueQueen); m_blueQueen->scale.Set(m_gridSize * 1.5f, m_gridSize * 1.5f, 1.f); m_blueQueen->maxHealth = 50.f; m_blueQueen->health = 50.f; m_units.SetSpeed(m_blueQueen, 0.f); m_blueQueen->detectionRange = m_gridSize * 8.f; m_blueQueen->sm = new StateMachine(); m_blueQueen->sm->AddState(new StateQueenSpawning("Spawning", m_blueQueen)); m_blueQueen->sm->AddState(new StateQueenEmergency("Emergency", m_blueQueen)); m_blueQueen->sm->AddState(new StateQueenCooldown("Cooldown", m_blueQueen)); m_blueQueen->sm->SetNextState("Spawning");
 
 	// Spawn initial workers for both teams
 	for (int i = 0; i < 3; ++i)
 	{
 		// Speedy Ant workers
 		SpawnUnit(MessageSpawnUnit::UNIT_SPEEDY_ANT_WORKER,
-			m_redQueen->pos + Vector3(0, 0), 0);
+			m_units.GetPos(m_redQueen) + Vector3(0, 0), 0);
 
 		// Strong workers
 		SpawnUnit(MessageSpawnUnit::UNIT_STRONG_ANT_WORKER,
-			m_blueQueen->pos + Vector3(0, 0), 1);
+			m_units.GetPos(m_blueQueen) + Vector3(0, 0), 1);
 	}
 
 	// Spawn initial soldiers
 	for (int i = 0; i < 2; ++i)
 	{
 		SpawnUnit(MessageSpawnUnit::UNIT_SPEEDY_ANT_SOLDIER,
-			m_redQueen->pos + Vector3(Math::RandFloatMinMax(-3, 3) * m_gridSize,
+			m_units.GetPos(m_redQueen) + Vector3(Math::RandFloatMinMax(-3, 3) * m_gridSize,
 				Math::RandFloatMinMax(-3, 3) * m_gridSize, 0), 0);
 
 		SpawnUnit(MessageSpawnUnit::UNIT_STRONG_ANT_SOLDIER,
-			m_blueQueen->pos + Vector3(Math::RandFloatMinMax(-3, 3) * m_gridSize,
+			m_units.GetPos(m_blueQueen) + Vector3(Math::RandFloatMinMax(-3, 3) * m_gridSize,
 				Math::RandFloatMinMax(-3, 3) * m_gridSize, 0), 1);
 	}
 
-	//SpawnUnit(MessageSpawnUnit::UNIT_HEALER, m_redQueen->pos + Vector3(2, 0, 0), 0);
-	SpawnUnit(MessageSpawnUnit::UNIT_SCOUT, m_redQueen->pos + Vector3(0, 2, 0), 0);
-	//SpawnUnit(MessageSpawnUnit::UNIT_TANK, m_redQueen->pos + Vector3(2, 2, 0), 0);
+	//SpawnUnit(MessageSpawnUnit::UNIT_HEALER, m_units.GetPos(m_redQueen) + Vector3(2, 0, 0), 0);
+	SpawnUnit(MessageSpawnUnit::UNIT_SCOUT, m_units.GetPos(m_redQueen) + Vector3(0, 2, 0), 0);
+	//SpawnUnit(MessageSpawnUnit::UNIT_TANK, m_units.GetPos(m_redQueen) + Vector3(2, 2, 0), 0);
 
-	//SpawnUnit(MessageSpawnUnit::UNIT_HEALER, m_blueQueen->pos + Vector3(-2, 0, 0), 1);
-	SpawnUnit(MessageSpawnUnit::UNIT_SCOUT, m_blueQueen->pos + Vector3(0, -2, 0), 1);
-	//SpawnUnit(MessageSpawnUnit::UNIT_TANK, m_blueQueen->pos + Vector3(-2, -2, 0), 1);
+	//SpawnUnit(MessageSpawnUnit::UNIT_HEALER, m_units.GetPos(m_blueQueen) + Vector3(-2, 0, 0), 1);
+	SpawnUnit(MessageSpawnUnit::UNIT_SCOUT, m_units.GetPos(m_blueQueen) + Vector3(0, -2, 0), 1);
+	//SpawnUnit(MessageSpawnUnit::UNIT_TANK, m_units.GetPos(m_blueQueen) + Vector3(-2, -2, 0), 1);
 
 	// Spawn food resources in center and various locations
 	m_foodLocations.clear();
+	m_foodItems.clear();
 	std::vector<GameObject*> allFood; // Keep track for trail generation
-	int foodCount = Math::RandIntMinMax(15, 25);
+	const std::vector<MazePt>& foodSpawns = m_map.GetFoodSpawns();
+	int foodCount = foodSpawns.empty() ? Math::RandIntMinMax(15, 25) : static_cast<int>(foodSpawns.size());
 	for (int i = 0; i < foodCount; ++i)
 	{
 		GameObject* food = FetchGO(GameObject::GO_FOOD);
 		int gridX, gridY;
 		bool validPos = false;
+		if (!foodSpawns.empty()) { gridX = foodSpawns[i].x; gridY = foodSpawns[i].y; validPos = true; }
 		while (!validPos)
 		{
 			if (i < foodCount / 2) { int minC = static_cast<int>(m_noGrid * 0.3f); int maxC = static_cast<int>(m_noGrid * 0.7f); gridX = Math::RandIntMinMax(minC, maxC); gridY = Math::RandIntMinMax(minC, maxC); }
 			else { gridX = Math::RandIntMinMax(2, m_noGrid - 3); gridY = Math::RandIntMinMax(2, m_noGrid - 3); }
-			if (!IsWithinBoundary(gridX) || !IsWithinBoundary(gridY) || m_wallGrid[Get1DIndex(gridX, gridY)]) continue;
-			if (m_foodGrid[Get1DIndex(gridX, gridY)]) continue;
-			if (gridX <= 8 && gridY <= 8) continue;
-			if (gridX >= 21 && gridY >= 21) continue;
+			if (!IsWithinBoundary(gridX) || !IsWithinBoundary(gridY) || m_wallGrid.Get(gridX, gridY)) continue;
+			if (m_foodGrid.Get(gridX, gridY)) continue;
+			if (m_map.IsNearColony(gridX, gridY, 1)) continue;
 			validPos = true;
 		}
 		float worldX = gridX * m_gridSize + m_gridOffset;
 		float worldY = gridY * m_gridSize + m_gridOffset;
-		food->pos.Set(worldX, worldY, 0);
+		m_units.SetPos(food, Vector3(worldX, worldY, 0));
 		food->scale.Set(m_gridSize * 0.8f, m_gridSize * 0.8f, 1.f);
-		food->moveSpeed = 0.f;
+		m_units.SetSpeed(food, 0.f);
 		food->health = 1.f;
 		food->resourceCount = 25;
 		food->harvesterCount = 0;
 		food->isMarked = false;
-		m_foodGrid[Get1DIndex(gridX, gridY)] = true;
-		m_foodLocations.push_back(food->pos);
+		m_foodGrid.Set(gridX, gridY, true); // nothing has been routed yet, no need to bump the version
+		m_foodIndex.Insert(food);
+		m_foodLocations.push_back(m_units.GetPos(food));
+		m_foodItems.push_back(food);
 		allFood.push_back(food);
 	}
 
+	m_blockedGrid.Or(m_foodGrid);
+
+	// Big maps route over clusters of cells: a flat search there expands most of the map per request
+	const int hierarchicalMinGrid = 128;
+	if (m_noGrid >= hierarchicalMinGrid) {
+		m_clusters.Init(&m_blockedGrid);
+		m_hierarchicalPathfinder.Init(&m_clusters);
+		m_pathRequests.SetClusterGraph(&m_clusters);
+	}
+
 	std::vector<GameObject*> redFood = allFood;
 	std::sort(redFood.begin(), redFood.end(), [&](GameObject* a, GameObject* b) {
-		return (a->pos - m_redQueen->pos).LengthSquared() < (b->pos - m_redQueen->pos).LengthSquared();
+		return (m_units.GetPos(a) - m_units.GetPos(m_redQueen)).LengthSquared() < (m_units.GetPos(b) - m_units.GetPos(m_redQueen)).LengthSquared();
 		});
 	// Mark and spawn trails for top 2
 	for (int i = 0; i < 2 && i < redFood.size(); ++i) {
@@ -171,7 +217,7 @@ void SceneSandbox::Init()
 
 	std::vector<GameObject*> blueFood = allFood;
 	std::sort(blueFood.begin(), blueFood.end(), [&](GameObject* a, GameObject* b) {
-		return (a->pos - m_blueQueen->pos).LengthSquared() < (b->pos - m_blueQueen->pos).LengthSquared();
+		return (m_units.GetPos(a) - m_units.GetPos(m_blueQueen)).LengthSquared() < (m_units.GetPos(b) - m_units.GetPos(m_blueQueen)).LengthSquared();
 		});
 	for (int i = 0; i < 2 && i < blueFood.size(); ++i) {
 		// Only spawn trail if not already marked by RED (avoid double trails for simplicity, or allow both)
@@ -183,15 +229,10 @@ void SceneSandbox::Init()
 
 GameObject* SceneSandbox::FetchGO(GameObject::GAMEOBJECT_TYPE type)
 {
-	for (size_t i = 0; i < m_goList.size(); ++i) {
-		GameObject* go = m_goList[i];
-		if (!go->active && go->type == type) { go->active = true; return go; }
-	}
-	for (unsigned i = 0; i < 10; ++i) {
-		GameObject* go = new GameObject(type);
-		m_goList.push_back(go);
-	}
-	return FetchGO(type);
+	GameObject* go = m_pool.Acquire(type);
+	// A recycled unit still has the state machine from its previous life
+	if (go->sm) { delete go->sm; go->sm = nullptr; }
+	return go;
 }
 
 void SceneSandbox::SpawnUnit(MessageSpawnUnit::UNIT_TYPE unitType, Vector3 position, int teamID) {
@@ -201,13 +242,11 @@ void SceneSandbox::SpawnUnit(MessageSpawnUnit::UNIT_TYPE unitType, Vector3 posit
 	float soldierHP = 20.f; float soldierSpeed = 3.f; float soldierAtk = 3.0f;
 
 	switch (unitType) {
-	case MessageSpawnUnit::UNIT_PHEROMONE: unit = FetchGO(GameObject::GO_PHEROMONE); unit->teamID = teamID; unit->moveSpeed = 0.f; break;
-
 	case MessageSpawnUnit::UNIT_SPEEDY_ANT_WORKER:
 	case MessageSpawnUnit::UNIT_STRONG_ANT_WORKER:
 		unit = FetchGO(GameObject::GO_WORKER); unit->teamID = teamID;
-		unit->homeBase = (teamID == 0) ? m_redQueen->pos : m_blueQueen->pos;
-		unit->maxHealth = workerHP; unit->health = workerHP; unit->attackPower = workerAtk; unit->moveSpeed = workerSpeed; unit->baseSpeed = workerSpeed;
+		unit->homeBase = (teamID == 0) ? m_units.GetPos(m_redQueen) : m_units.GetPos(m_blueQueen);
+		unit->maxHealth = workerHP; unit->health = workerHP; unit->attackPower = workerAtk; m_units.SetSpeed(unit, workerSpeed); unit->baseSpeed = workerSpeed;
 		unit->detectionRange = m_gridSize * 6.f; unit->attackRange = m_gridSize * 0.8f;
 		unit->sm = new StateMachine(); unit->sm->AddState(new StateWorkerIdle("Idle", unit)); unit->sm->AddState(new StateWorkerSearching("Searching", unit)); unit->sm->AddState(new StateWorkerGathering("Gathering", unit)); unit->sm->AddState(new StateWorkerFleeing("Fleeing", unit)); unit->sm->SetNextState("Idle");
 		break;
@@ -215,106 +254,106 @@ void SceneSandbox::SpawnUnit(MessageSpawnUnit::UNIT_TYPE unitType, Vector3 posit
 	case MessageSpawnUnit::UNIT_SPEEDY_ANT_SOLDIER:
 	case MessageSpawnUnit::UNIT_STRONG_ANT_SOLDIER:
 		unit = FetchGO(GameObject::GO_SOLDIER); unit->teamID = teamID;
-		unit->homeBase = (teamID == 0) ? m_redQueen->pos : m_blueQueen->pos;
-		unit->maxHealth = soldierHP; unit->health = soldierHP; unit->attackPower = soldierAtk; unit->moveSpeed = soldierSpeed; unit->baseSpeed = soldierSpeed;
+		unit->homeBase = (teamID == 0) ? m_units.GetPos(m_redQueen) : m_units.GetPos(m_blueQueen);
+		unit->maxHealth = soldierHP; unit->health = soldierHP; unit->attackPower = soldierAtk; m_units.SetSpeed(unit, soldierSpeed); unit->baseSpeed = soldierSpeed;
 		unit->detectionRange = m_gridSize * 8.f; unit->attackRange = m_gridSize * 1.3f;
 		unit->sm = new StateMachine(); unit->sm->AddState(new StateSoldierPatrolling("Patrolling", unit)); unit->sm->AddState(new StateSoldierAttacking("Attacking", unit)); unit->sm->AddState(new StateSoldierResting("Resting", unit)); unit->sm->AddState(new StateSoldierRetreating("Retreating", unit)); unit->sm->SetNextState("Patrolling");
 		break;
 
-	case MessageSpawnUnit::UNIT_HEALER: unit = FetchGO(GameObject::GO_HEALER); unit->teamID = teamID; unit->homeBase = (teamID == 0) ? m_redQueen->pos : m_blueQueen->pos; unit->maxHealth = 8.f; unit->health = 8.f; unit->moveSpeed = 4.f; unit->baseSpeed = 4.f; unit->sm = new StateMachine(); unit->sm->AddState(new StateHealerIdle("Idle", unit)); unit->sm->AddState(new StateHealerTraveling("Traveling", unit)); unit->sm->AddState(new StateHealerHealing("Healing", unit)); unit->sm->SetNextState("Idle"); break;
-	case MessageSpawnUnit::UNIT_SCOUT: unit = FetchGO(GameObject::GO_SCOUT); unit->teamID = teamID; unit->homeBase = (teamID == 0) ? m_redQueen->pos : m_blueQueen->pos; unit->maxHealth = 5.f; unit->health = 5.f; unit->moveSpeed = 8.f; unit->baseSpeed = 8.f; unit->detectionRange = m_gridSize * 6.f; unit->sm = new StateMachine(); unit->sm->AddState(new StateScoutPatrolling("Patrolling", unit)); unit->sm->AddState(new StateScoutReturnToColony("ReturnToColony", unit)); unit->sm->AddState(new StateScoutHiding("Hiding", unit)); unit->sm->SetNextState("Patrolling"); break;
-	case MessageSpawnUnit::UNIT_TANK: unit = FetchGO(GameObject::GO_TANK); unit->teamID = teamID; unit->homeBase = (teamID == 0) ? m_redQueen->pos : m_blueQueen->pos; unit->maxHealth = 40.f; unit->health = 40.f; unit->moveSpeed = 1.5f; unit->baseSpeed = 1.5f; unit->attackPower = 1.0f; unit->attackRange = m_gridSize * 0.5f; unit->sm = new StateMachine(); unit->sm->AddState(new StateTankGuarding("Guarding", unit)); unit->sm->AddState(new StateTankBlocking("Blocking", unit)); unit->sm->AddState(new StateTankRecovering("Recovering", unit)); unit->sm->SetNextState("Guarding"); break;
+	case MessageSpawnUnit::UNIT_HEALER: unit = FetchGO(GameObject::GO_HEALER); unit->teamID = teamID; unit->homeBase = (teamID == 0) ? m_units.GetPos(m_redQueen) : m_units.GetPos(m_blueQueen); unit->maxHealth = 8.f; unit->health = 8.f; m_units.SetSpeed(unit, 4.f); unit->baseSpeed = 4.f; unit->sm = new StateMachine(); unit->sm->AddState(new StateHealerIdle("Idle", unit)); unit->sm->AddState(new StateHealerTraveling("Traveling", unit)); unit->sm->AddState(new StateHealerHealing("Healing", unit)); unit->sm->SetNextState("Idle"); break;
+	case MessageSpawnUnit::UNIT_SCOUT: unit = FetchGO(GameObject::GO_SCOUT); unit->teamID = teamID; unit->homeBase = (teamID == 0) ? m_units.GetPos(m_redQueen) : m_units.GetPos(m_blueQueen); unit->maxHealth = 5.f; unit->health = 5.f; m_units.SetSpeed(unit, 8.f); unit->baseSpeed = 8.f; unit->detectionRange = m_gridSize * 6.f; unit->sm = new StateMachine(); unit->sm->AddState(new StateScoutPatrolling("Patrolling", unit)); unit->sm->AddState(new StateScoutReturnToColony("ReturnToColony", unit)); unit->sm->AddState(new StateScoutHiding("Hiding", unit)); unit->sm->SetNextState("Patrolling"); break;
+	case MessageSpawnUnit::UNIT_TANK: unit = FetchGO(GameObject::GO_TANK); unit->teamID = teamID; unit->homeBase = (teamID == 0) ? m_units.GetPos(m_redQueen) : m_units.GetPos(m_blueQueen); unit->maxHealth = 40.f; unit->health = 40.f; m_units.SetSpeed(unit, 1.5f); unit->baseSpeed = 1.5f; unit->attackPower = 1.0f; unit->attackRange = m_gridSize * 0.5f; unit->sm = new StateMachine(); unit->sm->AddState(new StateTankGuarding("Guarding", unit)); unit->sm->AddState(new StateTankBlocking("Blocking", unit)); unit->sm->AddState(new StateTankRecovering("Recovering", unit)); unit->sm->SetNextState("Guarding"); break;
 	}
 	if (unit) {
-		// --- FIX: SNAP PHEROMONE TO GRID ---
-		if (unitType == MessageSpawnUnit::UNIT_PHEROMONE) {
-			int gx = (int)(position.x / m_gridSize); int gy = (int)(position.y / m_gridSize);
-			unit->pos.Set(gx * m_gridSize + m_gridOffset, gy * m_gridSize + m_gridOffset, 0);
-			unit->scale.Set(m_gridSize * 0.3f, m_gridSize * 0.3f, 1.f);
-		}
-		else {
-			int gx = (int)(position.x / m_gridSize); int gy = (int)(position.y / m_gridSize);
-			unit->pos.Set(gx * m_gridSize + m_gridOffset, gy * m_gridSize + m_gridOffset, 0);
-			unit->target = unit->pos;
-			unit->scale.Set(m_gridSize, m_gridSize, 1.f);
-			unit->targetFoodItem = nullptr;
-		}
+		int gx = (int)(position.x / m_gridSize); int gy = (int)(position.y / m_gridSize);
+		m_units.SetPos(unit, Vector3(gx * m_gridSize + m_gridOffset, gy * m_gridSize + m_gridOffset, 0));
+		m_units.SetTarget(unit, m_units.GetPos(unit));
+		unit->scale.Set(m_gridSize, m_gridSize, 1.f);
+		unit->targetFoodItem = nullptr;
+		// Defenders hear the queen's alarm
+		if (unit->type == GameObject::GO_SOLDIER || unit->type == GameObject::GO_TANK) PostOffice::GetInstance()->Subscribe(GetTeamAlertChannel(teamID), unit);
 	}
 }
 
 void SceneSandbox::SpawnTrail(GameObject* startObj, GameObject* endFood, int teamID)
 {
-	int gxStart = (int)(startObj->pos.x / m_gridSize); int gyStart = (int)(startObj->pos.y / m_gridSize);
-	int gxEnd = (int)(endFood->pos.x / m_gridSize); int gyEnd = (int)(endFood->pos.y / m_gridSize);
+	Vector3 startPos = m_units.GetPos(startObj); Vector3 endPos = m_units.GetPos(endFood);
+	int gxStart = (int)(startPos.x / m_gridSize); int gyStart = (int)(startPos.y / m_gridSize);
+	int gxEnd = (int)(endPos.x / m_gridSize); int gyEnd = (int)(endPos.y / m_gridSize);
 	MazePt startPt(gxStart, gyStart); MazePt endPt(gxEnd, gyEnd);
 	MazePt targetPt = GetNearestVacantNeighbor(endPt, startPt);
 	std::vector<MazePt> path = FindPath(startPt, targetPt);
 
-	for (MazePt pt : path) {
-		// --- FIX: CHECK IF TRAIL ALREADY EXISTS ---
-		bool exists = false;
-		for (auto go : m_goList) {
-			if (go->active && go->type == GameObject::GO_PHEROMONE) {
-				int pgx = (int)(go->pos.x / m_gridSize);
-				int pgy = (int)(go->pos.y / m_gridSize);
-				if (pgx == pt.x && pgy == pt.y) {
-					exists = true;
-					break;
-				}
-			}
-		}
-		if (exists) continue;
-		// ------------------------------------------
+	int foodId = GetFoodId(endFood);
+	if (foodId < 0) return;
+	for (MazePt pt : path) m_pheromones[teamID].Deposit(pt.x, pt.y, foodId); // cells already on a trail keep their food
+}
 
-		Vector3 pos(pt.x * m_gridSize + m_gridOffset, pt.y * m_gridSize + m_gridOffset, 0);
-		GameObject* pheromone = FetchGO(GameObject::GO_PHEROMONE);
-		pheromone->active = true; pheromone->pos = pos; pheromone->teamID = teamID; pheromone->targetFoodItem = endFood;
-		pheromone->scale.Set(m_gridSize * 0.3f, m_gridSize * 0.3f, 1.f); pheromone->moveSpeed = 0.f;
-	}
+int SceneSandbox::GetFoodId(const GameObject* food) const
+{
+	for (size_t i = 0; i < m_foodItems.size(); ++i) { if (m_foodItems[i] == food) return static_cast<int>(i); }
+	return -1;
+}
+
+GameObject* SceneSandbox::GetTrailFood(int foodId) const
+{
+	if (foodId < 0 || foodId >= static_cast<int>(m_foodItems.size())) return nullptr;
+	GameObject* food = m_foodItems[foodId];
+	if (!food->active || food->resourceCount <= 0) return nullptr;
+	return food;
 }
 
 std::vector<MazePt> SceneSandbox::FindPath(MazePt start, MazePt end)
 {
 	std::vector<MazePt> path;
-	if (start.x == end.x && start.y == end.y) return path;
-	if (IsGridOccupied(end.x, end.y)) return path; // Cannot path TO a solid object (must path to neighbor)
+	if (m_pathCache.Find(start, end, path)) return path;
+	path = m_clusters.GetClusterSize() > 0 ? m_hierarchicalPathfinder.FindPath(start, end) : m_pathfinder.FindPath(start, end);
+	m_pathCache.Insert(start, end, path);
+	return path;
+}
 
-	std::vector<bool> visited(m_noGrid * m_noGrid, false);
-	std::vector<int> parent(m_noGrid * m_noGrid, -1);
-	std::queue<MazePt> q;
+void SceneSandbox::ApplyPath(GameObject* go, MazePt start, std::vector<MazePt>& path)
+{
+	go->path.swap(path);
+	m_units.StartPath(go);
+	Vector3 pos = m_units.GetPos(go);
+	if (go->path.empty()) { m_units.SetTarget(go, pos); return; }
+	Vector3 center = Vector3(start.x * m_gridSize + m_gridOffset, start.y * m_gridSize + m_gridOffset, 0.f);
+	if ((pos - center).LengthSquared() > 0.05f) go->path.insert(go->path.begin(), start); // off-centre (or since moved on): back to where the path begins
+}
 
-	q.push(start);
-	visited[Get1DIndex(start.x, start.y)] = true;
+// Removed collision logic
+void SceneSandbox::SetFoodCell(int index, bool occupied)
+{
+	int gridX = index % m_noGrid, gridY = index / m_noGrid;
+	if (m_foodGrid.Get(gridX, gridY) == occupied) return;
+	m_foodGrid.Set(gridX, gridY, occupied);
+	m_blockedGrid.Set(gridX, gridY, occupied || m_wallGrid.Get(gridX, gridY));
+	OnObstacleChanged(index);
+}
 
-	bool found = false;
-	int dx[] = { 0, 0, -1, 1 }; int dy[] = { 1, -1, 0, 0 };
+bool SceneSandbox::SetWallCell(int gridX, int gridY, bool wall)
+{
+	if (!IsWithinBoundary(gridX) || !IsWithinBoundary(gridY)) return false;
+	int index = Get1DIndex(gridX, gridY);
+	if (m_foodGrid.Get(gridX, gridY)) return false;
+	GameObject* queens[2] = { m_redQueen, m_blueQueen };
+	for (GameObject* queen : queens) { if (queen && (int)(m_units.posX[UnitStore::GetSlot(queen)] / m_gridSize) == gridX && (int)(m_units.posY[UnitStore::GetSlot(queen)] / m_gridSize) == gridY) return false; }
+	if (m_wallGrid.Get(gridX, gridY) != wall) { m_wallGrid.Set(gridX, gridY, wall); m_blockedGrid.Set(gridX, gridY, wall); OnObstacleChanged(index); }
+	return true;
+}
 
-	while (!q.empty())
-	{
-		MazePt curr = q.front(); q.pop();
-		if (curr.x == end.x && curr.y == end.y) { found = true; break; }
-		for (int i = 0; i < 4; ++i)
-		{
-			int nx = curr.x + dx[i]; int ny = curr.y + dy[i];
-			if (!IsGridOccupied(nx, ny)) // Use the updated check
-			{
-				int nIdx = Get1DIndex(nx, ny);
-				if (!visited[nIdx]) { visited[nIdx] = true; parent[nIdx] = Get1DIndex(curr.x, curr.y); q.push(MazePt(nx, ny)); }
-			}
-		}
-	}
-	// ... (reconstruct path) ...
-	if (found) { int currIdx = Get1DIndex(end.x, end.y); int startIdx = Get1DIndex(start.x, start.y); while (currIdx != startIdx) { path.push_back(MazePt(currIdx % m_noGrid, currIdx / m_noGrid)); currIdx = parent[currIdx]; } std::reverse(path.begin(), path.end()); }
-	return path;
+void SceneSandbox::OnObstacleChanged(int index)
+{
+	++m_obstacleVersion;
+	m_pathCache.SetObstacleVersion(m_obstacleVersion);
+	m_flowFields.UpdateCell(index); // repaired in place, not rebuilt
+	m_clusters.RepairCell(index % m_noGrid, index / m_noGrid);
 }
 
-// Removed collision logic
 bool SceneSandbox::IsGridOccupied(int gridX, int gridY)
 {
-	if (!IsWithinBoundary(gridX) || !IsWithinBoundary(gridY)) return true;
-	if (m_wallGrid[Get1DIndex(gridX, gridY)]) return true;
-	if (m_foodGrid[Get1DIndex(gridX, gridY)]) return true;
-	return false;
+	return m_blockedGrid.Get(gridX, gridY); // the grid's border counts as occupied
 }
 
 MazePt SceneSandbox::GetNearestVacantNeighbor(MazePt target, MazePt start)
@@ -337,24 +376,47 @@ MazePt SceneSandbox::GetNearestVacantNeighbor(MazePt target, MazePt start)
 
 void SceneSandbox::Update(double dt)
 {
-	SceneBase::Update(dt);
+	if (!m_headless)
+		SceneBase::Update(dt);
 
 	// Update world dimensions
 	m_worldHeight = 100.f;
 	m_worldWidth = m_worldHeight * (float)Application::GetWindowWidth() / Application::GetWindowHeight();
 
 	// Speed controls
-	if (Application::IsKeyPressed(VK_OEM_MINUS))
-	{
-		m_speed = Math::Max(0.f, m_speed - 0.1f);
-	}
-	if (Application::IsKeyPressed(VK_OEM_PLUS))
+	if (!m_headless)
 	{
-		m_speed += 0.1f;
-	}
-	if (Application::IsKeyPressed(VK_END))
-	{
-		m_simulationEnded = true;
+		if (Application::IsKeyPressed(VK_OEM_MINUS))
+		{
+			m_speed = Math::Max(0.f, m_speed - 0.1f);
+		}
+		if (Application::IsKeyPressed(VK_OEM_PLUS))
+		{
+			m_speed += 0.1f;
+		}
+		if (Application::IsKeyPressed(VK_END))
+		{
+			m_simulationEnded = true;
+		}
+
+		// Left click adds or removes a wall
+		static bool bLButtonState = false;
+		if (!bLButtonState && Application::IsMousePressed(0))
+		{
+			bLButtonState = true;
+			double x, y;
+			Application::GetCursorPos(&x, &y);
+			int w = Application::GetWindowWidth();
+			int h = Application::GetWindowHeight();
+			float posX = static_cast<float>(x) / w * m_worldWidth;
+			float posY = (h - static_cast<float>(y)) / h * m_worldHeight;
+			int gridX = static_cast<int>(posX / m_gridSize); int gridY = static_cast<int>(posY / m_gridSize);
+			if (IsWithinBoundary(gridX) && IsWithinBoundary(gridY)) SetWallCell(gridX, gridY, !m_wallGrid.Get(gridX, gridY));
+		}
+		else if (bLButtonState && !Application::IsMousePressed(0))
+		{
+			bLButtonState = false;
+		}
 	}
 
 	
@@ -381,114 +443,139 @@ void SceneSandbox::Update(double dt)
 			m_coloniesDetected = true;
 		}
 
-		// State machine updates
-		for (size_t i = 0; i < m_goList.size(); ++i) {
-			GameObject* go = m_goList[i];
-			if (go->active && go->sm) go->sm->Update(dt * m_speed);
-		}
+		m_pheromones[0].Evaporate(static_cast<float>(dt) * m_speed);
+		m_pheromones[1].Evaporate(static_cast<float>(dt) * m_speed);
+
+		// Objects released last frame leave the active list (and become reusable) only now
+		m_pool.Flush();
+		if (m_headless) m_inactiveAfterFlush = Math::Max(m_inactiveAfterFlush, m_pool.CountInactive());
+		const std::vector<GameObject*>& activeList = m_pool.GetActive(); // index it: spawning appends
 
-		for (int i = 0; i < m_foodGrid.size(); ++i) m_foodGrid[i] = false;
-		for (auto go : m_goList) { if (go->active && go->type == GameObject::GO_FOOD) { int gx = (int)(go->pos.x / m_gridSize); int gy = (int)(go->pos.y / m_gridSize); m_foodGrid[Get1DIndex(gx, gy)] = true; } }
+		// State machine updates
+		UpdateStateMachines(dt * m_speed);
 
-		for (size_t i = 0; i < m_goList.size(); ++i) { if (m_goList[i]->active && m_goList[i]->sm) m_goList[i]->sm->Update(dt * m_speed); }
+		UpdateStateMachines(dt * m_speed);
 
-		int cycleCheck = 0;
-		for (size_t i = 0; i < m_goList.size(); ++i) {
-			GameObject* go = m_goList[i];
-			if (go->active && (cycleCheck % 3) == m_updateCycle) {
-				DetectNearbyEntities(go);
+		// Sensing: a unit only writes its own targets and reads nothing written here, so units can go to any thread
+		m_spatialGrid.SyncEntries();
+		m_foodIndex.Prune();
+		m_jobs.ParallelFor(static_cast<int>(activeList.size()), 64, [this, &activeList](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				GameObject* go = activeList[i];
+				if (go->active && (i % 3) == m_updateCycle) {
+					DetectNearbyEntities(go);
 
-				// --- FIX: RESTRICTED UPDATE LOGIC ---
-				if (go->type == GameObject::GO_WORKER && !go->isCarryingResource) // Workers only search if NOT carrying
-					FindNearestResource(go);
+					// --- FIX: RESTRICTED UPDATE LOGIC ---
+					if (go->type == GameObject::GO_WORKER && !go->isCarryingResource) // Workers only search if NOT carrying
+						FindNearestResource(go);
 
-				if (go->type == GameObject::GO_HEALER)
-					FindNearestInjuredAlly(go);
+					if (go->type == GameObject::GO_HEALER)
+						FindNearestInjuredAlly(go);
 
-				if (go->type == GameObject::GO_SCOUT && go->targetFoodItem == nullptr) // Scout only searches if IDLE/PATROL
-					FindNearestResource(go);
-				// ------------------------------------
+					if (go->type == GameObject::GO_SCOUT && go->targetFoodItem == nullptr) // Scout only searches if IDLE/PATROL
+						FindNearestResource(go);
+					// ------------------------------------
+				}
 			}
-			cycleCheck++;
-		}
+		});
 		//Movement
-		for (size_t i = 0; i < m_goList.size(); ++i) {
-			GameObject* go = m_goList[i];
+		// paths asked for last frame: the unit walks back to the cell it asked from if it has since left its centre
+		m_pathResults.clear();
+		m_pathRequests.Process(m_jobs, m_pathResults);
+		for (size_t i = 0; i < m_pathResults.size(); ++i) {
+			GameObject* go = GameObjectRegistry::GetInstance()->Resolve(m_pathResults[i].owner);
+			if (go && go->active) ApplyPath(go, m_pathResults[i].start, m_pathResults[i].path);
+		}
+		// Stuck timers over the packed arrays, then each moving unit picks its next waypoint
+		m_jobs.ParallelFor(m_units.GetCount(), 4096, [this, dt](int begin, int end) { m_units.UpdateIdle(begin, end, static_cast<float>(dt) * m_speed, 3.0f); });
+		m_trailWalkers.clear();
+		for (size_t i = 0; i < activeList.size(); ++i) {
+			GameObject* go = activeList[i];
 			if (!go->active) continue;
-			if (go->type == GameObject::GO_PHEROMONE) { if (go->targetFoodItem == nullptr || !go->targetFoodItem->active || go->targetFoodItem->resourceCount <= 0) go->active = false; continue; }
-			if (go->moveSpeed <= 0.f) continue;
-
-			if ((go->pos - go->prevPos).LengthSquared() < 0.001f) {
-				go->idleTimer += (float)dt * m_speed;
-				if (go->idleTimer > 3.0f) { // Stuck for 3s? Go home.
-					go->idleTimer = 0.f;
-					go->target = go->homeBase;
-					go->path.clear();
-					// Clear targets to force reset
-					go->targetFoodItem = nullptr;
-					go->targetEnemy = nullptr;
-					go->isCarryingResource = false;
-				}
+			int unit = UnitStore::GetSlot(go);
+			if (m_units.speed[unit] <= 0.f) continue;
+
+			if (m_units.flags[unit] & UnitStore::FLAG_STUCK) { // Stuck for 3s? Go home.
+				m_units.SetTarget(go, go->homeBase);
+				go->path.clear();
+				m_units.StartPath(go);
+				// Clear targets to force reset
+				go->targetFoodItem = nullptr;
+				go->targetEnemy = nullptr;
+				go->isCarryingResource = false;
 			}
-			else {
-				go->idleTimer = 0.f;
-			}
-			go->prevPos = go->pos;
 
-			int gridX = static_cast<int>(go->pos.x / m_gridSize); int gridY = static_cast<int>(go->pos.y / m_gridSize);
-			MazePt targetPt(static_cast<int>(go->target.x / m_gridSize), static_cast<int>(go->target.y / m_gridSize));
+			int gridX = static_cast<int>(m_units.posX[unit] / m_gridSize); int gridY = static_cast<int>(m_units.posY[unit] / m_gridSize);
+			MazePt targetPt(static_cast<int>(m_units.targetX[unit] / m_gridSize), static_cast<int>(m_units.targetY[unit] / m_gridSize));
+
+			// Queens and food sources have shared flow fields, other targets get their own path
+			int flowGoal = -1;
+			if (targetPt.x == static_cast<int>(go->homeBase.x / m_gridSize) && targetPt.y == static_cast<int>(go->homeBase.y / m_gridSize)) flowGoal = Get1DIndex(targetPt.x, targetPt.y);
 
 			// Auto-Adjust Target to Neighbor if Food
-			if (go->targetFoodItem != nullptr && go->targetFoodItem->active) {
+			GameObject* targetFood = go->targetFoodItem; // resolve the handle once
+			if (targetFood != nullptr && targetFood->active) {
 				// If it's a worker collecting OR a scout marking
 				bool shouldSnap = false;
+				Vector3 foodPos = m_units.GetPos(targetFood);
 				if (go->type == GameObject::GO_WORKER && !go->isCarryingResource) shouldSnap = true;
 				if (go->type == GameObject::GO_SCOUT) {
 					// Only snap if we are "close" to it (meaning FSM wants to go there)
-					if ((go->target - go->targetFoodItem->pos).LengthSquared() < (m_gridSize * 5) * (m_gridSize * 5)) shouldSnap = true;
+					if ((m_units.GetTarget(go) - foodPos).LengthSquared() < (m_gridSize * 5) * (m_gridSize * 5)) shouldSnap = true;
 				}
 
 				if (shouldSnap) {
-					targetPt = GetNearestVacantNeighbor(MazePt((int)(go->targetFoodItem->pos.x / m_gridSize), (int)(go->targetFoodItem->pos.y / m_gridSize)), MazePt(gridX, gridY));
+					MazePt foodPt((int)(foodPos.x / m_gridSize), (int)(foodPos.y / m_gridSize));
+					targetPt = GetNearestVacantNeighbor(foodPt, MazePt(gridX, gridY));
+					flowGoal = Get1DIndex(foodPt.x, foodPt.y); // the food field ends on any open side
 				}
 			}
+			// the path still to walk is go->path from m_units.pathNext on
+			MazePt flowPt;
 			bool needPath = false;
-			if (go->path.empty()) { if (gridX != targetPt.x || gridY != targetPt.y) needPath = true; }
+			int next = m_units.pathNext[unit];
+			int left = static_cast<int>(go->path.size()) - next;
+			if (flowGoal >= 0 && m_flowFields.GetNextCell(flowGoal, MazePt(gridX, gridY), flowPt)) {
+				// one step at a time: keep heading for the cell we are in or the field's next cell, otherwise retarget
+				if (flowPt.x == gridX && flowPt.y == gridY) { go->path.clear(); m_units.StartPath(go); }
+				else if (left != 1 || ((go->path[next].x != gridX || go->path[next].y != gridY) && (go->path[next].x != flowPt.x || go->path[next].y != flowPt.y))) { go->path.assign(1, flowPt); m_units.StartPath(go); }
+			}
+			else if (left == 0) { if (gridX != targetPt.x || gridY != targetPt.y) needPath = true; }
 			else { MazePt last = go->path.back(); if (last.x != targetPt.x || last.y != targetPt.y) needPath = true; }
 
-			if (needPath) {
-				go->path = FindPath(MazePt(gridX, gridY), targetPt);
-				if (go->path.empty()) { go->target = go->pos; }
-				else { Vector3 center = Vector3(gridX * m_gridSize + m_gridOffset, gridY * m_gridSize + m_gridOffset, go->pos.z); if ((go->pos - center).LengthSquared() > 0.05f) { go->path.insert(go->path.begin(), MazePt(gridX, gridY)); } }
+			// a cached route applies at once, otherwise keep following the old path (or settle in this cell) until the search comes back
+			if (needPath && m_pathCache.Find(MazePt(gridX, gridY), targetPt, m_cachedPath)) { m_pathRequests.Cancel(go->handle); ApplyPath(go, MazePt(gridX, gridY), m_cachedPath); }
+			else if (needPath) {
+				int priority = (go->type == GameObject::GO_SOLDIER || go->type == GameObject::GO_TANK) ? 2 : left == 0 ? 1 : 0;
+				m_pathRequests.Submit(go->handle, MazePt(gridX, gridY), targetPt, priority);
 			}
+			else m_pathRequests.Cancel(go->handle);
 
-			float step = go->moveSpeed * static_cast<float>(dt) * m_speed;
-			Vector3 moveVec(0, 0, 0);
-			if (!go->path.empty()) {
-				MazePt nextPt = go->path.front();
-				Vector3 nextPos(nextPt.x * m_gridSize + m_gridOffset, nextPt.y * m_gridSize + m_gridOffset, go->pos.z);
-				Vector3 dir = nextPos - go->pos; float dist = dir.Length(); moveVec = dir;
-				if (dist <= step) {
-					go->pos = nextPos;
-					// --- FIX: RECORD PATH FOR WORKERS ---
-					if (go->type == GameObject::GO_WORKER && !go->isCarryingResource) {
-						// Only push if different from last
-						if (go->pathHistory.empty() || go->pathHistory.back().x != nextPt.x || go->pathHistory.back().y != nextPt.y) {
-							go->pathHistory.push_back(nextPt);
-						}
-					}
-					go->path.erase(go->path.begin());
-				}
-				else { go->pos += dir.Normalized() * step; }
+			// queue the step: next path point, or the centre of the current cell
+			if (m_units.HasPath(go)) {
+				MazePt nextPt = go->path[m_units.pathNext[unit]];
+				m_units.Queue(unit, nextPt.x * m_gridSize + m_gridOffset, nextPt.y * m_gridSize + m_gridOffset, true);
+				if (go->type == GameObject::GO_WORKER && !go->isCarryingResource) m_trailWalkers.push_back(go);
+			}
+			else m_units.Queue(unit, gridX * m_gridSize + m_gridOffset, gridY * m_gridSize + m_gridOffset, false);
+		}
+		// Step every queued unit in place over the packed arrays, moving the path cursors of those that reach a path point
+		m_jobs.ParallelFor(m_units.GetCount(), 4096, [this, dt](int begin, int end) { m_units.Integrate(begin, end, static_cast<float>(dt), m_speed); });
+		for (GameObject* go : m_trailWalkers) {
+			int unit = UnitStore::GetSlot(go);
+			if (!(m_units.flags[unit] & UnitStore::FLAG_ARRIVED)) continue;
+			// --- FIX: RECORD PATH FOR WORKERS ---
+			MazePt reached = go->path[m_units.pathNext[unit] - 1];
+			// Only push if different from last
+			if (go->pathHistory.empty() || go->pathHistory.back().x != reached.x || go->pathHistory.back().y != reached.y) {
+				go->pathHistory.push_back(reached);
 			}
-			else { Vector3 center = Vector3(gridX * m_gridSize + m_gridOffset, gridY * m_gridSize + m_gridOffset, go->pos.z); if ((go->pos - center).LengthSquared() > 0.001f) { Vector3 dir = center - go->pos; moveVec = dir; float dist = dir.Length(); if (dist <= step) go->pos = center; else go->pos += dir.Normalized() * step; } }
-			if (moveVec.LengthSquared() > 0.001f) go->viewDir = moveVec.Normalized();
 		}
 
 		// Update counts
 		m_redWorkerCount = 0; m_redSoldierCount = 0; m_redHealerCount = 0; m_redScoutCount = 0; m_redTankCount = 0;
 		m_blueWorkerCount = 0; m_blueSoldierCount = 0; m_blueHealerCount = 0; m_blueScoutCount = 0; m_blueTankCount = 0;
-		for (auto go : m_goList) {
+		for (auto go : activeList) {
 			if (!go->active) continue;
 			if (go->teamID == 0) {
 				if (go->type == GameObject::GO_WORKER) m_redWorkerCount++;
@@ -510,107 +597,82 @@ void SceneSandbox::Update(double dt)
 	
 }
 
-void SceneSandbox::DetectNearbyEntities(GameObject* go)
+void SceneSandbox::UpdateStateMachines(double dt)
 {
-	if (go->type == GameObject::GO_FOOD ||
-		go->type == GameObject::GO_QUEEN ||
-		go->type == GameObject::GO_STRONG_ANT_QUEEN)
+	const std::vector<GameObject*>& activeList = m_pool.GetActive(); // index it: spawning appends
+	if (!m_bufferedAI) {
+		for (size_t i = 0; i < activeList.size(); ++i) { GameObject* go = activeList[i]; if (go->active && go->sm) go->sm->Update(dt); }
+		if (m_deferredMessages) PostOffice::GetInstance()->DeliverDeferred();
 		return;
+	}
 
-	go->targetEnemy = nullptr;
-	float nearestEnemyDistSq = FLT_MAX;
-
-	// Use spatial grid for optimization
-	int gridX = static_cast<int>(go->pos.x / m_gridSize);
-	int gridY = static_cast<int>(go->pos.y / m_gridSize);
+	// Buffered: states read the world as it was before the phase and record their other writes,
+	// one buffer per fixed-size chunk so resolving chunk by chunk replays them in unit order on any thread count
+	const int grain = 64;
+	int count = static_cast<int>(activeList.size());
+	int chunks = (count + grain - 1) / grain;
+	if (static_cast<int>(m_commandBuffers.size()) < chunks) m_commandBuffers.resize(chunks);
+	unsigned seed = m_seed * 0x9E3779B1u + (++m_aiPhase);
+	m_jobs.ParallelFor(count, grain, [this, &activeList, dt, seed](int begin, int end) {
+		CommandBuffer& buffer = m_commandBuffers[begin / grain];
+		CommandBuffer::Bind(&buffer);
+		for (int i = begin; i < end; ++i) {
+			GameObject* go = activeList[i];
+			if (!go->active || !go->sm) continue;
+			buffer.BeginUnit(go, seed);
+			go->sm->Update(dt);
+		}
+		CommandBuffer::Bind(nullptr);
+	});
+	for (int c = 0; c < chunks; ++c) m_commandBuffers[c].Resolve();
+	if (m_deferredMessages) PostOffice::GetInstance()->DeliverDeferred();
+}
 
-	// Check nearby cells only
-	for (int dy = -2; dy <= 2; ++dy)
-	{
-		for (int dx = -2; dx <= 2; ++dx)
-		{
-			int checkX = gridX + dx;
-			int checkY = gridY + dy;
-			if (checkX < 0 || checkX >= m_noGrid || checkY < 0 || checkY >= m_noGrid)
-				continue;
+void SceneSandbox::SetBufferedAI(bool buffered)
+{
+	m_bufferedAI = buffered;
+}
 
-			int cellKey = checkY * m_noGrid + checkX;
-			if (m_spatialGrid.find(cellKey) == m_spatialGrid.end())
-				continue;
+void SceneSandbox::SetDeferredMessages(bool deferred)
+{
+	m_deferredMessages = deferred;
+}
 
-			for (GameObject* other : m_spatialGrid[cellKey])
-			{
-				if (!other->active || other == go)
-					continue;
+void SceneSandbox::DetectNearbyEntities(GameObject* go)
+{
+	if (go->type == GameObject::GO_FOOD ||
+		go->type == GameObject::GO_QUEEN ||
+		go->type == GameObject::GO_STRONG_ANT_QUEEN)
+		return;
 
-				// Check if enemy
-				if (other->teamID != go->teamID && other->teamID >= 0 && go->teamID >= 0)
-				{
-					// Skip food
-					if (other->type == GameObject::GO_FOOD)
-						continue;
-
-					float distSq = (go->pos - other->pos).LengthSquared();
-					float detectionRangeSq = go->detectionRange * go->detectionRange;
-
-					if (distSq < detectionRangeSq && distSq < nearestEnemyDistSq)
-					{
-						nearestEnemyDistSq = distSq;
-						go->targetEnemy = other;
-
-						// Queens detect threats
-						if (go->type == GameObject::GO_QUEEN && other->teamID == 1)
-						{
-							go->targetEnemy = other;
-						}
-						else if (go->type == GameObject::GO_STRONG_ANT_QUEEN && other->teamID == 0)
-						{
-							go->targetEnemy = other;
-						}
-					}
-				}
-			}
-		}
-	}
+	// nearest enemy among the units in the 5x5 cells around go (queens included)
+	go->targetEnemy = m_spatialGrid.FindNearestEnemy(go, go->detectionRange * go->detectionRange, 2);
 }
 
 void SceneSandbox::FindNearestResource(GameObject* go)
 {
 	go->targetResource.SetZero();
 	go->targetFoodItem = nullptr;
-	float nearestDistSq = FLT_MAX;
 
-	// 1. Look for FOOD (Global search for simplicity, or restricted if needed)
-	for (auto it = m_goList.begin(); it != m_goList.end(); ++it) {
-		GameObject* res = (GameObject*)*it;
-		if (!res->active || res->type != GameObject::GO_FOOD) continue;
-		if (res->harvesterCount >= 5 || res->resourceCount <= 0) continue;
-		if (go->type == GameObject::GO_SCOUT && res->isMarked) continue; // Scouts ignore marked
-
-		float distSq = (go->pos - res->pos).LengthSquared();
-		if (distSq < nearestDistSq) { nearestDistSq = distSq; go->targetResource = res->pos; go->targetFoodItem = res; }
-	}
-
-	// 2. If Worker has NO food, look for NEARBY PHEROMONES
-	if (go->type == GameObject::GO_WORKER && go->targetFoodItem == nullptr) {
-		nearestDistSq = go->detectionRange * go->detectionRange; // --- FIX: Limit to Detection Range ---
-
-		for (auto it = m_goList.begin(); it != m_goList.end(); ++it) {
-			GameObject* trail = (GameObject*)*it;
-			if (!trail->active || trail->type != GameObject::GO_PHEROMONE) continue;
-			if (trail->teamID != go->teamID) continue;
+	// 1. Look for FOOD (nearest over the whole map, via the food index)
+	GameObject* food = m_foodIndex.FindNearest(m_units.GetPos(go), FLT_MAX, [go](const GameObject* res) {
+		if (res->harvesterCount >= 5 || res->resourceCount <= 0) return false;
+		if (go->type == GameObject::GO_SCOUT && res->isMarked) return false; // Scouts ignore marked
+		return true;
+		});
+	if (food) { go->targetResource = m_units.GetPos(food); go->targetFoodItem = food; }
 
+	// 2. If Worker has NO food, look for NEARBY PHEROMONES of its own team
+	if (go->type == GameObject::GO_WORKER && go->targetFoodItem == nullptr && (go->teamID == 0 || go->teamID == 1)) {
+		// --- FIX: Limit to Detection Range ---
+		int trailFood = m_pheromones[go->teamID].FindNearest(m_units.GetPos(go), go->detectionRange, [this](int foodId) {
 			// Check if trail is valid
-			if (trail->targetFoodItem == nullptr || !trail->targetFoodItem->active || trail->targetFoodItem->resourceCount <= 0) continue;
-
-			float distSq = (go->pos - trail->pos).LengthSquared();
-			// If nearby trail found
-			if (distSq < nearestDistSq) {
-				nearestDistSq = distSq;
-				// Set target to FOOD (Worker knows where it is now)
-				go->targetFoodItem = trail->targetFoodItem;
-				go->targetResource = trail->targetFoodItem->pos;
-			}
+			return GetTrailFood(foodId) != nullptr;
+			});
+		if (trailFood >= 0) {
+			// Set target to FOOD (Worker knows where it is now)
+			go->targetFoodItem = m_foodItems[trailFood];
+			go->targetResource = m_units.GetPos(go->targetFoodItem);
 		}
 	}
 }
@@ -621,12 +683,13 @@ void SceneSandbox::FindNearestInjuredAlly(GameObject* go)
 	float nearestDistSq = FLT_MAX;
 	GameObject* nearestSoldier = nullptr; // Fallback target
 	float nearestSoldierDist = FLT_MAX;
+	Vector3 pos = m_units.GetPos(go);
 
-	for (GameObject* other : m_goList) {
+	for (GameObject* other : m_pool.GetActive()) {
 		if (!other->active || other == go) continue;
 		if (other->teamID != go->teamID) continue;
 
-		float distSq = (go->pos - other->pos).LengthSquared();
+		float distSq = (pos - m_units.GetPos(other)).LengthSquared();
 
 		// Priority 1: Injured Unit (Any type except Queen/Egg ideally, but here all)
 		if (other->health < other->maxHealth) {
@@ -653,36 +716,14 @@ void SceneSandbox::FindNearestInjuredAlly(GameObject* go)
 
 bool SceneSandbox::IsInTerritory(Vector3 pos, int teamID) const
 {
-	float halfGrid = m_noGrid * 0.5f;
-
-	if (teamID == 0) // Speedy Ant territory (bottom-left)
-	{
-		return pos.x < halfGrid * m_gridSize && pos.y < halfGrid * m_gridSize;
-	}
-	else if (teamID == 1) // Strong Ant territory (top-right)
-	{
-		return pos.x > halfGrid * m_gridSize && pos.y > halfGrid * m_gridSize;
-	}
-
-	return false;
+	if (teamID != 0 && teamID != 1)
+		return false;
+	return m_map.IsInTerritory(static_cast<int>(pos.x / m_gridSize), static_cast<int>(pos.y / m_gridSize), teamID);
 }
 
 void SceneSandbox::UpdateSpatialGrid()
 {
-	m_spatialGrid.clear();
-
-	for (std::vector<GameObject*>::iterator it = m_goList.begin(); it != m_goList.end(); ++it)
-	{
-		GameObject* go = (GameObject*)*it;
-		if (!go->active)
-			continue;
-
-		int gridX = static_cast<int>(go->pos.x / m_gridSize);
-		int gridY = static_cast<int>(go->pos.y / m_gridSize);
-		int cellKey = gridY * m_noGrid + gridX;
-
-		m_spatialGrid[cellKey].push_back(go);
-	}
+	m_spatialGrid.Update(m_pool.GetActive());
 }
 
 GameObject* SceneSandbox::GetNearestEnemy(Vector3 pos, int teamID, float maxRange)
@@ -690,13 +731,13 @@ GameObject* SceneSandbox::GetNearestEnemy(Vector3 pos, int teamID, float maxRang
 	GameObject* nearest = nullptr;
 	float nearestDistSq = maxRange * maxRange;
 
-	for (std::vector<GameObject*>::iterator it = m_goList.begin(); it != m_goList.end(); ++it)
+	for (std::vector<GameObject*>::const_iterator it = m_pool.GetActive().begin(); it != m_pool.GetActive().end(); ++it)
 	{
 		GameObject* go = (GameObject*)*it;
 		if (!go->active || go->teamID == teamID || go->type == GameObject::GO_FOOD)
 			continue;
 
-		float distSq = (pos - go->pos).LengthSquared();
+		float distSq = (pos - m_units.GetPos(go)).LengthSquared();
 		if (distSq < nearestDistSq)
 		{
 			nearestDistSq = distSq;
@@ -707,6 +748,78 @@ GameObject* SceneSandbox::GetNearestEnemy(Vector3 pos, int teamID, float maxRang
 	return nearest;
 }
 
+void SceneSandbox::SetHeadless(bool headless, unsigned seed)
+{
+	m_headless = headless;
+	m_seed = seed;
+}
+
+void SceneSandbox::SetJobThreads(int threads)
+{
+	m_jobThreads = threads;
+}
+
+void SceneSandbox::SetMap(int gridSize, const std::string& file)
+{
+	m_mapSize = gridSize;
+	m_mapFile = file;
+}
+
+void SceneSandbox::SetPoolReserve(int perUnitType)
+{
+	m_poolReserve = perUnitType;
+}
+
+const FlowFieldCache& SceneSandbox::GetFlowFields() const
+{
+	return m_flowFields;
+}
+
+int SceneSandbox::GetExploredCells(int teamID) const
+{
+	return GetExploredCellCount(teamID);
+}
+
+int SceneSandbox::GetOpenCells() const
+{
+	return m_noGrid * m_noGrid - m_blockedGrid.Count();
+}
+
+const PathCache& SceneSandbox::GetPathCache() const
+{
+	return m_pathCache;
+}
+
+const PathRequestQueue& SceneSandbox::GetPathRequests() const
+{
+	return m_pathRequests;
+}
+
+const GameObjectPool& SceneSandbox::GetPool() const
+{
+	return m_pool;
+}
+
+int SceneSandbox::GetInactiveAfterFlush() const
+{
+	return m_inactiveAfterFlush;
+}
+
+bool SceneSandbox::IsSimulationEnded() const
+{
+	return m_simulationEnded;
+}
+
+int SceneSandbox::GetWinner() const
+{
+	return m_winner;
+}
+
+float SceneSandbox::GetSimulationTime() const
+{
+	return m_simulationTime;
+}
+
 int SceneSandbox::IsWithinBoundary(int x) const
 {
 	return x >= 0 && x < m_noGrid;
@@ -718,107 +831,122 @@ int SceneSandbox::Get1DIndex(int x, int y) const
 }
 
 bool SceneSandbox::Handle(Message* message) {
-	MessageSpawnUnit* msgSpawn = dynamic_cast<MessageSpawnUnit*>(message);
-	if (msgSpawn) {
-		if (msgSpawn->type == MessageSpawnUnit::UNIT_PHEROMONE) {
-			bool exists = false;
-			int gx = (int)(msgSpawn->position.x / m_gridSize); int gy = (int)(msgSpawn->position.y / m_gridSize);
-			for (auto go : m_goList) { if (go->active && go->type == GameObject::GO_PHEROMONE) { int pgx = (int)(go->pos.x / m_gridSize); int pgy = (int)(go->pos.y / m_gridSize); if (gx == pgx && gy == pgy) { exists = true; break; } } }
-			if (!exists) { SpawnUnit(msgSpawn->type, msgSpawn->position, msgSpawn->spawner->teamID); for (int i = m_goList.size() - 1; i >= 0; --i) { GameObject* go = m_goList[i]; if (go->active && go->type == GameObject::GO_PHEROMONE && (go->pos - msgSpawn->position).LengthSquared() < 1.0f) { go->targetFoodItem = msgSpawn->spawner->targetFoodItem; break; } } }
-			return true;
-		}
-
-		// --- NEW: COST & LIMITS ---
-		int cost = 0;
-		int currentCount = 0;
-		int limit = 100; // Default no limit
-
-		switch (msgSpawn->type) {
-		case MessageSpawnUnit::UNIT_SPEEDY_ANT_WORKER:
-		case MessageSpawnUnit::UNIT_STRONG_ANT_WORKER:
-			cost = 3;
-			limit = 10;
-			currentCount = (msgSpawn->spawner->teamID == 0) ? m_redWorkerCount : m_blueWorkerCount;
-			break;
-		case MessageSpawnUnit::UNIT_SCOUT:
-			cost = 4;
-			limit = 2;
-			currentCount = (msgSpawn->spawner->teamID == 0) ? m_redScoutCount : m_blueScoutCount;
-			break;
-		case MessageSpawnUnit::UNIT_SPEEDY_ANT_SOLDIER:
-		case MessageSpawnUnit::UNIT_STRONG_ANT_SOLDIER:
-			cost = 5;
-			limit = 15;
-			currentCount = (msgSpawn->spawner->teamID == 0) ? m_redSoldierCount : m_blueSoldierCount;
-			break;
-		case MessageSpawnUnit::UNIT_HEALER:
-			cost = 8;
-			limit = 5;
-			currentCount = (msgSpawn->spawner->teamID == 0) ? m_redHealerCount : m_blueHealerCount;
-			break;
-		case MessageSpawnUnit::UNIT_TANK:
-			cost = 10;
-			limit = 5;
-			currentCount = (msgSpawn->spawner->teamID == 0) ? m_redTankCount : m_blueTankCount;
-			break;
-		}
-
-		if (currentCount >= limit) return true; // Reached limit
+	return m_dispatcher.Dispatch(this, message, true);
+}
 
-		if (msgSpawn->spawner->teamID == 0) { if (m_redResources >= cost) { m_redResources -= cost; SpawnUnit(msgSpawn->type, msgSpawn->position, 0); } }
-		else { if (m_blueResources >= cost) { m_blueResources -= cost; SpawnUnit(msgSpawn->type, msgSpawn->position, 1); } }
-		return true;
-		// --------------------------
-	}
-	MessageResourceDelivered* msgRes = dynamic_cast<MessageResourceDelivered*>(message); if (msgRes) { if (msgRes->teamID == 0) m_redResources += msgRes->resourceAmount; else m_blueResources += msgRes->resourceAmount; return true; }
-
-	// --- FIX: REDUCED PANIC RADIUS ---
-	MessageEnemySpotted* msgEnemy = dynamic_cast<MessageEnemySpotted*>(message);
-	if (msgEnemy) {
-		m_coloniesDetected = true;
-		for (size_t i = 0; i < m_goList.size(); ++i) {
-			GameObject* go = m_goList[i];
-			if (!go->active || go->teamID != msgEnemy->teamID) continue;
-			// Radius 4 grids (4*4*GridSize^2 = 16*GridSize^2)
-			if ((go->type == GameObject::GO_SOLDIER || go->type == GameObject::GO_STRONG_ANT_SOLDIER) && (go->pos - msgEnemy->enemy->pos).LengthSquared() < m_gridSize * m_gridSize * 16.f) { go->targetEnemy = msgEnemy->enemy; }
-		}
+bool SceneSandbox::OnSpawnUnit(MessageSpawnUnit* msgSpawn) {
+	if (msgSpawn->type == MessageSpawnUnit::UNIT_PHEROMONE) {
+		int team = msgSpawn->spawner->teamID;
+		GameObject* food = msgSpawn->spawner->targetFoodItem;
+		int foodId = GetFoodId(food);
+		if ((team == 0 || team == 1) && GetTrailFood(foodId))
+			m_pheromones[team].Deposit((int)(msgSpawn->position.x / m_gridSize), (int)(msgSpawn->position.y / m_gridSize), foodId);
 		return true;
 	}
-	MessageRequestHelp* msgHelp = dynamic_cast<MessageRequestHelp*>(message);
-	if (msgHelp) {
-		for (size_t i = 0; i < m_goList.size(); ++i) {
-			GameObject* go = m_goList[i];
-			if (!go->active || go->teamID != msgHelp->teamID) continue;
-			// Radius 4 grids
-			if ((go->type == GameObject::GO_SOLDIER || go->type == GameObject::GO_STRONG_ANT_SOLDIER) && (go->pos - msgHelp->position).LengthSquared() < m_gridSize * m_gridSize * 16.f) { go->target = msgHelp->position; }
-		}
-		return true;
+
+	// --- NEW: COST & LIMITS ---
+	int cost = 0;
+	int currentCount = 0;
+	int limit = 100; // Default no limit
+
+	switch (msgSpawn->type) {
+	case MessageSpawnUnit::UNIT_SPEEDY_ANT_WORKER:
+	case MessageSpawnUnit::UNIT_STRONG_ANT_WORKER:
+		cost = 3;
+		limit = 10;
+		currentCount = (msgSpawn->spawner->teamID == 0) ? m_redWorkerCount : m_blueWorkerCount;
+		break;
+	case MessageSpawnUnit::UNIT_SCOUT:
+		cost = 4;
+		limit = 2;
+		currentCount = (msgSpawn->spawner->teamID == 0) ? m_redScoutCount : m_blueScoutCount;
+		break;
+	case MessageSpawnUnit::UNIT_SPEEDY_ANT_SOLDIER:
+	case MessageSpawnUnit::UNIT_STRONG_ANT_SOLDIER:
+		cost = 5;
+		limit = 15;
+		currentCount = (msgSpawn->spawner->teamID == 0) ? m_redSoldierCount : m_blueSoldierCount;
+		break;
+	case MessageSpawnUnit::UNIT_HEALER:
+		cost = 8;
+		limit = 5;
+		currentCount = (msgSpawn->spawner->teamID == 0) ? m_redHealerCount : m_blueHealerCount;
+		break;
+	case MessageSpawnUnit::UNIT_TANK:
+		cost = 10;
+		limit = 5;
+		currentCount = (msgSpawn->spawner->teamID == 0) ? m_redTankCount : m_blueTankCount;
+		break;
 	}
-	// ---------------------------------
 
+	if (currentCount >= limit) return true; // Reached limit
+
+	if (msgSpawn->spawner->teamID == 0) { if (m_redResources >= cost) { m_redResources -= cost; SpawnUnit(msgSpawn->type, msgSpawn->position, 0); } }
+	else { if (m_blueResources >= cost) { m_blueResources -= cost; SpawnUnit(msgSpawn->type, msgSpawn->position, 1); } }
+	return true;
+}
+
+bool SceneSandbox::OnResourceDepleted(MessageResourceDepleted* msgDepleted) {
+	m_pool.Release(msgDepleted->food);
+	m_foodIndex.Remove(msgDepleted->food);
+	Vector3 foodPos = m_units.GetPos(msgDepleted->food);
+	int foodCell = Get1DIndex((int)(foodPos.x / m_gridSize), (int)(foodPos.y / m_gridSize));
+	m_flowFields.Remove(foodCell);
+	SetFoodCell(foodCell, false);
+	int foodId = GetFoodId(msgDepleted->food);
+	m_pheromones[0].ClearFood(foodId); m_pheromones[1].ClearFood(foodId);
+	return true;
+}
+
+bool SceneSandbox::OnUnitDied(MessageUnitDied* msgDied) {
+	GameObject* unit = msgDied->unit;
+	if (!unit) return true;
+	if (unit->type == GameObject::GO_SOLDIER || unit->type == GameObject::GO_TANK) PostOffice::GetInstance()->Unsubscribe(GetTeamAlertChannel(unit->teamID), unit);
+	m_pool.Release(unit);
+	return true;
+}
+bool SceneSandbox::OnResourceDelivered(MessageResourceDelivered* msgRes) { if (msgRes->teamID == 0) m_redResources += msgRes->resourceAmount; else m_blueResources += msgRes->resourceAmount; return true; }
+
+// --- FIX: REDUCED PANIC RADIUS ---
+bool SceneSandbox::OnEnemySpotted(MessageEnemySpotted* msgEnemy) {
+	m_coloniesDetected = true;
+	if (!msgEnemy->enemy) return true;
+	// Passed on to the team's soldiers within 4 grids of the enemy, who take it as their target
+	RadiusAddress area = { m_units.GetPos(msgEnemy->enemy), m_gridSize * 4.f, msgEnemy->teamID, (1u << GameObject::GO_SOLDIER) | (1u << GameObject::GO_STRONG_ANT_SOLDIER) };
+	PostOffice::GetInstance()->SendRadius(area, msgEnemy);
+	return true;
+}
+
+bool SceneSandbox::OnRequestHelp(MessageRequestHelp* msgHelp) {
+	// Passed on to the team's soldiers within 4 grids, who head for the caller
+	RadiusAddress area = { msgHelp->position, m_gridSize * 4.f, msgHelp->teamID, (1u << GameObject::GO_SOLDIER) | (1u << GameObject::GO_STRONG_ANT_SOLDIER) };
+	PostOffice::GetInstance()->SendRadius(area, msgHelp);
 	return true;
 }
 
+void SceneSandbox::FindReceivers(const RadiusAddress& area, std::vector<ObjectBase*>& receivers) {
+	// One cell of slack: a unit can have crossed into the next cell since the grid last re-bucketed it
+	int radius = static_cast<int>(std::ceil(area.radius / m_gridSize)) + 1;
+	m_areaHits.clear();
+	m_spatialGrid.FindInRadius(area.centre, area.radius * area.radius, radius, m_areaHits);
+	for (GameObject* go : m_areaHits) {
+		if (!go->active || (area.teamID >= 0 && go->teamID != area.teamID)) continue;
+		if (area.typeMask && !(area.typeMask & (1u << go->type))) continue;
+		receivers.push_back(go);
+	}
+}
+
 void SceneSandbox::RenderGO(GameObject* go)
 {
 	// 1. Move to Object Position
 	modelStack.PushMatrix();
-	modelStack.Translate(go->pos.x, go->pos.y, 0.1f);
-
-	// Render PHEROMONE
-	if (go->type == GameObject::GO_PHEROMONE) {
-		modelStack.Scale(go->scale.x, go->scale.y, 1.f);
-		if (go->teamID == 0)
-			RenderMesh(meshList[GEO_TERRITORYRED], false);
-		else
-			RenderMesh(meshList[GEO_TERRITORYBLUE], false);
-		modelStack.PopMatrix();
-		return;
-	}
+	Vector3 pos = m_units.GetPos(go);
+	modelStack.Translate(pos.x, pos.y, 0.1f);
 
 	// 2. Render THE UNIT (with Rotation)
 	modelStack.PushMatrix();
-	float angle = Math::RadianToDegree(atan2(go->viewDir.y, go->viewDir.x));
+	Vector3 viewDir = m_units.GetViewDir(go);
+	float angle = Math::RadianToDegree(atan2(viewDir.y, viewDir.x));
 	modelStack.Rotate(angle - 90.0f, 0, 0, 1);
 	modelStack.Scale(go->scale.x, go->scale.y, go->scale.z);
 
@@ -887,6 +1015,37 @@ void SceneSandbox::RenderGO(GameObject* go)
 	modelStack.PopMatrix(); // End Object Position
 }
 
+void SceneSandbox::RenderPheromones()
+{
+	Mesh* mesh = meshList[GEO_PHEROMONE];
+	if (!mesh || m_pheromonePixels.empty()) return;
+
+	// Both teams share one texel per cell: colour by each team's share, opacity by the stronger trail
+	const std::vector<float>& red = m_pheromones[0].GetStrengths();
+	const std::vector<float>& blue = m_pheromones[1].GetStrengths();
+	for (size_t i = 0; i < red.size(); ++i)
+	{
+		unsigned char* texel = &m_pheromonePixels[i * 4];
+		float total = red[i] + blue[i];
+		if (total <= 0.f) { texel[3] = 0; continue; }
+		float redShare = red[i] / total;
+		texel[0] = static_cast<unsigned char>(255.f * (0.2f + 0.5f * redShare));
+		texel[1] = static_cast<unsigned char>(255.f * 0.2f);
+		texel[2] = static_cast<unsigned char>(255.f * (0.7f - 0.5f * redShare));
+		texel[3] = static_cast<unsigned char>(160.f * Math::Min(1.f, Math::Max(red[i], blue[i])));
+	}
+	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_noGrid, m_noGrid, GL_RGBA, GL_UNSIGNED_BYTE, &m_pheromonePixels[0]);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	float mapSize = m_noGrid * m_gridSize;
+	modelStack.PushMatrix();
+	modelStack.Translate(mapSize * 0.5f, mapSize * 0.5f, 0.05f);
+	modelStack.Scale(mapSize, mapSize, 1.f);
+	RenderMesh(mesh, false);
+	modelStack.PopMatrix();
+}
+
 void SceneSandbox::Render()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -917,7 +1076,7 @@ void SceneSandbox::Render()
 	{
 		for (int col = 0; col < m_noGrid; ++col)
 		{
-			if (m_wallGrid[Get1DIndex(col, row)])
+			if (m_wallGrid.Get(col, row))
 			{
 				modelStack.PushMatrix();
 				modelStack.Translate(col * m_gridSize + m_gridOffset, row * m_gridSize + m_gridOffset, 0.1f);
@@ -928,40 +1087,35 @@ void SceneSandbox::Render()
 		}
 	}
 
-	// Render territory markers
-	float territorySize = m_gridSize * 8.f;
-
-	// Speedy Ant Territory (Bottom-Left: 0 to 8)
-	// Center = 4.0 * gridSize
-	meshList[GEO_WHITEQUAD]->material.kAmbient.Set(0.8f, 0.2f, 0.2f); // RED
-	modelStack.PushMatrix();
-	modelStack.Translate(m_gridSize * 4.0f, m_gridSize * 4.0f, -0.8f);
-	modelStack.Scale(territorySize, territorySize, 1.f);
-	RenderMesh(meshList[GEO_TERRITORYRED], true);
-	modelStack.PopMatrix();
-
-	// Strong Ant Territory (Top-Right: 22 to 30)
-	// Center = 26.0 * gridSize
-	meshList[GEO_WHITEQUAD]->material.kAmbient.Set(0.2f, 0.2f, 0.8f); // BLUE
-	modelStack.PushMatrix();
-	modelStack.Translate(m_gridSize * 26.0f, m_gridSize * 26.0f, -0.8f);
-	modelStack.Scale(territorySize, territorySize, 1.f);
-	RenderMesh(meshList[GEO_TERRITORYBLUE], true);
-	modelStack.PopMatrix();
+	// Render territory markers, one quad over each colony's territory rectangle
+	for (int team = 0; team < 2; ++team)
+	{
+		const SandboxMap::Colony& colony = m_map.GetColony(team);
+		if (team == 0) meshList[GEO_WHITEQUAD]->material.kAmbient.Set(0.8f, 0.2f, 0.2f); // RED
+		else meshList[GEO_WHITEQUAD]->material.kAmbient.Set(0.2f, 0.2f, 0.8f); // BLUE
+		modelStack.PushMatrix();
+		modelStack.Translate(m_gridSize * (colony.x0 + colony.x1) * 0.5f, m_gridSize * (colony.y0 + colony.y1) * 0.5f, -0.8f);
+		modelStack.Scale(m_gridSize * (colony.x1 - colony.x0), m_gridSize * (colony.y1 - colony.y0), 1.f);
+		RenderMesh(meshList[team == 0 ? GEO_TERRITORYRED : GEO_TERRITORYBLUE], true);
+		modelStack.PopMatrix();
+	}
 
 	// Reset to White for other objects using this mesh
 	meshList[GEO_WHITEQUAD]->material.kAmbient.Set(1.f, 1.f, 1.f);
 
+	RenderPheromones();
+
 	// --- NEW: STACKING LOGIC ---
 	// Map: CellIndex -> GameObjectType -> Count
 	std::map<int, std::map<int, int>> cellCounts;
 
 	// Pass 1: Count objects per cell
-	for (auto go : m_goList)
+	for (auto go : m_pool.GetActive())
 	{
 		if (!go->active) continue;
-		int gx = (int)(go->pos.x / m_gridSize);
-		int gy = (int)(go->pos.y / m_gridSize);
+		Vector3 pos = m_units.GetPos(go);
+		int gx = (int)(pos.x / m_gridSize);
+		int gy = (int)(pos.y / m_gridSize);
 		// Safety clamp
 		if (gx < 0) gx = 0; if (gx >= m_noGrid) gx = m_noGrid - 1;
 		if (gy < 0) gy = 0; if (gy >= m_noGrid) gy = m_noGrid - 1;
@@ -971,13 +1125,14 @@ void SceneSandbox::Render()
 	}
 
 	// Pass 2: Render unique objects with counts
-	for (std::vector<GameObject*>::iterator it = m_goList.begin(); it != m_goList.end(); ++it)
+	for (std::vector<GameObject*>::const_iterator it = m_pool.GetActive().begin(); it != m_pool.GetActive().end(); ++it)
 	{
 		GameObject* go = (GameObject*)*it;
 		if (go->active)
 		{
-			int gx = (int)(go->pos.x / m_gridSize);
-			int gy = (int)(go->pos.y / m_gridSize);
+			Vector3 pos = m_units.GetPos(go);
+			int gx = (int)(pos.x / m_gridSize);
+			int gy = (int)(pos.y / m_gridSize);
 			if (gx < 0) gx = 0; if (gx >= m_noGrid) gx = m_noGrid - 1;
 			if (gy < 0) gy = 0; if (gy >= m_noGrid) gy = m_noGrid - 1;
 			int idx = gy * m_noGrid + gx;
@@ -998,7 +1153,7 @@ void SceneSandbox::Render()
 
 					modelStack.PushMatrix();
 					// Position text slightly offset from the unit center (top-right)
-					modelStack.Translate(go->pos.x + m_gridSize * 0.5f, go->pos.y + m_gridSize * 0.2f, 0.2f);
+					modelStack.Translate(pos.x + m_gridSize * 0.5f, pos.y + m_gridSize * 0.2f, 0.2f);
 					// Scale text appropriate to grid size
 					modelStack.Scale(m_gridSize*2.f, m_gridSize*2.f, 1.f);
 					RenderText(meshList[GEO_TEXT], ss.str(), Color(1, 1, 1)); // White text
@@ -1013,7 +1168,7 @@ void SceneSandbox::Render()
 	}
 
 	// Render all game objects
-	for (std::vector<GameObject*>::iterator it = m_goList.begin(); it != m_goList.end(); ++it)
+	for (std::vector<GameObject*>::const_iterator it = m_pool.GetActive().begin(); it != m_pool.GetActive().end(); ++it)
 	{
 		GameObject* go = (GameObject*)*it;
 		if (go->active)
@@ -1085,7 +1240,9 @@ void SceneSandbox::Render()
 }
 void SceneSandbox::Exit()
 {
-	SceneBase::Exit();
+	if (!m_headless)
+		SceneBase::Exit();
+	m_spatialGrid.Clear(); // before the objects it points at go
 	while (m_goList.size() > 0)
 	{
 		GameObject* go = m_goList.back();
@@ -1095,7 +1252,27 @@ void SceneSandbox::Exit()
 		m_goList.pop_back();
 	}
 
-	m_spatialGrid.clear();
+	m_pool.Clear();
+	SceneData::GetInstance()->SetUnits(nullptr);
+	m_units.Clear();
+	m_jobs.Shutdown();
+	m_foodIndex.Clear();
+	m_flowFields.Clear();
+	m_pathRequests.Clear();
+	m_pathCache.Clear();
+	m_pathRequests.SetClusterGraph(nullptr);
+	m_clusters.Clear();
+	m_pheromones[0].Clear();
+	m_pheromones[1].Clear();
+	m_foodItems.clear();
 	m_foodLocations.clear();
-	m_wallGrid.clear();
+	m_wallGrid = BitGrid();
+	m_foodGrid = BitGrid();
+	m_blockedGrid = BitGrid();
+	SceneData::GetInstance()->SetMap(nullptr);
+	PostOffice::GetInstance()->Unregister("Scene");
+	PostOffice::GetInstance()->Unregister(GetTeamAlertChannel(0));
+	PostOffice::GetInstance()->Unregister(GetTeamAlertChannel(1));
+	PostOffice::GetInstance()->ClearDeferred();
+	if (PostOffice::GetInstance()->GetLocator() == this) PostOffice::GetInstance()->SetLocator(nullptr);
 }
\ No newline at end of file
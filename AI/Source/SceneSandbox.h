@@ -5,7 +5,23 @@
 #include "SceneBase.h"
 #include "ObjectBase.h"
 #include "ConcreteMessages.h"
-class SceneSandbox : public SceneBase, public ObjectBase
+#include "MessageDispatcher.h"
+#include "PostOffice.h"
+#include "SpatialGrid.h"
+#include "ResourceIndex.h"
+#include "GridPathfinder.h"
+#include "FlowField.h"
+#include "PheromoneField.h"
+#include "GameObjectPool.h"
+#include "UnitStore.h"
+#include "JobSystem.h"
+#include "PathRequestQueue.h"
+#include "PathCache.h"
+#include "HierarchicalPathfinder.h"
+#include "CommandBuffer.h"
+#include "SandboxMap.h"
+#include <string>
+class SceneSandbox : public SceneBase, public ObjectBase, public ReceiverLocator
 {
 public:
 	SceneSandbox();
@@ -18,14 +34,36 @@ public:
 
 	void RenderGO(GameObject* go);
 	bool Handle(Message* message);
+	virtual void FindReceivers(const RadiusAddress& area, std::vector<ObjectBase*>& receivers); // units by team and GAMEOBJECT_TYPE bit, from m_spatialGrid
 
 	GameObject* FetchGO(GameObject::GAMEOBJECT_TYPE type);
 	void SpawnUnit(MessageSpawnUnit::UNIT_TYPE unitType, Vector3 position, int teamID);
 	std::vector<MazePt> FindPath(MazePt start, MazePt end);
+	bool SetWallCell(int gridX, int gridY, bool wall); // edit the map mid-match, false off the map, on a queen or on food
+
+	// Headless runner (no GL context, no keyboard, caller-supplied RNG seed)
+	void SetHeadless(bool headless, unsigned seed = 0);
+	void SetPoolReserve(int perUnitType); // objects allocated up front for each unit type
+	void SetJobThreads(int threads); // threads for the per-unit phases, 0 = one per core
+	void SetBufferedAI(bool buffered); // state machines run in parallel on last tick's world, see CommandBuffer
+	void SetDeferredMessages(bool deferred); // messages to the scene wait for the end of each state machine pass, see MessageQueue
+	void SetMap(int gridSize, const std::string& file = ""); // a TGA mask (see SandboxMap), else the built-in layout at gridSize
+	const GameObjectPool& GetPool() const;
+	int GetInactiveAfterFlush() const; // headless only, see m_inactiveAfterFlush
+	const PathRequestQueue& GetPathRequests() const;
+	const PathCache& GetPathCache() const;
+	const FlowFieldCache& GetFlowFields() const;
+	int GetExploredCells(int teamID) const; // cells the team's units have walked over
+	int GetOpenCells() const; // cells that are neither wall nor food right now
+	bool IsSimulationEnded() const;
+	int GetWinner() const;
+	float GetSimulationTime() const;
 protected:
 	// Helper functions
 	int IsWithinBoundary(int x) const;
 	int Get1DIndex(int x, int y) const;
+	void UpdateStateMachines(double dt);
+	void ApplyPath(GameObject* go, MazePt start, std::vector<MazePt>& path); // takes path
 	void DetectNearbyEntities(GameObject* go);
 	void FindNearestResource(GameObject* go);
 	bool IsInTerritory(Vector3 pos, int teamID) const;
@@ -33,9 +71,28 @@ protected:
 	GameObject* GetNearestEnemy(Vector3 pos, int teamID, float maxRange);
 	void FindNearestInjuredAlly(GameObject* go);
 
+	// Message handlers, registered with m_dispatcher in the constructor
+	bool OnSpawnUnit(MessageSpawnUnit* msgSpawn);
+	bool OnResourceDepleted(MessageResourceDepleted* msgDepleted);
+	bool OnUnitDied(MessageUnitDied* msgDied);
+	bool OnResourceDelivered(MessageResourceDelivered* msgRes);
+	bool OnEnemySpotted(MessageEnemySpotted* msgEnemy);
+	bool OnRequestHelp(MessageRequestHelp* msgHelp);
+	MessageDispatcher<SceneSandbox> m_dispatcher;
+	std::vector<GameObject*> m_areaHits; // scratch for FindReceivers
+
 	// Game state
 	std::vector<GameObject*> m_goList;
-	std::map<int, std::vector<GameObject*>> m_spatialGrid;
+	GameObjectPool m_pool; // hands out (and creates) the objects in m_goList
+	int m_poolReserve;
+	int m_jobThreads;
+	JobSystem m_jobs;
+	bool m_bufferedAI;
+	bool m_deferredMessages;
+	unsigned m_aiPhase; // state machine phases so far, seeds the units' random streams in buffered mode
+	int m_inactiveAfterFlush; // headless check: most objects still in the active list switched off after a Flush, should stay 0
+	std::vector<CommandBuffer> m_commandBuffers; // one per chunk of the active list
+	SpatialGrid m_spatialGrid;
 	float m_speed;
 	float m_worldWidth;
 	float m_worldHeight;
@@ -43,11 +100,31 @@ protected:
 	float m_gridSize;
 	float m_gridOffset;
 
-	std::vector<bool> m_wallGrid;
-	std::vector<bool> m_foodGrid;
-	bool IsGridOccupied(int gridX, int gridY);
+	SandboxMap m_map; // the layout the match started from
+	int m_mapSize;
+	std::string m_mapFile;
+	BitGrid m_wallGrid;
+	BitGrid m_foodGrid;
+	BitGrid m_blockedGrid; // wall | food, what every pathfinder reads
+	unsigned m_obstacleVersion; // bumped on every wall/food grid change, the path caches and flow fields key on it
+	GridPathfinder m_pathfinder; // reads m_blockedGrid directly
+	PathRequestQueue m_pathRequests; // unit paths, answered at the start of the next movement pass
+	std::vector<PathRequestQueue::Result> m_pathResults;
+	ClusterGraph m_clusters; // only on big maps, see Init
+	HierarchicalPathfinder m_hierarchicalPathfinder;
+	PathCache m_pathCache; // routes already found, until the food or wall grid changes
+	std::vector<MazePt> m_cachedPath; // scratch for cache hits in the movement pass
+	FlowFieldCache m_flowFields; // shared routes to queens and food sources
+	UnitStore m_units; // positions, targets, speeds and path progress of every object, indexed by handle
+	std::vector<GameObject*> m_trailWalkers; // this tick's workers walking a path out, they record the points they reach
+	bool IsGridOccupied(int gridX, int gridY); // on the map or one cell off it
+	void SetFoodCell(int index, bool occupied);
+	void OnObstacleChanged(int index); // one wall/food cell flipped: version, caches, clusters, flow fields
 	MazePt GetNearestVacantNeighbor(MazePt target, MazePt start);
 	void SpawnTrail(GameObject* startObj, GameObject* endFood, int teamID);
+	int GetFoodId(const GameObject* food) const; // index in m_foodItems, -1 if not a food source
+	GameObject* GetTrailFood(int foodId) const; // nullptr unless the trail still leads to food
+	void RenderPheromones();
 
 	// Red Colony (Team 0)
 	int m_redWorkerCount;
@@ -69,6 +146,10 @@ protected:
 
 	// Food resources
 	std::vector<Vector3> m_foodLocations;
+	ResourceIndex m_foodIndex;
+	std::vector<GameObject*> m_foodItems; // pheromone cells store an index into this
+	PheromoneField m_pheromones[2]; // per team
+	std::vector<unsigned char> m_pheromonePixels; // RGBA upload buffer for GEO_PHEROMONE
 
 	// Simulation state
 	float m_simulationTime;
@@ -79,5 +160,9 @@ protected:
 	float m_updateTimer;
 	int m_updateCycle;
 	bool m_coloniesDetected;
+
+	// Headless mode
+	bool m_headless;
+	unsigned m_seed;
 };
 
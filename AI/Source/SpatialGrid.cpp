@@ -0,0 +1,305 @@
+#include "SpatialGrid.h"
+#include "GameObject.h"
+#include "UnitStore.h"
+#include <algorithm>
+#include <cfloat>
+
+SpatialGrid::SpatialGrid()
+	: m_noGrid(0), m_numCells(0), m_gridSize(1.f), m_units(nullptr)
+{
+}
+
+SpatialGrid::~SpatialGrid()
+{
+}
+
+void SpatialGrid::Init(int noGrid, float gridSize, const UnitStore* units)
+{
+	m_noGrid = noGrid;
+	m_numCells = noGrid * noGrid;
+	m_gridSize = gridSize;
+	m_units = units;
+	Clear();
+}
+
+void SpatialGrid::Clear()
+{
+	//the objects may outlive the grid, leave them free to join another
+	for (size_t k = 0; k < m_entries.size(); ++k)
+		m_entries[k]->gridSlot = -1;
+	m_cellStart.assign(m_numCells + 2, 0);
+	m_entries.clear();
+	m_entryCell.clear();
+	m_entryX.clear();
+	m_entryY.clear();
+	m_entryTeam.clear();
+	m_acquired.clear();
+	m_released.clear();
+}
+
+int SpatialGrid::GetCellIndex(const Vector3& pos) const
+{
+	//objects can sit on the far edge of the map (e.g. a fleeing queen), clamp them into the border cells
+	int gridX = Math::Clamp(static_cast<int>(pos.x / m_gridSize), 0, m_noGrid - 1);
+	int gridY = Math::Clamp(static_cast<int>(pos.y / m_gridSize), 0, m_noGrid - 1);
+	return gridY * m_noGrid + gridX;
+}
+
+void SpatialGrid::Add(GameObject* go)
+{
+	m_acquired.push_back(go);
+}
+
+void SpatialGrid::FindInRadius(const Vector3& pos, float rangeSq, int radius, std::vector<GameObject*>& found) const
+{
+	if (m_numCells <= 0)
+		return;
+	size_t first = found.size();
+	int gridX = static_cast<int>(pos.x / m_gridSize);
+	int gridY = static_cast<int>(pos.y / m_gridSize);
+	for (int dy = -radius; dy <= radius; ++dy)
+	{
+		int checkY = gridY + dy;
+		if (checkY < 0 || checkY >= m_noGrid)
+			continue;
+		for (int dx = -radius; dx <= radius; ++dx)
+		{
+			int checkX = gridX + dx;
+			if (checkX < 0 || checkX >= m_noGrid)
+				continue;
+			int cell = checkY * m_noGrid + checkX;
+			for (int k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k)
+			{
+				GameObject* go = m_entries[k];
+				if (go->active && (m_units->GetPos(go) - pos).LengthSquared() < rangeSq)
+					found.push_back(go);
+			}
+		}
+	}
+
+	//objects acquired since the last Update. one recycled in that time may still sit in
+	//the bucket of its previous life, and have been found there already
+	for (size_t i = 0; i < m_acquired.size(); ++i)
+	{
+		GameObject* go = m_acquired[i];
+		if (go->active && (m_units->GetPos(go) - pos).LengthSquared() < rangeSq && std::find(found.begin() + first, found.end(), go) == found.end())
+			found.push_back(go);
+	}
+}
+
+void SpatialGrid::Remove(GameObject* go)
+{
+	m_released.push_back(go);
+}
+
+void SpatialGrid::AddMover(GameObject* go, int cell, long long& moveCost)
+{
+	int from = m_numCells;
+	if (go->gridSlot >= 0)
+	{
+		if (m_entryMoving[go->gridSlot])
+			return;
+		m_entryMoving[go->gridSlot] = 1;
+		from = m_entryCell[go->gridSlot];
+	}
+	if (cell == from)
+		return;
+	m_movers.push_back(go);
+	m_moverCell.push_back(cell);
+	moveCost += (cell > from) ? cell - from : from - cell;
+}
+
+void SpatialGrid::Update(const std::vector<GameObject*>& activeList)
+{
+	if (m_numCells <= 0)
+		return;
+	m_acquired.clear();
+
+	//find the objects that change bucket, and what moving them one by one would cost.
+	//released objects may already be gone from the active list, the rest are in both
+	m_movers.clear();
+	m_moverCell.clear();
+	m_entryMoving.assign(m_entries.size(), 0);
+	long long moveCost = 0;
+	for (size_t i = 0; i < activeList.size(); ++i)
+	{
+		GameObject* go = activeList[i];
+		AddMover(go, go->active ? GetCellIndex(m_units->GetPos(go)) : m_numCells, moveCost);
+	}
+	for (size_t i = 0; i < m_released.size(); ++i)
+	{
+		GameObject* go = m_released[i];
+		if (!go->active && go->gridSlot >= 0)
+			AddMover(go, m_numCells, moveCost);
+	}
+	m_released.clear();
+	if (m_movers.empty())
+		return;
+
+	//each move shifts one boundary per bucket crossed; once that adds up to more
+	//than a full counting sort, just rebuild
+	if (moveCost > static_cast<long long>(activeList.size()) + m_numCells)
+	{
+		Rebuild(activeList);
+		return;
+	}
+
+	//arrivals start in the extra bucket at the end, departures finish there and are dropped
+	for (size_t k = 0; k < m_movers.size(); ++k)
+	{
+		GameObject* go = m_movers[k];
+		if (go->gridSlot >= 0)
+			continue;
+		go->gridSlot = static_cast<int>(m_entries.size());
+		m_entries.push_back(go);
+		m_entryCell.push_back(m_numCells);
+	}
+	m_cellStart[m_numCells + 1] = static_cast<int>(m_entries.size());
+	for (size_t k = 0; k < m_movers.size(); ++k)
+		Move(m_movers[k], m_entryCell[m_movers[k]->gridSlot], m_moverCell[k]);
+	int kept = m_cellStart[m_numCells];
+	for (size_t k = kept; k < m_entries.size(); ++k)
+		m_entries[k]->gridSlot = -1;
+	m_entries.resize(kept);
+	m_entryCell.resize(kept);
+	m_cellStart[m_numCells + 1] = kept;
+}
+
+void SpatialGrid::Rebuild(const std::vector<GameObject*>& activeList)
+{
+	for (size_t k = 0; k < m_entries.size(); ++k)
+		m_entries[k]->gridSlot = -1;
+	std::fill(m_cellStart.begin(), m_cellStart.end(), 0);
+	int count = 0;
+	for (size_t i = 0; i < activeList.size(); ++i)
+	{
+		const GameObject* go = activeList[i];
+		if (go->active)
+		{
+			++m_cellStart[GetCellIndex(m_units->GetPos(go)) + 1];
+			++count;
+		}
+	}
+	for (size_t c = 1; c < m_cellStart.size(); ++c)
+		m_cellStart[c] += m_cellStart[c - 1];
+
+	//m_cellStart doubles as the scatter cursor: hand out slots bucket by bucket
+	m_entries.resize(count);
+	m_entryCell.resize(count);
+	for (size_t i = 0; i < activeList.size(); ++i)
+	{
+		GameObject* go = activeList[i];
+		if (!go->active)
+			continue;
+		int cell = GetCellIndex(m_units->GetPos(go));
+		int slot = m_cellStart[cell]++;
+		m_entries[slot] = go;
+		m_entryCell[slot] = cell;
+		go->gridSlot = slot;
+	}
+	//the scatter advanced every start to the next bucket's start, shift back
+	for (int c = m_numCells; c > 0; --c)
+		m_cellStart[c] = m_cellStart[c - 1];
+	m_cellStart[0] = 0;
+}
+
+//entries only ever swap within one bucket, so each keeps its bucket
+void SpatialGrid::SwapEntries(int a, int b)
+{
+	if (a == b)
+		return;
+	std::swap(m_entries[a], m_entries[b]);
+	std::swap(m_entryCell[a], m_entryCell[b]);
+	m_entries[a]->gridSlot = a;
+	m_entries[b]->gridSlot = b;
+}
+
+//walk the object across the buckets between from and to, moving one boundary per bucket
+void SpatialGrid::Move(GameObject* go, int from, int to)
+{
+	if (from < to)
+	{
+		for (int c = from; c < to; ++c)
+		{
+			//become the last entry of bucket c, then hand that slot to bucket c + 1
+			SwapEntries(go->gridSlot, m_cellStart[c + 1] - 1);
+			--m_cellStart[c + 1];
+		}
+	}
+	else
+	{
+		for (int c = from; c > to; --c)
+		{
+			//become the first entry of bucket c, then hand that slot to bucket c - 1
+			SwapEntries(go->gridSlot, m_cellStart[c]);
+			++m_cellStart[c];
+		}
+	}
+	m_entryCell[go->gridSlot] = to;
+}
+
+GameObject* const* SpatialGrid::CellBegin(int cellIndex) const
+{
+	return m_entries.data() + m_cellStart[cellIndex];
+}
+
+GameObject* const* SpatialGrid::CellEnd(int cellIndex) const
+{
+	return m_entries.data() + m_cellStart[cellIndex + 1];
+}
+
+void SpatialGrid::SyncEntries()
+{
+	m_entryX.resize(m_entries.size());
+	m_entryY.resize(m_entries.size());
+	m_entryTeam.resize(m_entries.size());
+	for (size_t k = 0; k < m_entries.size(); ++k)
+	{
+		const GameObject* go = m_entries[k];
+		int unit = UnitStore::GetSlot(go);
+		m_entryX[k] = m_units->posX[unit];
+		m_entryY[k] = m_units->posY[unit];
+		m_entryTeam[k] = (go->active && go->type != GameObject::GO_FOOD) ? go->teamID : -1;
+	}
+}
+
+GameObject* SpatialGrid::FindNearestEnemy(const GameObject* self, float rangeSq, int radius) const
+{
+	if (self->teamID < 0 || m_entryTeam.size() != m_entries.size())
+		return nullptr;
+	const float x = m_units->posX[UnitStore::GetSlot(self)];
+	const float y = m_units->posY[UnitStore::GetSlot(self)];
+	const int team = self->teamID;
+	int gridX = static_cast<int>(x / m_gridSize);
+	int gridY = static_cast<int>(y / m_gridSize);
+
+	GameObject* nearest = nullptr;
+	float nearestDistSq = FLT_MAX;
+	for (int dy = -radius; dy <= radius; ++dy)
+	{
+		int checkY = gridY + dy;
+		if (checkY < 0 || checkY >= m_noGrid)
+			continue;
+		for (int dx = -radius; dx <= radius; ++dx)
+		{
+			int checkX = gridX + dx;
+			if (checkX < 0 || checkX >= m_noGrid)
+				continue;
+			int cell = checkY * m_noGrid + checkX;
+			for (int k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k)
+			{
+				if (m_entryTeam[k] < 0 || m_entryTeam[k] == team)
+					continue;
+				float ex = x - m_entryX[k];
+				float ey = y - m_entryY[k];
+				float distSq = ex * ex + ey * ey;
+				if (distSq < rangeSq && distSq < nearestDistSq)
+				{
+					nearestDistSq = distSq;
+					nearest = m_entries[k];
+				}
+			}
+		}
+	}
+	return nearest;
+}
@@ -0,0 +1,78 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <vector>
+#include "Vector3.h"
+
+struct GameObject;
+struct UnitStore;
+
+//uniform grid over the sandbox map, one bucket per map cell
+//buckets are stored back to back (CSR layout): the objects in cell c are
+//m_entries[m_cellStart[c]] .. m_entries[m_cellStart[c + 1] - 1]
+//so a neighbourhood query only touches contiguous memory.
+//only objects in use are held: Update walks the pool's active list, and the pool reports
+//what it hands out and takes back (GameObjectPool::SetSpatialGrid), so nothing scales with the
+//pool's capacity. an object's slot is kept in GameObject::gridSlot.
+//during Update one extra bucket after the last cell holds arrivals and departures, which lets
+//spawns and deaths be handled as ordinary cell changes.
+//positions are read from the scene's UnitStore. each entry also has packed copies of its position
+//and team (SyncEntries), in cell order, so that sensing queries scan floats instead of whole GameObjects
+class SpatialGrid
+{
+public:
+	SpatialGrid();
+	~SpatialGrid();
+
+	void Init(int noGrid, float gridSize, const UnitStore* units); //units holds the positions of every object Added
+	void Clear();
+
+	//bucket the active objects of activeList that changed cell since the last call, and drop
+	//the objects that were switched off or Removed
+	void Update(const std::vector<GameObject*>& activeList);
+	//the pool just handed go out (GameObjectPool::SetSpatialGrid): it has no cell until the next Update,
+	//so until then FindInRadius checks it separately
+	void Add(GameObject* go);
+	//the pool took go back: it may leave the active list before the next Update, which drops it all the same
+	void Remove(GameObject* go);
+
+	int GetCellIndex(const Vector3& pos) const;
+	GameObject* const* CellBegin(int cellIndex) const;
+	GameObject* const* CellEnd(int cellIndex) const;
+
+	//refresh the packed position/team copies from the objects, cheap enough to call every tick
+	//(bucket membership only changes in Update)
+	void SyncEntries();
+	//nearest object of another team within sqrt(rangeSq) of self, looking radius cells around self's cell
+	//teamless objects, food and inactive objects are never found, and a teamless self finds nothing
+	GameObject* FindNearestEnemy(const GameObject* self, float rangeSq, int radius) const;
+	//every active object within sqrt(rangeSq) of pos by its live position, appended to found, looking radius cells
+	//around pos's cell plus the objects Added since the last Update.
+	//one that moved cell since the last Update is only found if it is still within radius cells
+	void FindInRadius(const Vector3& pos, float rangeSq, int radius, std::vector<GameObject*>& found) const;
+
+private:
+	void AddMover(GameObject* go, int cell, long long& moveCost);
+	void Rebuild(const std::vector<GameObject*>& activeList);
+	void Move(GameObject* go, int from, int to);
+	void SwapEntries(int a, int b);
+
+	int m_noGrid;
+	int m_numCells;                      //noGrid*noGrid, also the id of the arrivals/departures bucket
+	float m_gridSize;
+	const UnitStore* m_units;
+
+	std::vector<int> m_cellStart;        //size numCells + 2
+	std::vector<GameObject*> m_entries;  //objects sorted by cell
+	std::vector<int> m_entryCell;        //bucket of m_entries[k]
+	std::vector<float> m_entryX;         //m_entries[k]'s x as of the last SyncEntries
+	std::vector<float> m_entryY;
+	std::vector<int> m_entryTeam;        //teamID of m_entries[k] if it can be targeted, -1 otherwise
+	std::vector<char> m_entryMoving;     //scratch: m_entries[k] is already a mover this update
+	std::vector<GameObject*> m_movers;   //scratch: objects that change bucket this update
+	std::vector<int> m_moverCell;        //scratch: their new bucket
+	std::vector<GameObject*> m_acquired; //Added since the last Update
+	std::vector<GameObject*> m_released; //Removed since the last Update
+};
+
+#endif
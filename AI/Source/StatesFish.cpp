@@ -1,6 +1,7 @@
 #include "StatesFish.h"
 // Exercise Week 05
 #include "PostOffice.h"
+#include "MessagePool.h"
 #include "ConcreteMessages.h"
 
 static const float ENERGY_DROP_RATE = 0.2f;
@@ -91,7 +92,7 @@ void StateHungry::Enter()
 
 	// Exercise Week 05
 	int range[2] = { -3, 3 };
-	PostOffice::GetInstance()->Send("Scene", new MessageSpawnFood(m_go, GameObject::GO_FISHFOOD, 2, range));
+	PostOffice::GetInstance()->Send("Scene", MessagePool::GetInstance()->Create<MessageSpawnFood>(m_go, GameObject::GO_FISHFOOD, 2, range));
 }
 
 void StateHungry::Update(double dt)
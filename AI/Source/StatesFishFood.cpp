@@ -1,5 +1,6 @@
 #include "StatesFishFood.h"
 #include "PostOffice.h"
+#include "MessagePool.h"
 #include "ConcreteMessages.h"
 
 StateEvolve::StateEvolve(const std::string& stateID, GameObject* go)
@@ -10,7 +11,7 @@ StateEvolve::StateEvolve(const std::string& stateID, GameObject* go)
 
 void StateEvolve::Enter()
 {
-	PostOffice::GetInstance()->Send("Scene", new MessageEvolve(m_go));
+	PostOffice::GetInstance()->Send("Scene", MessagePool::GetInstance()->Create<MessageEvolve>(m_go));
 }
 
 void StateEvolve::Update(double dt)
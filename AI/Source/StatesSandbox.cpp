@@ -1,20 +1,35 @@
 #include "StatesSandbox.h"
 #include "PostOffice.h"
+#include "MessagePool.h"
 #include "ConcreteMessages.h"
 #include "SceneData.h"
+#include "SandboxMap.h"
 #include "MyMath.h"
+#include "CommandBuffer.h"
+#include "UnitStore.h"
 
 // --- NEW GLOBALS ---
-static std::vector<bool> g_visitedNodes[2];
+static BitGrid g_visitedNodes[2]; // cells each team has walked over
 static bool g_enemyColonyFound[2] = { false, false }; // [Cite: User Requirement 2]
 static Vector3 g_enemyColonyPos[2];
+static AddressHandle g_sceneAddress = -1;
+static AddressHandle g_alertChannel[2] = { -1, -1 };
+
+// Position, target, speed and path progress live in the scene's UnitStore, not on the GameObject
+static Vector3 Pos(const GameObject* go) { return SceneData::GetInstance()->GetUnits()->GetPos(go); }
+static Vector3 Target(const GameObject* go) { return SceneData::GetInstance()->GetUnits()->GetTarget(go); }
+static void SetTarget(const GameObject* go, const Vector3& target) { SceneData::GetInstance()->GetUnits()->SetTarget(go, target); }
+static void SetSpeed(const GameObject* go, float speed) { SceneData::GetInstance()->GetUnits()->SetSpeed(go, speed); }
 
 void ResizeVisitedNodes() {
-	int size = SceneData::GetInstance()->GetNumGrid() * SceneData::GetInstance()->GetNumGrid();
-	if (g_visitedNodes[0].size() != size) g_visitedNodes[0].assign(size, false);
-	if (g_visitedNodes[1].size() != size) g_visitedNodes[1].assign(size, false);
+	int gridNum = SceneData::GetInstance()->GetNumGrid();
+	if (g_visitedNodes[0].GetWidth() != gridNum) g_visitedNodes[0].Init(gridNum, gridNum, false);
+	if (g_visitedNodes[1].GetWidth() != gridNum) g_visitedNodes[1].Init(gridNum, gridNum, false);
 }
 void ResetGlobalSandboxVars() {
+	g_sceneAddress = PostOffice::GetInstance()->GetAddress("Scene");
+	g_alertChannel[0] = PostOffice::GetInstance()->GetAddress("Team0Alerts");
+	g_alertChannel[1] = PostOffice::GetInstance()->GetAddress("Team1Alerts");
 	g_enemyColonyFound[0] = false;
 	g_enemyColonyFound[1] = false;
 	g_enemyColonyPos[0].SetZero();
@@ -22,8 +37,8 @@ void ResetGlobalSandboxVars() {
 
 	// Also clear visited nodes if you want a fresh exploration map
 	ResizeVisitedNodes();
-	std::fill(g_visitedNodes[0].begin(), g_visitedNodes[0].end(), false);
-	std::fill(g_visitedNodes[1].begin(), g_visitedNodes[1].end(), false);
+	g_visitedNodes[0].Clear();
+	g_visitedNodes[1].Clear();
 }
 Vector3 GetRandomPerimeterPos(int teamID)
 {
@@ -32,32 +47,33 @@ Vector3 GetRandomPerimeterPos(int teamID)
 	int gridNum = SceneData::GetInstance()->GetNumGrid();
 
 	// 20% Chance to patrol CENTER MAP (Skirmish Zone)
-	if (Math::RandIntMinMax(0, 100) < 20) {
+	if (CommandBuffer::RandInt(0, 100) < 20) {
 		int mid = gridNum / 2;
-		int nX = Math::RandIntMinMax(mid - 3, mid + 3);
-		int nY = Math::RandIntMinMax(mid - 3, mid + 3);
+		int nX = CommandBuffer::RandInt(mid - 3, mid + 3);
+		int nY = CommandBuffer::RandInt(mid - 3, mid + 3);
 		return Vector3(nX * gridSize + offset, nY * gridSize + offset, 0);
 	}
 
+	// Otherwise the 5 cells just outside the territory, on the sides facing the middle of the map
+	const SandboxMap::Colony& colony = SceneData::GetInstance()->GetMap()->GetColony(teamID);
+	int mid = gridNum / 2;
+	int bandX0 = (colony.x0 + colony.x1) / 2 < mid ? colony.x1 : colony.x0 - 5; int bandX1 = bandX0 + 4;
+	int bandY0 = (colony.y0 + colony.y1) / 2 < mid ? colony.y1 : colony.y0 - 5; int bandY1 = bandY0 + 4;
 	int nX, nY;
-	if (teamID == 0) { // RED
-		if (Math::RandIntMinMax(0, 1) == 0) { nX = Math::RandIntMinMax(8, 12); nY = Math::RandIntMinMax(0, 12); }
-		else { nX = Math::RandIntMinMax(0, 12); nY = Math::RandIntMinMax(8, 12); }
-	}
-	else { // BLUE
-		int maxG = gridNum - 1;
-		if (Math::RandIntMinMax(0, 1) == 0) { nX = Math::RandIntMinMax(17, 21); nY = Math::RandIntMinMax(17, maxG); }
-		else { nX = Math::RandIntMinMax(17, maxG); nY = Math::RandIntMinMax(17, 21); }
-	}
+	if (CommandBuffer::RandInt(0, 1) == 0) { nX = CommandBuffer::RandInt(bandX0, bandX1); nY = CommandBuffer::RandInt(Math::Min(colony.y0, bandY0), Math::Max(colony.y1 - 1, bandY1)); }
+	else { nX = CommandBuffer::RandInt(Math::Min(colony.x0, bandX0), Math::Max(colony.x1 - 1, bandX1)); nY = CommandBuffer::RandInt(bandY0, bandY1); }
 
 	nX = Math::Clamp(nX, 0, gridNum - 1);
 	nY = Math::Clamp(nY, 0, gridNum - 1);
 	return Vector3(nX * gridSize + offset, nY * gridSize + offset, 0);
 }
 
-void MarkVisited(Vector3 pos, int teamID) { ResizeVisitedNodes(); int gridNum = SceneData::GetInstance()->GetNumGrid(); int gx = (int)(pos.x / SceneData::GetInstance()->GetGridSize()); int gy = (int)(pos.y / SceneData::GetInstance()->GetGridSize()); if (gx >= 0 && gx < gridNum && gy >= 0 && gy < gridNum) { g_visitedNodes[teamID][gy * gridNum + gx] = true; } }
-Vector3 GetRandomEntrance(int teamID) { float gridSize = SceneData::GetInstance()->GetGridSize(); float offset = SceneData::GetInstance()->GetGridOffset(); int gx, gy; int choice = Math::RandIntMinMax(0, 3); if (teamID == 0) { if (choice == 0) { gx = 3; gy = 7; } else if (choice == 1) { gx = 4; gy = 7; } else if (choice == 2) { gx = 7; gy = 3; } else { gx = 7; gy = 4; } } else { if (choice == 0) { gx = 26; gy = 22; } else if (choice == 1) { gx = 27; gy = 22; } else if (choice == 2) { gx = 22; gy = 26; } else { gx = 22; gy = 27; } } return Vector3(gx * gridSize + offset, gy * gridSize + offset, 0); }
-Vector3 GetRandomGridPosAround(Vector3 center, float range) { float gridSize = SceneData::GetInstance()->GetGridSize(); float offset = SceneData::GetInstance()->GetGridOffset(); int gridNum = SceneData::GetInstance()->GetNumGrid(); int cX = (int)(center.x / gridSize); int cY = (int)(center.y / gridSize); int r = (int)range; int nX = Math::Clamp(Math::RandIntMinMax(cX - r, cX + r), 0, gridNum - 1); int nY = Math::Clamp(Math::RandIntMinMax(cY - r, cY + r), 0, gridNum - 1); return Vector3(nX * gridSize + offset, nY * gridSize + offset, 0); }
+int GetExploredCellCount(int teamID) { return g_visitedNodes[teamID].Count(); }
+AddressHandle GetTeamAlertChannel(int teamID) { return g_alertChannel[teamID]; }
+void SetVisited(int teamID, int index) { int gridNum = SceneData::GetInstance()->GetNumGrid(); g_visitedNodes[teamID].Set(index % gridNum, index / gridNum, true); }
+void MarkVisited(Vector3 pos, int teamID) { ResizeVisitedNodes(); int gridNum = SceneData::GetInstance()->GetNumGrid(); int gx = (int)(pos.x / SceneData::GetInstance()->GetGridSize()); int gy = (int)(pos.y / SceneData::GetInstance()->GetGridSize()); if (gx >= 0 && gx < gridNum && gy >= 0 && gy < gridNum) { CommandBuffer::Call(SetVisited, teamID, gy * gridNum + gx); } }
+Vector3 GetRandomEntrance(int teamID) { float gridSize = SceneData::GetInstance()->GetGridSize(); float offset = SceneData::GetInstance()->GetGridOffset(); const SandboxMap::Colony& colony = SceneData::GetInstance()->GetMap()->GetColony(teamID); MazePt cell = colony.queen; if (!colony.entrances.empty()) cell = colony.entrances[CommandBuffer::RandInt(0, static_cast<int>(colony.entrances.size()) - 1)]; return Vector3(cell.x * gridSize + offset, cell.y * gridSize + offset, 0); }
+Vector3 GetRandomGridPosAround(Vector3 center, float range) { float gridSize = SceneData::GetInstance()->GetGridSize(); float offset = SceneData::GetInstance()->GetGridOffset(); int gridNum = SceneData::GetInstance()->GetNumGrid(); int cX = (int)(center.x / gridSize); int cY = (int)(center.y / gridSize); int r = (int)range; int nX = Math::Clamp(CommandBuffer::RandInt(cX - r, cX + r), 0, gridNum - 1); int nY = Math::Clamp(CommandBuffer::RandInt(cY - r, cY + r), 0, gridNum - 1); return Vector3(nX * gridSize + offset, nY * gridSize + offset, 0); }
 Vector3 GetRandomExplorationTarget(Vector3 center, int teamID)
 {
 	ResizeVisitedNodes();
@@ -66,113 +82,105 @@ Vector3 GetRandomExplorationTarget(Vector3 center, int teamID)
 	int gridNum = SceneData::GetInstance()->GetNumGrid();
 
 	// 30% chance to pick a "Bold" target (Center or Enemy side)
-	if (Math::RandIntMinMax(0, 100) < 30) {
+	if (CommandBuffer::RandInt(0, 100) < 30) {
 		int mid = gridNum / 2;
-		int nX = Math::RandIntMinMax(mid - 5, mid + 5);
-		int nY = Math::RandIntMinMax(mid - 5, mid + 5);
+		int nX = CommandBuffer::RandInt(mid - 5, mid + 5);
+		int nY = CommandBuffer::RandInt(mid - 5, mid + 5);
 		return Vector3(nX * gridSize + offset, nY * gridSize + offset, 0);
 	}
 
 	for (int i = 0; i < 10; ++i) {
-		int nX = Math::RandIntMinMax(0, gridNum - 1);
-		int nY = Math::RandIntMinMax(0, gridNum - 1);
-		int idx = nY * gridNum + nX;
-		if (!g_visitedNodes[teamID][idx]) {
+		int nX = CommandBuffer::RandInt(0, gridNum - 1);
+		int nY = CommandBuffer::RandInt(0, gridNum - 1);
+		if (!g_visitedNodes[teamID].Get(nX, nY)) {
 			return Vector3(nX * gridSize + offset, nY * gridSize + offset, 0);
 		}
 	}
-	int nX = Math::RandIntMinMax(0, gridNum - 1);
-	int nY = Math::RandIntMinMax(0, gridNum - 1);
+	int nX = CommandBuffer::RandInt(0, gridNum - 1);
+	int nY = CommandBuffer::RandInt(0, gridNum - 1);
 	return Vector3(nX * gridSize + offset, nY * gridSize + offset, 0);
 }
 
 // ================= WORKER STATES (Keep Unchanged) =================
 // ... [StateWorkerIdle, StateWorkerSearching, StateWorkerGathering, StateWorkerFleeing implementation unchanged] ...
-StateWorkerIdle::StateWorkerIdle(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
+StateWorkerIdle::StateWorkerIdle(const std::string& stateID, GameObject* go) : State(stateID), m_go(go), timer(0.f) {}
 StateWorkerIdle::~StateWorkerIdle() {}
-void StateWorkerIdle::Enter() { m_go->moveSpeed = 0.f; }
-void StateWorkerIdle::Update(double dt) { static float timer = 0.f; timer += (float)dt; if (timer > 1.f) { timer = 0.f; m_go->sm->SetNextState("Searching"); } }
+void StateWorkerIdle::Enter() { SetSpeed(m_go, 0.f); }
+void StateWorkerIdle::Update(double dt) { timer += (float)dt; if (timer > 1.f) { timer = 0.f; m_go->sm->SetNextState("Searching"); } }
 void StateWorkerIdle::Exit() {}
 
 StateWorkerSearching::StateWorkerSearching(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
 StateWorkerSearching::~StateWorkerSearching() {}
-void StateWorkerSearching::Enter() { m_go->moveSpeed = m_go->baseSpeed; m_go->targetResource.SetZero(); m_go->targetFoodItem = nullptr; m_go->pathHistory.clear(); }
+void StateWorkerSearching::Enter() { SetSpeed(m_go, m_go->baseSpeed); m_go->targetResource.SetZero(); m_go->targetFoodItem = nullptr; m_go->pathHistory.clear(); }
 void StateWorkerSearching::Update(double dt) {
 	if (m_go->targetEnemy != nullptr && m_go->health < m_go->maxHealth * 0.4f) { m_go->sm->SetNextState("Fleeing"); return; }
-	if (!m_go->targetFoodItem) { if ((m_go->pos - m_go->target).LengthSquared() < 0.1f) { if (m_go->teamID == 0) m_go->target = GetRandomGridPosAround(Vector3(4.f * SceneData::GetInstance()->GetGridSize(), 4.f * SceneData::GetInstance()->GetGridSize(), 0), 4); else m_go->target = GetRandomGridPosAround(Vector3(26.f * SceneData::GetInstance()->GetGridSize(), 26.f * SceneData::GetInstance()->GetGridSize(), 0), 4); } }
+	if (!m_go->targetFoodItem) { if ((Pos(m_go) - Target(m_go)).LengthSquared() < 0.1f) { const SandboxMap::Colony& colony = SceneData::GetInstance()->GetMap()->GetColony(m_go->teamID); SetTarget(m_go, GetRandomGridPosAround(Vector3((colony.x0 + colony.x1) * 0.5f * SceneData::GetInstance()->GetGridSize(), (colony.y0 + colony.y1) * 0.5f * SceneData::GetInstance()->GetGridSize(), 0), 4)); } }
 	else { m_go->sm->SetNextState("Gathering"); }
 }
 void StateWorkerSearching::Exit() {}
 
 StateWorkerGathering::StateWorkerGathering(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
 StateWorkerGathering::~StateWorkerGathering() {}
-void StateWorkerGathering::Enter() { m_go->moveSpeed = m_go->baseSpeed * 0.66f; m_go->gatherTimer = 0.f; m_go->isCarryingResource = false; if (m_go->targetFoodItem) m_go->targetFoodItem->harvesterCount++; }
+void StateWorkerGathering::Enter() { SetSpeed(m_go, m_go->baseSpeed * 0.66f); m_go->gatherTimer = 0.f; m_go->isCarryingResource = false; if (m_go->targetFoodItem) CommandBuffer::AddHarvesters(m_go->targetFoodItem, 1); }
 void StateWorkerGathering::Update(double dt) {
 	if (m_go->targetEnemy != nullptr && m_go->health < m_go->maxHealth * 0.4f) { m_go->sm->SetNextState("Fleeing"); return; }
 	float interactSq = (SceneData::GetInstance()->GetGridSize() * 2.0f) * (SceneData::GetInstance()->GetGridSize() * 2.0f);
-	if (!m_go->isCarryingResource) { if (m_go->targetFoodItem && m_go->targetFoodItem->active) { m_go->target = m_go->targetFoodItem->pos; if ((m_go->pos - m_go->targetFoodItem->pos).LengthSquared() < interactSq) { m_go->gatherTimer += (float)dt; if (m_go->gatherTimer > 2.f) { m_go->isCarryingResource = true; m_go->carriedResources = 1; m_go->gatherTimer = 0.f; m_go->targetFoodItem->resourceCount--; if (m_go->targetFoodItem->resourceCount <= 0) m_go->targetFoodItem->active = false; if (m_go->targetFoodItem) m_go->targetFoodItem->harvesterCount--; m_go->targetFoodItem = nullptr; m_go->targetResource.SetZero(); if (!m_go->pathHistory.empty()) { m_go->path = m_go->pathHistory; std::reverse(m_go->path.begin(), m_go->path.end()); m_go->pathHistory.clear(); } } } } else { m_go->targetFoodItem = nullptr; m_go->sm->SetNextState("Searching"); } }
-	else { if (m_go->path.empty()) m_go->target = m_go->homeBase; if ((m_go->pos - m_go->homeBase).LengthSquared() < interactSq) { PostOffice::GetInstance()->Send("Scene", new MessageResourceDelivered(m_go, m_go->carriedResources, m_go->teamID)); m_go->isCarryingResource = false; m_go->carriedResources = 0; m_go->targetFoodItem = nullptr; m_go->sm->SetNextState("Idle"); } }
+	if (!m_go->isCarryingResource) { if (m_go->targetFoodItem && m_go->targetFoodItem->active) { SetTarget(m_go, Pos(m_go->targetFoodItem)); if ((Pos(m_go) - Pos(m_go->targetFoodItem)).LengthSquared() < interactSq) { m_go->gatherTimer += (float)dt; if (m_go->gatherTimer > 2.f) { m_go->isCarryingResource = true; m_go->carriedResources = 1; m_go->gatherTimer = 0.f; CommandBuffer::TakeFood(m_go->targetFoodItem); if (m_go->targetFoodItem) CommandBuffer::AddHarvesters(m_go->targetFoodItem, -1); m_go->targetFoodItem = nullptr; m_go->targetResource.SetZero(); if (!m_go->pathHistory.empty()) { m_go->path = m_go->pathHistory; std::reverse(m_go->path.begin(), m_go->path.end()); SceneData::GetInstance()->GetUnits()->StartPath(m_go); m_go->pathHistory.clear(); } } } } else { m_go->targetFoodItem = nullptr; m_go->sm->SetNextState("Searching"); } }
+	else { if (!SceneData::GetInstance()->GetUnits()->HasPath(m_go)) SetTarget(m_go, m_go->homeBase); if ((Pos(m_go) - m_go->homeBase).LengthSquared() < interactSq) { PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageResourceDelivered>(m_go, m_go->carriedResources, m_go->teamID)); m_go->isCarryingResource = false; m_go->carriedResources = 0; m_go->targetFoodItem = nullptr; m_go->sm->SetNextState("Idle"); } }
 }
-void StateWorkerGathering::Exit() { if (m_go->targetFoodItem) m_go->targetFoodItem->harvesterCount--; }
+void StateWorkerGathering::Exit() { if (m_go->targetFoodItem) CommandBuffer::AddHarvesters(m_go->targetFoodItem, -1); }
 
 StateWorkerFleeing::StateWorkerFleeing(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
 StateWorkerFleeing::~StateWorkerFleeing() {}
-void StateWorkerFleeing::Enter() { m_go->moveSpeed = m_go->baseSpeed * 1.5f; PostOffice::GetInstance()->Send("Scene", new MessageRequestHelp(m_go, m_go->pos, m_go->teamID)); }
-void StateWorkerFleeing::Update(double dt) { if (m_go->targetEnemy && m_go->targetEnemy->active) { Vector3 dir = m_go->pos - m_go->targetEnemy->pos; if (dir.LengthSquared() > 0.1f) { dir.Normalize(); m_go->target = GetRandomGridPosAround(m_go->pos + dir * SceneData::GetInstance()->GetGridSize() * 3.f, 1); } else { m_go->target = m_go->homeBase; } if ((m_go->pos - m_go->targetEnemy->pos).LengthSquared() > m_go->detectionRange * m_go->detectionRange * 4.f) { m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Idle"); } } else { m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Idle"); } }
+void StateWorkerFleeing::Enter() { SetSpeed(m_go, m_go->baseSpeed * 1.5f); PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageRequestHelp>(m_go, Pos(m_go), m_go->teamID)); }
+void StateWorkerFleeing::Update(double dt) { if (m_go->targetEnemy && m_go->targetEnemy->active) { Vector3 dir = Pos(m_go) - Pos(m_go->targetEnemy); if (dir.LengthSquared() > 0.1f) { dir.Normalize(); SetTarget(m_go, GetRandomGridPosAround(Pos(m_go) + dir * SceneData::GetInstance()->GetGridSize() * 3.f, 1)); } else { SetTarget(m_go, m_go->homeBase); } if ((Pos(m_go) - Pos(m_go->targetEnemy)).LengthSquared() > m_go->detectionRange * m_go->detectionRange * 4.f) { m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Idle"); } } else { m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Idle"); } }
 void StateWorkerFleeing::Exit() {}
 
 // ================= SOLDIER STATES =================
 StateSoldierPatrolling::StateSoldierPatrolling(const std::string& stateID, GameObject* go) : State(stateID), m_go(go), patrolTimer(0.f) {}
 StateSoldierPatrolling::~StateSoldierPatrolling() {}
-void StateSoldierPatrolling::Enter() { m_go->moveSpeed = m_go->baseSpeed; patrolTimer = 0.f; patrolTarget.SetZero(); }
+void StateSoldierPatrolling::Enter() { SetSpeed(m_go, m_go->baseSpeed); patrolTimer = 0.f; patrolTarget.SetZero(); }
 void StateSoldierPatrolling::Update(double dt) {
 	patrolTimer += (float)dt;
 	if (m_go->targetEnemy && m_go->targetEnemy->active) {
 		// --- FIX: IGNORE SCOUTS UNLESS NEAR BASE ---
 		if (m_go->targetEnemy->type == GameObject::GO_SCOUT) {
-			float distToBase = (m_go->targetEnemy->pos - m_go->homeBase).LengthSquared();
+			float distToBase = (Pos(m_go->targetEnemy) - m_go->homeBase).LengthSquared();
 			float alertRadius = (SceneData::GetInstance()->GetGridSize() * 3.f) * (SceneData::GetInstance()->GetGridSize() * 3.f);
 			if (distToBase < alertRadius) {
-				PostOffice::GetInstance()->Send("Scene", new MessageEnemySpotted(m_go, m_go->targetEnemy, m_go->teamID));
+				PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageEnemySpotted>(m_go, m_go->targetEnemy, m_go->teamID));
 				m_go->sm->SetNextState("Attacking");
 			}
 			else { m_go->targetEnemy = nullptr; }
 		}
 		else {
-			PostOffice::GetInstance()->Send("Scene", new MessageEnemySpotted(m_go, m_go->targetEnemy, m_go->teamID));
+			PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageEnemySpotted>(m_go, m_go->targetEnemy, m_go->teamID));
 			m_go->sm->SetNextState("Attacking");
 		}
 		return;
 	}
-	if (patrolTimer > 4.f || patrolTarget.IsZero() || (m_go->pos - m_go->target).LengthSquared() < 0.5f) {
+	if (patrolTimer > 4.f || patrolTarget.IsZero() || (Pos(m_go) - Target(m_go)).LengthSquared() < 0.5f) {
 		patrolTimer = 0.f;
 		patrolTarget = GetRandomPerimeterPos(m_go->teamID);
-		m_go->target = patrolTarget;
+		SetTarget(m_go, patrolTarget);
 	}
 }
 void StateSoldierPatrolling::Exit() {}
 
 StateSoldierAttacking::StateSoldierAttacking(const std::string& stateID, GameObject* go) : State(stateID), m_go(go), attackCooldown(0.f) {}
 StateSoldierAttacking::~StateSoldierAttacking() {}
-void StateSoldierAttacking::Enter() { m_go->moveSpeed = m_go->baseSpeed; attackCooldown = 0.f; }
+void StateSoldierAttacking::Enter() { SetSpeed(m_go, m_go->baseSpeed); attackCooldown = 0.f; }
 void StateSoldierAttacking::Update(double dt) {
 	if (m_go->health < m_go->maxHealth * 0.4f) { m_go->sm->SetNextState("Retreating"); return; }
 
-	// Ignore Trails
-	if (m_go->targetEnemy && m_go->targetEnemy->type == GameObject::GO_PHEROMONE) {
-		m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Patrolling"); return;
-	}
-
 	attackCooldown += (float)dt;
 	if (!m_go->targetEnemy || !m_go->targetEnemy->active) { m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Resting"); return; }
-	m_go->target = m_go->targetEnemy->pos;
-	if ((m_go->pos - m_go->targetEnemy->pos).LengthSquared() < m_go->attackRange * m_go->attackRange) {
+	SetTarget(m_go, Pos(m_go->targetEnemy));
+	if ((Pos(m_go) - Pos(m_go->targetEnemy)).LengthSquared() < m_go->attackRange * m_go->attackRange) {
 		if (attackCooldown > 0.5f) {
-			m_go->targetEnemy->health -= m_go->attackPower;
 			attackCooldown = 0.f;
-			if (m_go->targetEnemy->health <= 0.f) {
-				PostOffice::GetInstance()->Send("Scene", new MessageUnitDied(m_go->targetEnemy, m_go->targetEnemy->teamID, m_go->targetEnemy->type));
-				m_go->targetEnemy->active = false; m_go->targetEnemy = nullptr;
+			if (CommandBuffer::Damage(m_go->targetEnemy, m_go->attackPower)) {
+				m_go->targetEnemy = nullptr;
 				m_go->sm->SetNextState("Resting");
 			}
 		}
@@ -181,19 +189,19 @@ void StateSoldierAttacking::Update(double dt) {
 void StateSoldierAttacking::Exit() {}
 StateSoldierResting::StateSoldierResting(const std::string& stateID, GameObject* go) : State(stateID), m_go(go), restTimer(0.f) {}
 StateSoldierResting::~StateSoldierResting() {}
-void StateSoldierResting::Enter() { m_go->moveSpeed = m_go->baseSpeed; m_go->target = m_go->homeBase; restTimer = 0.f; }
-void StateSoldierResting::Update(double dt) { restTimer += (float)dt; if ((m_go->pos - m_go->homeBase).LengthSquared() > 1.f) m_go->target = m_go->homeBase; if (m_go->targetEnemy && m_go->targetEnemy->active) { m_go->sm->SetNextState("Attacking"); return; } if ((m_go->pos - m_go->homeBase).LengthSquared() < 4.f) { m_go->health = Math::Min(m_go->maxHealth, m_go->health + (float)dt * 1.f); } if (m_go->health > m_go->maxHealth * 0.9f && restTimer > 2.f) m_go->sm->SetNextState("Patrolling"); }
+void StateSoldierResting::Enter() { SetSpeed(m_go, m_go->baseSpeed); SetTarget(m_go, m_go->homeBase); restTimer = 0.f; }
+void StateSoldierResting::Update(double dt) { restTimer += (float)dt; if ((Pos(m_go) - m_go->homeBase).LengthSquared() > 1.f) SetTarget(m_go, m_go->homeBase); if (m_go->targetEnemy && m_go->targetEnemy->active) { m_go->sm->SetNextState("Attacking"); return; } if ((Pos(m_go) - m_go->homeBase).LengthSquared() < 4.f) { CommandBuffer::AdjustHealth(m_go, (float)dt * 1.f, m_go->maxHealth); } if (m_go->health > m_go->maxHealth * 0.9f && restTimer > 2.f) m_go->sm->SetNextState("Patrolling"); }
 void StateSoldierResting::Exit() {}
 StateSoldierRetreating::StateSoldierRetreating(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
 StateSoldierRetreating::~StateSoldierRetreating() {}
-void StateSoldierRetreating::Enter() { m_go->moveSpeed = m_go->baseSpeed * 1.5f; PostOffice::GetInstance()->Send("Scene", new MessageRequestHelp(m_go, m_go->pos, m_go->teamID)); }
-void StateSoldierRetreating::Update(double dt) { m_go->target = m_go->homeBase; if ((m_go->pos - m_go->homeBase).LengthSquared() < 4.f) m_go->sm->SetNextState("Resting"); }
+void StateSoldierRetreating::Enter() { SetSpeed(m_go, m_go->baseSpeed * 1.5f); PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageRequestHelp>(m_go, Pos(m_go), m_go->teamID)); }
+void StateSoldierRetreating::Update(double dt) { SetTarget(m_go, m_go->homeBase); if ((Pos(m_go) - m_go->homeBase).LengthSquared() < 4.f) m_go->sm->SetNextState("Resting"); }
 void StateSoldierRetreating::Exit() {}
 
 // ================= QUEEN STATES =================
 StateQueenSpawning::StateQueenSpawning(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
 StateQueenSpawning::~StateQueenSpawning() {}
-void StateQueenSpawning::Enter() { m_go->moveSpeed = 0.f; m_go->spawnCooldown = 0.f; }
+void StateQueenSpawning::Enter() { SetSpeed(m_go, 0.f); m_go->spawnCooldown = 0.f; }
 void StateQueenSpawning::Update(double dt) {
 	// --- NEW: QUEEN FLEE CHECK ---
 	if (m_go->health < m_go->maxHealth * 0.2f) { // Low Health Flee
@@ -202,14 +210,14 @@ void StateQueenSpawning::Update(double dt) {
 	}
 
 	m_go->spawnCooldown += (float)dt;
-	if (m_go->targetEnemy && m_go->targetEnemy->active) { PostOffice::GetInstance()->Send("Scene", new MessageQueenThreat(m_go, m_go->teamID)); m_go->sm->SetNextState("Emergency"); return; }
+	if (m_go->targetEnemy && m_go->targetEnemy->active) { PostOffice::GetInstance()->Send(g_alertChannel[m_go->teamID], MessagePool::GetInstance()->Create<MessageQueenThreat>(m_go, m_go->teamID)); m_go->sm->SetNextState("Emergency"); return; }
 	if (m_go->spawnCooldown > 3.f) {
 		m_go->spawnCooldown = 0.f;
-		int rng = Math::RandIntMinMax(0, 4);
+		int rng = CommandBuffer::RandInt(0, 4);
 		MessageSpawnUnit::UNIT_TYPE type;
 		if (m_go->teamID == 0) { switch (rng) { case 0: type = MessageSpawnUnit::UNIT_SPEEDY_ANT_WORKER; break; case 1: type = MessageSpawnUnit::UNIT_SPEEDY_ANT_SOLDIER; break; case 2: type = MessageSpawnUnit::UNIT_HEALER; break; case 3: type = MessageSpawnUnit::UNIT_SCOUT; break; case 4: type = MessageSpawnUnit::UNIT_TANK; break; default: type = MessageSpawnUnit::UNIT_SPEEDY_ANT_WORKER; break; } }
 													  else { switch (rng) { case 0: type = MessageSpawnUnit::UNIT_STRONG_ANT_WORKER; break; case 1: type = MessageSpawnUnit::UNIT_STRONG_ANT_SOLDIER; break; case 2: type = MessageSpawnUnit::UNIT_HEALER; break; case 3: type = MessageSpawnUnit::UNIT_SCOUT; break; case 4: type = MessageSpawnUnit::UNIT_TANK; break; default: type = MessageSpawnUnit::UNIT_STRONG_ANT_WORKER; break; } }
-													  PostOffice::GetInstance()->Send("Scene", new MessageSpawnUnit(m_go, type, m_go->pos));
+													  PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageSpawnUnit>(m_go, type, Pos(m_go)));
 													  m_go->unitsSpawned++;
 													  m_go->sm->SetNextState("Cooldown");
 	}
@@ -219,9 +227,9 @@ void StateQueenSpawning::Exit() {}
 StateQueenEmergency::StateQueenEmergency(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
 StateQueenEmergency::~StateQueenEmergency() {}
 void StateQueenEmergency::Enter() {
-	m_go->moveSpeed = 0.f;
+	SetSpeed(m_go, 0.f);
 	MessageSpawnUnit::UNIT_TYPE type = (m_go->teamID == 0) ? MessageSpawnUnit::UNIT_SPEEDY_ANT_SOLDIER : MessageSpawnUnit::UNIT_STRONG_ANT_SOLDIER;
-	for (int i = 0; i < 3; ++i) PostOffice::GetInstance()->Send("Scene", new MessageSpawnUnit(m_go, type, m_go->pos));
+	for (int i = 0; i < 3; ++i) PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageSpawnUnit>(m_go, type, Pos(m_go)));
 }
 void StateQueenEmergency::Update(double dt) {
 	if (m_go->health < m_go->maxHealth * 0.2f) { m_go->sm->SetNextState("Fleeing"); return; } // Flee Check
@@ -242,31 +250,31 @@ void StateQueenCooldown::Exit() {}
 StateQueenFleeing::StateQueenFleeing(const std::string& stateID, GameObject* go) : State(stateID), m_go(go) {}
 StateQueenFleeing::~StateQueenFleeing() {}
 void StateQueenFleeing::Enter() {
-	m_go->moveSpeed = m_go->baseSpeed * 0.5f; // Slow movement
+	SetSpeed(m_go, m_go->baseSpeed * 0.5f); // Slow movement
 }
 void StateQueenFleeing::Update(double dt) {
 	// Simple flee logic: Move to own base (corner) or away from specific threat
 	// Since the Queen usually sits AT the base, fleeing implies running to the safest extreme corner 
 	// or kiting. Let's make her move to the absolute corner of her territory.
 	float max = SceneData::GetInstance()->GetGridSize() * SceneData::GetInstance()->GetNumGrid();
-	if (m_go->teamID == 0) m_go->target.Set(0, 0, 0); // Red Base Corner
-	else m_go->target.Set(max, max, 0); // Blue Base Corner
+	if (m_go->teamID == 0) SetTarget(m_go, Vector3(0, 0, 0)); // Red Base Corner
+	else SetTarget(m_go, Vector3(max, max, 0)); // Blue Base Corner
 
 	// Recover? If health restored (by Healers)
 	if (m_go->health > m_go->maxHealth * 0.5f) m_go->sm->SetNextState("Spawning");
 }
-void StateQueenFleeing::Exit() { m_go->moveSpeed = 0.f; }
+void StateQueenFleeing::Exit() { SetSpeed(m_go, 0.f); }
 
 
 // ================= SCOUT STATES =================
 void StateScoutPatrolling::Enter() {
-	m_go->moveSpeed = m_go->baseSpeed; timer = 5.f;
+	SetSpeed(m_go, m_go->baseSpeed); timer = 5.f;
 	m_go->targetFoodItem = nullptr;
 	m_go->targetResource.SetZero();
 }
 void StateScoutPatrolling::Update(double dt) {
 	timer += (float)dt;
-	MarkVisited(m_go->pos, m_go->teamID);
+	MarkVisited(Pos(m_go), m_go->teamID);
 
 	if (m_go->targetEnemy && m_go->targetEnemy->active && m_go->health < m_go->maxHealth * 0.4f) {
 		m_go->sm->SetNextState("ReturnToColony"); return;
@@ -276,76 +284,76 @@ void StateScoutPatrolling::Update(double dt) {
 	if (m_go->targetFoodItem && m_go->targetFoodItem->active) {
 		if (m_go->targetFoodItem->isMarked) { m_go->targetFoodItem = nullptr; }
 		else {
-			float distSq = (m_go->pos - m_go->targetFoodItem->pos).LengthSquared();
+			float distSq = (Pos(m_go) - Pos(m_go->targetFoodItem)).LengthSquared();
 			float reachSq = (SceneData::GetInstance()->GetGridSize() * 1.3f) * (SceneData::GetInstance()->GetGridSize() * 1.3f);
 
 			if (distSq < reachSq) {
-				m_go->targetFoodItem->isMarked = true;
-				PostOffice::GetInstance()->Send("Scene", new MessageSpawnUnit(m_go, MessageSpawnUnit::UNIT_PHEROMONE, m_go->pos));
+				CommandBuffer::MarkFood(m_go->targetFoodItem);
+				PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageSpawnUnit>(m_go, MessageSpawnUnit::UNIT_PHEROMONE, Pos(m_go)));
 				m_go->sm->SetNextState("ReturnToColony");
 				return;
 			}
-			else { m_go->target = m_go->targetFoodItem->pos; return; }
+			else { SetTarget(m_go, Pos(m_go->targetFoodItem)); return; }
 		}
 	}
-	if (timer > 2.f || (m_go->pos - m_go->target).LengthSquared() < 1.f) { m_go->target = GetRandomExplorationTarget(m_go->homeBase, m_go->teamID); timer = 0.f; }
+	if (timer > 2.f || (Pos(m_go) - Target(m_go)).LengthSquared() < 1.f) { SetTarget(m_go, GetRandomExplorationTarget(m_go->homeBase, m_go->teamID)); timer = 0.f; }
 }
 void StateScoutPatrolling::Exit() {}
 
 void StateScoutReturnToColony::Enter() {
-	m_go->moveSpeed = m_go->baseSpeed * 1.5f;
+	SetSpeed(m_go, m_go->baseSpeed * 1.5f);
 
 	// NEW: Initialize last trail position to current position
-	lastTrailPos = m_go->pos;
+	lastTrailPos = Pos(m_go);
 
-	if (m_go->targetEnemy) PostOffice::GetInstance()->Send("Scene", new MessageEnemySpotted(m_go, m_go->targetEnemy, m_go->teamID));
+	if (m_go->targetEnemy) PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageEnemySpotted>(m_go, m_go->targetEnemy, m_go->teamID));
 }
 void StateScoutReturnToColony::Update(double dt) {
-	m_go->target = m_go->homeBase;
+	SetTarget(m_go, m_go->homeBase);
 
 	// --- FIX: DISTANCE-BASED TRAIL LOGIC ---
 	if (m_go->targetFoodItem != nullptr) {
 		// Calculate distance squared from the last dropped pheromone
-		float distSq = (m_go->pos - lastTrailPos).LengthSquared();
+		float distSq = (Pos(m_go) - lastTrailPos).LengthSquared();
 
 		// Threshold: Drop a trail every 1.5 units (Adjust this value for smaller/larger gaps)
 		float trailSpacing = 1.5f;
 
 		if (distSq > trailSpacing * trailSpacing) {
-			PostOffice::GetInstance()->Send("Scene", new MessageSpawnUnit(m_go, MessageSpawnUnit::UNIT_PHEROMONE, m_go->pos));
-			lastTrailPos = m_go->pos; // Update the last drop position
+			PostOffice::GetInstance()->Send(g_sceneAddress, MessagePool::GetInstance()->Create<MessageSpawnUnit>(m_go, MessageSpawnUnit::UNIT_PHEROMONE, Pos(m_go)));
+			lastTrailPos = Pos(m_go); // Update the last drop position
 		}
 	}
 	// -----------------------------------
 
-	if ((m_go->pos - m_go->homeBase).LengthSquared() < 5.f) {
+	if ((Pos(m_go) - m_go->homeBase).LengthSquared() < 5.f) {
 		m_go->targetEnemy = nullptr;
 		m_go->sm->SetNextState("Patrolling");
 	}
 }
 void StateScoutReturnToColony::Exit() {}
 
-void StateScoutHiding::Enter() { m_go->moveSpeed = m_go->baseSpeed; timer = 0.f; float max = SceneData::GetInstance()->GetGridSize() * SceneData::GetInstance()->GetNumGrid(); if (m_go->teamID == 0) m_go->target.Set(0, max, 0); else m_go->target.Set(max, 0, 0); }
+void StateScoutHiding::Enter() { SetSpeed(m_go, m_go->baseSpeed); timer = 0.f; float max = SceneData::GetInstance()->GetGridSize() * SceneData::GetInstance()->GetNumGrid(); if (m_go->teamID == 0) SetTarget(m_go, Vector3(0, max, 0)); else SetTarget(m_go, Vector3(max, 0, 0)); }
 void StateScoutHiding::Update(double dt) { timer += (float)dt; if (timer > 5.f) m_go->sm->SetNextState("Patrolling"); }
 void StateScoutHiding::Exit() {}
 
 // ================= HEALER / TANK (Unchanged or Minor Tweak for Recovery) =================
 // Note: StateTankRecovering needs similar check to SoldierResting
-void StateTankRecovering::Enter() { m_go->moveSpeed = m_go->baseSpeed; m_go->target = m_go->homeBase; }
+void StateTankRecovering::Enter() { SetSpeed(m_go, m_go->baseSpeed); SetTarget(m_go, m_go->homeBase); }
 void StateTankRecovering::Update(double dt) {
 	// Conditional Healing Check for Tank
 	bool baseIsSafe = true;
 	if (m_go->targetEnemy && m_go->targetEnemy->active) {
-		if ((m_go->targetEnemy->pos - m_go->homeBase).LengthSquared() < 100.f) baseIsSafe = false;
+		if ((Pos(m_go->targetEnemy) - m_go->homeBase).LengthSquared() < 100.f) baseIsSafe = false;
 	}
-	if (baseIsSafe) m_go->health += (float)dt * 2.0f;
+	if (baseIsSafe) CommandBuffer::AdjustHealth(m_go, (float)dt * 2.0f);
 
-	if (m_go->health >= m_go->maxHealth) { m_go->health = m_go->maxHealth; m_go->sm->SetNextState("Guarding"); }
+	if (m_go->health >= m_go->maxHealth) { CommandBuffer::AdjustHealth(m_go, 0.f, m_go->maxHealth); m_go->sm->SetNextState("Guarding"); }
 }
 void StateTankRecovering::Exit() {}
 
 // [Keep the rest of the Tank/Healer states as provided in original]
-void StateHealerIdle::Enter() { m_go->moveSpeed = 0.f; }
+void StateHealerIdle::Enter() { SetSpeed(m_go, 0.f); }
 void StateHealerIdle::Update(double dt) {
 	// If we have ANY target (Injured OR Follow target), start moving
 	if (m_go->targetAlly && m_go->targetAlly->active) {
@@ -353,7 +361,7 @@ void StateHealerIdle::Update(double dt) {
 	}
 }
 void StateHealerIdle::Exit() {}
-void StateHealerTraveling::Enter() { m_go->moveSpeed = m_go->baseSpeed; }
+void StateHealerTraveling::Enter() { SetSpeed(m_go, m_go->baseSpeed); }
 void StateHealerTraveling::Update(double dt) {
 	if (!m_go->targetAlly || !m_go->targetAlly->active) {
 		m_go->targetAlly = nullptr;
@@ -361,8 +369,8 @@ void StateHealerTraveling::Update(double dt) {
 		return;
 	}
 
-	m_go->target = m_go->targetAlly->pos;
-	float distSq = (m_go->pos - m_go->target).LengthSquared();
+	SetTarget(m_go, Pos(m_go->targetAlly));
+	float distSq = (Pos(m_go) - Target(m_go)).LengthSquared();
 	float gridSize = SceneData::GetInstance()->GetGridSize();
 
 	// CASE 1: Target is INJURED -> Go close and Heal
@@ -377,18 +385,18 @@ void StateHealerTraveling::Update(double dt) {
 
 		// If too close, stop moving (don't crowd)
 		if (distSq < followDistSq) {
-			m_go->moveSpeed = 0.f;
+			SetSpeed(m_go, 0.f);
 		}
 		// If falling behind, resume speed
 		else {
-			m_go->moveSpeed = m_go->baseSpeed;
+			SetSpeed(m_go, m_go->baseSpeed);
 		}
 
 		// Do NOT switch to "Healing" state
 	}
 }
 void StateHealerTraveling::Exit() {}
-void StateHealerHealing::Enter() { m_go->moveSpeed = 0.f; timer = 0.f; }
+void StateHealerHealing::Enter() { SetSpeed(m_go, 0.f); timer = 0.f; }
 void StateHealerHealing::Update(double dt) {
 	timer += (float)dt;
 	if (!m_go->targetAlly || !m_go->targetAlly->active) {
@@ -397,18 +405,18 @@ void StateHealerHealing::Update(double dt) {
 
 	// If target becomes fully healed, switch back to Idle/Traveling to follow
 	if (m_go->targetAlly->health >= m_go->targetAlly->maxHealth) {
-		m_go->targetAlly->health = m_go->targetAlly->maxHealth;
+		CommandBuffer::AdjustHealth(m_go->targetAlly, 0.f, m_go->targetAlly->maxHealth);
 		// Don't clear targetAlly here, so we can transition to following them immediately
 		m_go->sm->SetNextState("Traveling");
 		return;
 	}
 
-	m_go->targetAlly->health += (float)dt * 1.0f;
+	CommandBuffer::AdjustHealth(m_go->targetAlly, (float)dt * 1.0f);
 }
 void StateHealerHealing::Exit() {}
-void StateTankGuarding::Enter() { m_go->moveSpeed = m_go->baseSpeed; }
-void StateTankGuarding::Update(double dt) { m_go->target = m_go->homeBase; if (m_go->targetEnemy && m_go->targetEnemy->active) { if ((m_go->pos - m_go->targetEnemy->pos).LengthSquared() < m_go->attackRange * m_go->attackRange) m_go->sm->SetNextState("Blocking"); } if (m_go->health < m_go->maxHealth * 0.4f) m_go->sm->SetNextState("Recovering"); }
+void StateTankGuarding::Enter() { SetSpeed(m_go, m_go->baseSpeed); }
+void StateTankGuarding::Update(double dt) { SetTarget(m_go, m_go->homeBase); if (m_go->targetEnemy && m_go->targetEnemy->active) { if ((Pos(m_go) - Pos(m_go->targetEnemy)).LengthSquared() < m_go->attackRange * m_go->attackRange) m_go->sm->SetNextState("Blocking"); } if (m_go->health < m_go->maxHealth * 0.4f) m_go->sm->SetNextState("Recovering"); }
 void StateTankGuarding::Exit() {}
-void StateTankBlocking::Enter() { m_go->moveSpeed = 0.f; attackTimer = 0.f; }
-void StateTankBlocking::Update(double dt) { if (!m_go->targetEnemy || !m_go->targetEnemy->active || (m_go->pos - m_go->targetEnemy->pos).LengthSquared() > m_go->attackRange * m_go->attackRange * 1.5f) { m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Guarding"); return; } attackTimer += (float)dt; if (attackTimer > 1.5f) { m_go->targetEnemy->health -= m_go->attackPower; attackTimer = 0.f; if (m_go->targetEnemy->health <= 0) { PostOffice::GetInstance()->Send("Scene", new MessageUnitDied(m_go->targetEnemy, m_go->targetEnemy->teamID, m_go->targetEnemy->type)); m_go->targetEnemy->active = false; } } if (m_go->health < m_go->maxHealth * 0.3f) m_go->sm->SetNextState("Recovering"); }
+void StateTankBlocking::Enter() { SetSpeed(m_go, 0.f); attackTimer = 0.f; }
+void StateTankBlocking::Update(double dt) { if (!m_go->targetEnemy || !m_go->targetEnemy->active || (Pos(m_go) - Pos(m_go->targetEnemy)).LengthSquared() > m_go->attackRange * m_go->attackRange * 1.5f) { m_go->targetEnemy = nullptr; m_go->sm->SetNextState("Guarding"); return; } attackTimer += (float)dt; if (attackTimer > 1.5f) { CommandBuffer::Damage(m_go->targetEnemy, m_go->attackPower); attackTimer = 0.f; } if (m_go->health < m_go->maxHealth * 0.3f) m_go->sm->SetNextState("Recovering"); }
 void StateTankBlocking::Exit() {}
\ No newline at end of file
@@ -5,10 +5,13 @@
 #include "Vector3.h"
 #include "Maze.h"
 void ResetGlobalSandboxVars();
+int GetExploredCellCount(int teamID); // grid cells the team has walked over
+AddressHandle GetTeamAlertChannel(int teamID); // the team's soldiers and tanks subscribe, MessageQueenThreat goes here
 // ================= WORKER STATES =================
 class StateWorkerIdle : public State
 {
 	GameObject* m_go;
+	float timer;
 public:
 	StateWorkerIdle(const std::string& stateID, GameObject* go);
 	virtual ~StateWorkerIdle();
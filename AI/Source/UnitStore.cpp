@@ -0,0 +1,282 @@
+#include "UnitStore.h"
+#include <cmath>
+#include <cstring>
+#ifdef UNIT_STORE_SSE
+#include <emmintrin.h>
+#endif
+
+UnitStore::UnitStore()
+{
+}
+
+UnitStore::~UnitStore()
+{
+}
+
+void UnitStore::Clear()
+{
+	posX.clear(); posY.clear();
+	viewX.clear(); viewY.clear();
+	targetX.clear(); targetY.clear();
+	speed.clear();
+	wayX.clear(); wayY.clear();
+	pathNext.clear();
+	prevX.clear(); prevY.clear();
+	idle.clear();
+	flags.clear();
+}
+
+void UnitStore::Add(const GameObject* go)
+{
+	int i = GetSlot(go);
+	if (i >= GetCount())
+	{
+		//as GameObject's constructor
+		size_t count = i + 1;
+		posX.resize(count, 0.f); posY.resize(count, 0.f);
+		viewX.resize(count, 1.f); viewY.resize(count, 0.f);
+		targetX.resize(count, 0.f); targetY.resize(count, 0.f);
+		speed.resize(count, 1.f);
+		wayX.resize(count, 0.f); wayY.resize(count, 0.f);
+		pathNext.resize(count, 0);
+		prevX.resize(count, 0.f); prevY.resize(count, 0.f);
+		idle.resize(count, 0.f);
+		flags.resize(count, 0);
+	}
+	flags[i] = FLAG_ACTIVE;
+}
+
+void UnitStore::Remove(const GameObject* go)
+{
+	int i = GetSlot(go);
+	if (i < GetCount())
+		flags[i] = 0;
+}
+
+int UnitStore::GetCount() const
+{
+	return static_cast<int>(flags.size());
+}
+
+void UnitStore::UpdateIdle(float dt, float limit)
+{
+	UpdateIdle(0, GetCount(), dt, limit);
+}
+
+void UnitStore::UpdateIdleScalar(float dt, float limit)
+{
+	UpdateIdleRange(0, GetCount(), dt, limit);
+}
+
+void UnitStore::Integrate(float dt, float timeScale)
+{
+	Integrate(0, GetCount(), dt, timeScale);
+}
+
+void UnitStore::IntegrateScalar(float dt, float timeScale)
+{
+	IntegrateRange(0, GetCount(), dt, timeScale);
+}
+
+void UnitStore::UpdateIdleRange(int begin, int end, float dt, float limit)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		unsigned char f = static_cast<unsigned char>(flags[i] & ~FLAG_STUCK);
+		flags[i] = f;
+		if (!(f & FLAG_ACTIVE) || !(speed[i] > 0.f))
+			continue;
+		float dx = posX[i] - prevX[i];
+		float dy = posY[i] - prevY[i];
+		if (dx * dx + dy * dy < 0.001f)
+		{
+			idle[i] += dt;
+			if (idle[i] > limit)
+			{
+				idle[i] = 0.f;
+				flags[i] = static_cast<unsigned char>(f | FLAG_STUCK);
+			}
+		}
+		else
+		{
+			idle[i] = 0.f;
+		}
+		prevX[i] = posX[i];
+		prevY[i] = posY[i];
+	}
+}
+
+void UnitStore::IntegrateRange(int begin, int end, float dt, float timeScale)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		unsigned char f = static_cast<unsigned char>(flags[i] & ~FLAG_ARRIVED);
+		flags[i] = f;
+		if (!(f & FLAG_MOVING) || !(speed[i] > 0.f))
+			continue;
+		float step = speed[i] * dt * timeScale;
+		float dx = wayX[i] - posX[i];
+		float dy = wayY[i] - posY[i];
+		float distSq = dx * dx + dy * dy;
+		//a unit already (nearly) at its cell centre stays put
+		if (!(f & FLAG_WAYPOINT) && distSq <= 0.001f)
+			continue;
+		float dist = std::sqrt(distSq);
+		if (dist <= step)
+		{
+			posX[i] = wayX[i];
+			posY[i] = wayY[i];
+			flags[i] = static_cast<unsigned char>((f & ~FLAG_MOVING) | FLAG_ARRIVED);
+			if (f & FLAG_WAYPOINT)
+				++pathNext[i];
+		}
+		else
+		{
+			posX[i] += dx / dist * step;
+			posY[i] += dy / dist * step;
+		}
+		if (distSq > 0.001f)
+		{
+			viewX[i] = dx / dist;
+			viewY[i] = dy / dist;
+		}
+	}
+}
+
+#ifdef UNIT_STORE_SSE
+namespace
+{
+	//four flag bytes as one 32-bit lane each
+	inline __m128i LoadFlags(const unsigned char* flags)
+	{
+		int packed;
+		memcpy(&packed, flags, sizeof(int));
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+	}
+
+	inline void StoreFlags(unsigned char* flags, __m128i lanes)
+	{
+		__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(lanes, lanes), lanes);
+		int packed = _mm_cvtsi128_si32(bytes);
+		memcpy(flags, &packed, sizeof(int));
+	}
+
+	inline __m128 HasFlag(__m128i lanes, int flag)
+	{
+		const __m128i bit = _mm_set1_epi32(flag);
+		return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(lanes, bit), bit));
+	}
+
+	inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+}
+
+//same arithmetic as UpdateIdleRange in the same order, with the branches turned into lane masks
+void UnitStore::UpdateIdle(int begin, int end, float dt, float limit)
+{
+	const int vectorEnd = begin + ((end - begin) & ~3);
+	const __m128 threshold = _mm_set1_ps(0.001f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 step = _mm_set1_ps(dt);
+	const __m128 limits = _mm_set1_ps(limit);
+	const __m128i stuckBit = _mm_set1_epi32(FLAG_STUCK);
+	float* px = posX.data(); float* py = posY.data();
+	float* qx = prevX.data(); float* qy = prevY.data();
+	float* timer = idle.data();
+	const float* sp = speed.data();
+	unsigned char* fl = flags.data();
+
+	for (int i = begin; i < vectorEnd; i += 4)
+	{
+		__m128i laneFlags = _mm_andnot_si128(stuckBit, LoadFlags(fl + i));
+		__m128 x = _mm_loadu_ps(px + i); __m128 y = _mm_loadu_ps(py + i);
+		__m128 lastX = _mm_loadu_ps(qx + i); __m128 lastY = _mm_loadu_ps(qy + i);
+		__m128 t = _mm_loadu_ps(timer + i);
+		__m128 live = _mm_and_ps(HasFlag(laneFlags, FLAG_ACTIVE), _mm_cmpgt_ps(_mm_loadu_ps(sp + i), zero));
+
+		__m128 dx = _mm_sub_ps(x, lastX);
+		__m128 dy = _mm_sub_ps(y, lastY);
+		__m128 still = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), threshold);
+		__m128 waited = _mm_add_ps(t, step);
+		__m128 stuck = _mm_and_ps(still, _mm_cmpgt_ps(waited, limits));
+		__m128 idleTime = _mm_andnot_ps(stuck, _mm_and_ps(still, waited)); //0 if it moved or got stuck
+
+		_mm_storeu_ps(timer + i, Select(live, idleTime, t));
+		_mm_storeu_ps(qx + i, Select(live, x, lastX));
+		_mm_storeu_ps(qy + i, Select(live, y, lastY));
+		stuck = _mm_and_ps(live, stuck);
+		StoreFlags(fl + i, _mm_or_si128(laneFlags, _mm_and_si128(_mm_castps_si128(stuck), stuckBit)));
+	}
+	UpdateIdleRange(vectorEnd, end, dt, limit);
+}
+
+//same arithmetic as IntegrateRange in the same order (sqrt and divide are exact in SSE), with the
+//branches turned into lane masks. lanes that do not move may divide by zero, their results are masked out
+void UnitStore::Integrate(int begin, int end, float dt, float timeScale)
+{
+	const int vectorEnd = begin + ((end - begin) & ~3);
+	const __m128 threshold = _mm_set1_ps(0.001f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 delta = _mm_set1_ps(dt);
+	const __m128 scale = _mm_set1_ps(timeScale);
+	const __m128i movingBit = _mm_set1_epi32(FLAG_MOVING);
+	const __m128i arrivedBit = _mm_set1_epi32(FLAG_ARRIVED);
+	float* px = posX.data(); float* py = posY.data();
+	float* vx = viewX.data(); float* vy = viewY.data();
+	const float* wx = wayX.data(); const float* wy = wayY.data();
+	const float* sp = speed.data();
+	int* next = pathNext.data();
+	unsigned char* fl = flags.data();
+
+	for (int i = begin; i < vectorEnd; i += 4)
+	{
+		__m128i laneFlags = _mm_andnot_si128(arrivedBit, LoadFlags(fl + i));
+		__m128 laneSpeed = _mm_loadu_ps(sp + i);
+		__m128 queued = _mm_and_ps(HasFlag(laneFlags, FLAG_MOVING), _mm_cmpgt_ps(laneSpeed, zero));
+		__m128 onPath = HasFlag(laneFlags, FLAG_WAYPOINT);
+		__m128 x = _mm_loadu_ps(px + i); __m128 y = _mm_loadu_ps(py + i);
+		__m128 tx = _mm_loadu_ps(wx + i); __m128 ty = _mm_loadu_ps(wy + i);
+		__m128 s = _mm_mul_ps(_mm_mul_ps(laneSpeed, delta), scale);
+
+		__m128 dx = _mm_sub_ps(tx, x);
+		__m128 dy = _mm_sub_ps(ty, y);
+		__m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 turned = _mm_and_ps(queued, _mm_cmpgt_ps(distSq, threshold));
+		__m128 moving = _mm_or_ps(_mm_and_ps(queued, onPath), turned);
+		__m128 dist = _mm_sqrt_ps(distSq);
+		__m128 arrived = _mm_and_ps(moving, _mm_cmple_ps(dist, s));
+		__m128 stepping = _mm_andnot_ps(arrived, moving);
+		__m128 dirX = _mm_div_ps(dx, dist);
+		__m128 dirY = _mm_div_ps(dy, dist);
+
+		x = Select(arrived, tx, Select(stepping, _mm_add_ps(x, _mm_mul_ps(dirX, s)), x));
+		y = Select(arrived, ty, Select(stepping, _mm_add_ps(y, _mm_mul_ps(dirY, s)), y));
+		_mm_storeu_ps(px + i, x);
+		_mm_storeu_ps(py + i, y);
+		_mm_storeu_ps(vx + i, Select(turned, dirX, _mm_loadu_ps(vx + i)));
+		_mm_storeu_ps(vy + i, Select(turned, dirY, _mm_loadu_ps(vy + i)));
+
+		//the masks are all ones (-1) where set: subtracting the arrivals on a path moves their cursor on
+		__m128i pathArrived = _mm_castps_si128(_mm_and_ps(arrived, onPath));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(next + i), _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(next + i)), pathArrived));
+		//arrivals stop moving and are flagged
+		__m128i arrivals = _mm_castps_si128(arrived);
+		laneFlags = _mm_andnot_si128(_mm_and_si128(arrivals, movingBit), laneFlags);
+		StoreFlags(fl + i, _mm_or_si128(laneFlags, _mm_and_si128(arrivals, arrivedBit)));
+	}
+	IntegrateRange(vectorEnd, end, dt, timeScale);
+}
+#else
+void UnitStore::UpdateIdle(int begin, int end, float dt, float limit)
+{
+	UpdateIdleRange(begin, end, dt, limit);
+}
+
+void UnitStore::Integrate(int begin, int end, float dt, float timeScale)
+{
+	IntegrateRange(begin, end, dt, timeScale);
+}
+#endif
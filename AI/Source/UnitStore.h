@@ -0,0 +1,91 @@
+#ifndef UNIT_STORE_H
+#define UNIT_STORE_H
+
+#include <vector>
+#include "GameObject.h"
+
+//SSE2 is part of every x64 target (and of /arch:SSE2 x86 builds)
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define UNIT_STORE_SSE 1
+#endif
+
+//structure-of-arrays transform and movement data for the sandbox's objects, owned by the scene
+//entry i belongs to the object in registry slot i (handle & GameObjectRegistry::INDEX_MASK), so a unit's
+//data is found straight from its handle and stays put for as long as the object lives, recycled or not.
+//these arrays are the only copy: in the sandbox the GameObject's pos, target, moveSpeed, viewDir, prevPos and
+//idleTimer are unused, and go->path is followed from pathNext on rather than consumed from the front.
+//the pool keeps the entries of the objects it hands out (GameObjectPool::SetUnitStore), and the movement
+//kernels run over every entry, four at a time with SSE where available; entries that are not in play are masked out
+struct UnitStore
+{
+	enum FLAG
+	{
+		FLAG_ACTIVE = 1,   //handed out by the pool and not yet released
+		FLAG_MOVING = 2,   //heading for (wayX, wayY), see Queue. Integrate clears it on arrival
+		FLAG_WAYPOINT = 4, //heading for go->path[pathNext], otherwise re-centring in the current cell
+		FLAG_ARRIVED = 8,  //set by Integrate: reached the waypoint this step (and moved pathNext on), cleared by the next
+		FLAG_STUCK = 16,   //set by UpdateIdle: idle for too long, the timer has started again
+	};
+
+	UnitStore();
+	~UnitStore();
+
+	void Clear(); //drop all entries
+	//the pool handed go out: make sure it has an entry and mark it active. new entries start with the
+	//GameObject defaults, a recycled object keeps the values of its previous life as its fields would
+	void Add(const GameObject* go);
+	void Remove(const GameObject* go); //the pool took go back
+	int GetCount() const; //entries, one past the highest slot added
+
+	static int GetSlot(const GameObject* go) { return static_cast<int>(go->handle & GameObjectRegistry::INDEX_MASK); }
+	Vector3 GetPos(const GameObject* go) const { int i = GetSlot(go); return Vector3(posX[i], posY[i], 0.f); }
+	void SetPos(const GameObject* go, const Vector3& pos) { int i = GetSlot(go); posX[i] = pos.x; posY[i] = pos.y; }
+	Vector3 GetTarget(const GameObject* go) const { int i = GetSlot(go); return Vector3(targetX[i], targetY[i], 0.f); }
+	void SetTarget(const GameObject* go, const Vector3& target) { int i = GetSlot(go); targetX[i] = target.x; targetY[i] = target.y; }
+	float GetSpeed(const GameObject* go) const { return speed[GetSlot(go)]; }
+	void SetSpeed(const GameObject* go, float moveSpeed) { speed[GetSlot(go)] = moveSpeed; }
+	Vector3 GetViewDir(const GameObject* go) const { int i = GetSlot(go); return Vector3(viewX[i], viewY[i], 0.f); }
+	//go->path has been replaced, follow it from the start
+	void StartPath(const GameObject* go) { pathNext[GetSlot(go)] = 0; }
+	bool HasPath(const GameObject* go) const { return pathNext[GetSlot(go)] < static_cast<int>(go->path.size()); }
+	//send entry i towards (x, y), a path point or the centre of its cell. it stays queued until it gets there,
+	//so only the entries that arrived or got stuck need a new waypoint (queueing the same one again is harmless)
+	void Queue(int i, float x, float y, bool waypoint)
+	{
+		wayX[i] = x; wayY[i] = y;
+		flags[i] = static_cast<unsigned char>((flags[i] & FLAG_ACTIVE) | FLAG_MOVING | (waypoint ? FLAG_WAYPOINT : 0));
+	}
+
+	//stuck timers of the active entries with a speed: one that has not moved since the last call gathers dt,
+	//past limit it gets FLAG_STUCK and its timer starts again; either way its position is remembered
+	//SSE where available, bit-identical to UpdateIdleScalar
+	void UpdateIdle(float dt, float limit);
+	void UpdateIdle(int begin, int end, float dt, float limit); //entries [begin, end) only, disjoint ranges can run on different threads
+	void UpdateIdleScalar(float dt, float limit); //reference version, one entry at a time
+
+	//step every queued entry with a speed (speed * dt * timeScale) towards its waypoint: arrive if it is within the step,
+	//otherwise move the step along the way, and face the way it went. arriving at a path point moves pathNext on.
+	//SSE where available, bit-identical to IntegrateScalar
+	void Integrate(float dt, float timeScale);
+	void Integrate(int begin, int end, float dt, float timeScale); //entries [begin, end) only, as UpdateIdle
+	void IntegrateScalar(float dt, float timeScale); //reference version, one entry at a time
+
+	//transform
+	std::vector<float> posX, posY;
+	std::vector<float> viewX, viewY;
+	//movement
+	std::vector<float> targetX, targetY;
+	std::vector<float> speed;
+	std::vector<float> wayX, wayY; //current waypoint, see Queue
+	std::vector<int> pathNext;     //index in go->path of the next path point
+	//stuck detection
+	std::vector<float> prevX, prevY;
+	std::vector<float> idle;
+	std::vector<unsigned char> flags;
+
+private:
+	void UpdateIdleRange(int begin, int end, float dt, float limit);
+	void IntegrateRange(int begin, int end, float dt, float timeScale);
+};
+
+#endif
@@ -1,9 +1,55 @@
 #include "Application.h"
+#include "Benchmarks.h"
+#include <string>
+#include <cstdlib>
 
-int main( void )
+// a number is a grid size for the built-in layout, anything else a TGA map mask
+static void SetMap(Application& app, const std::string& map)
+{
+	if (!map.empty() && map.find_first_not_of("0123456789") == std::string::npos)
+		app.SetMap(atoi(map.c_str()));
+	else
+		app.SetMap(30, map);
+}
+
+int main(int argc, char* argv[])
 {
 	// Get the instance for Application class
 	Application &app = Application::GetInstance();
+	// Headless batch run of Assignment 1: AI.exe -headless [seed] [matches] [maxTime] [poolReserve] [threads] [buffered|deferred|buffered+deferred|-] [gridSize|map.tga]
+	if (argc > 1 && std::string(argv[1]) == "-headless")
+	{
+		unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 1;
+		int matches = (argc > 3) ? atoi(argv[3]) : 1;
+		float maxTime = (argc > 4) ? (float)atof(argv[4]) : 240.f;
+		int poolReserve = (argc > 5) ? atoi(argv[5]) : 24;
+		int threads = (argc > 6) ? atoi(argv[6]) : 0;
+		std::string mode = (argc > 7) ? argv[7] : "-";
+		bool buffered = mode.find("buffered") != std::string::npos;
+		bool deferred = mode.find("deferred") != std::string::npos;
+		app.SetHeadless(seed, matches, maxTime, poolReserve, threads, buffered, deferred);
+		if (argc > 8)
+			SetMap(app, argv[8]);
+		app.Init();
+		app.Run();
+		app.Exit();
+		return 0;
+	}
+	// Console benchmarks: AI.exe -bench [path|units [threads]|messages]
+	if (argc > 1 && std::string(argv[1]) == "-bench")
+	{
+		std::string name = (argc > 2) ? argv[2] : "path";
+		if (name == "path")
+			RunPathfinderBenchmark();
+		else if (name == "units")
+			RunUnitLayoutBenchmark((argc > 3) ? atoi(argv[3]) : 0);
+		else if (name == "messages")
+			RunMessageBenchmark();
+		return 0;
+	}
+	// Sandbox layout for the windowed scenes: AI.exe -map [gridSize|map.tga]
+	if (argc > 2 && std::string(argv[1]) == "-map")
+		SetMap(app, argv[2]);
 	// Load the scene based on user's selection
 	if (app.LoadScene() == true)	// If the user selected a valid scene
 	{